@@ -0,0 +1,8 @@
+// example/bench/fib.js
+// Node twin of fib.oo.
+
+function fib(n) {
+  return n < 2 ? n : fib(n - 1) + fib(n - 2);
+}
+
+console.log("fib", fib(32));
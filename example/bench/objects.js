@@ -0,0 +1,14 @@
+// example/bench/objects.js
+// Node twin of objects.oo.
+
+const config = { limit: 20000000, scale: 0.5, step: { by: 3 } };
+
+function score(n) {
+  let t = 0;
+  for (let i = 0; i < n; i += config.step.by) {
+    t += (i % 7) * config.scale;
+  }
+  return t;
+}
+
+console.log("score", score(config.limit));
@@ -0,0 +1,8 @@
+// example/bench/strings.js
+// Node twin of strings.oo.
+
+const tag = { kind: "row", ok: true, size: 3 };
+
+for (let i = 0; i < 200000; i++) {
+  console.log("row", i, i / 8, tag.kind, tag);
+}
@@ -0,0 +1,42 @@
+// Embedding oong through liboong (see src/engine.h): one Engine compiles a
+// script from a string, runs its top-level code and calls one of its
+// functions, then compiles and runs many small scripts to show the per-script
+// cost once LLVM and the JIT are set up.
+//
+// Build: cmake --build build --target oong_embed_example
+#include <chrono>
+#include <iostream>
+#include <string>
+#include "engine.h"
+
+int main(int argc, char **argv) {
+  int count = argc > 1 ? std::stoi(argv[1]) : 1000;
+  std::string error;
+  auto start = std::chrono::steady_clock::now();
+  std::unique_ptr<Engine> engine = Engine::create(EngineOptions{}, error);
+  if (!engine) { std::cerr << error << "\n"; return 1; }
+  auto ready = std::chrono::steady_clock::now();
+
+  const char *source = "function fib(n) { return n < 2 ? n : fib(n - 1) + fib(n - 2); }\n"
+                       "print(\"fib ready\");\n";
+  std::unique_ptr<Script> script = engine->compile(source, error);
+  if (!script) { std::cerr << error << "\n"; return 1; }
+  script->run();
+  double result;
+  if (!script->call("fib", {20}, result, error)) { std::cerr << error << "\n"; return 1; }
+  std::cout << "fib(20) = " << result << "\n";
+
+  auto batch = std::chrono::steady_clock::now();
+  double sum = 0;
+  for (int i = 0; i < count; ++i) {
+    std::string small = "function f(x) { return x * " + std::to_string(i) + " + 1; }\n";
+    std::unique_ptr<Script> s = engine->compile(small, error);
+    if (!s || !s->call("f", {2}, result, error)) { std::cerr << error << "\n"; return 1; }
+    sum += result;
+  }
+  auto done = std::chrono::steady_clock::now();
+  auto ms = [](auto d) { return std::chrono::duration<double, std::milli>(d).count(); };
+  std::cout << "engine setup " << ms(ready - start) << " ms; " << count << " scripts in " << ms(done - batch)
+            << " ms (" << ms(done - batch) / count << " ms each), checksum " << sum << "\n";
+  return 0;
+}
@@ -0,0 +1,96 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <new>
+#include <string_view>
+#include <type_traits>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+// Bump allocator for objects that share one lifetime (e.g. every AST node of a
+// compilation). Memory is carved out of large blocks and released all at once
+// when the arena is destroyed; individual objects are never freed, so only
+// trivially destructible types may be placed in it.
+class Arena {
+public:
+  explicit Arena(size_t blockSize = 64 * 1024) : BlockSize(blockSize) {}
+  Arena(const Arena &) = delete;
+  Arena &operator=(const Arena &) = delete;
+
+  void *allocate(size_t size, size_t align) {
+    size_t p = (reinterpret_cast<uintptr_t>(Cur) + align - 1) & ~(uintptr_t)(align - 1);
+    if (!Cur || p + size > reinterpret_cast<uintptr_t>(End)) {
+      // oversized requests get a block of their own so the current one is kept
+      size_t want = size + align;
+      if (want > BlockSize / 4) {
+        Blocks.emplace_back(new char[want]);
+        Allocated += want;
+        uintptr_t b = reinterpret_cast<uintptr_t>(Blocks.back().get());
+        return reinterpret_cast<void *>((b + align - 1) & ~(uintptr_t)(align - 1));
+      }
+      Blocks.emplace_back(new char[BlockSize]);
+      Allocated += BlockSize;
+      Cur = Blocks.back().get();
+      End = Cur + BlockSize;
+      p = (reinterpret_cast<uintptr_t>(Cur) + align - 1) & ~(uintptr_t)(align - 1);
+    }
+    Cur = reinterpret_cast<char *>(p + size);
+    return reinterpret_cast<void *>(p);
+  }
+
+  template <typename T, typename... Args>
+  T *make(Args &&...args) {
+    static_assert(std::is_trivially_destructible<T>::value,
+                  "arena objects are never destroyed");
+    return new (allocate(sizeof(T), alignof(T))) T(std::forward<Args>(args)...);
+  }
+
+  // Copy `items` into arena storage.
+  template <typename T>
+  T *copyArray(const T *items, size_t count) {
+    static_assert(std::is_trivially_copyable<T>::value, "arena arrays are copied bytewise");
+    if (count == 0)
+      return nullptr;
+    T *out = static_cast<T *>(allocate(sizeof(T) * count, alignof(T)));
+    std::memcpy(out, items, sizeof(T) * count);
+    return out;
+  }
+
+  std::string_view copyString(std::string_view s) {
+    if (s.empty())
+      return {};
+    char *out = static_cast<char *>(allocate(s.size(), 1));
+    std::memcpy(out, s.data(), s.size());
+    return {out, s.size()};
+  }
+
+  // Bytes reserved from the system so far.
+  size_t bytesAllocated() const { return Allocated; }
+
+private:
+  size_t BlockSize;
+  std::vector<std::unique_ptr<char[]>> Blocks;
+  char *Cur = nullptr;
+  char *End = nullptr;
+  size_t Allocated = 0;
+};
+
+// Interns strings into an Arena: equal strings map to the same storage, so an
+// interned name can be compared and hashed by its data pointer.
+class StringInterner {
+public:
+  explicit StringInterner(Arena &a) : A(a) {}
+  std::string_view intern(std::string_view s) {
+    auto it = Names.find(s);
+    if (it != Names.end())
+      return *it;
+    return *Names.insert(A.copyString(s)).first;
+  }
+
+private:
+  Arena &A;
+  std::unordered_set<std::string_view> Names;
+};
@@ -3,15 +3,20 @@
 
 std::string stmtToString(const Stmt* s) {
   if (!s) return "<null>";
-  if (auto p = dynamic_cast<const PrintStmt*>(s)) {
+  if (auto p = ast_cast<PrintStmt>(s)) {
     std::ostringstream os;
     os << "Print(";
     for (size_t i = 0; i < p->args.size(); ++i) {
       if (i) os << ", ";
-      if (auto lit = dynamic_cast<LiteralExpr*>(p->args[i].get())) {
+      if (auto lit = ast_cast<LiteralExpr>(p->args[i])) {
         os << lit->value;
-      } else if (auto call = dynamic_cast<CallExpr*>(p->args[i].get())) {
-        os << call->callee << "()";
+      } else if (auto id = ast_cast<IdentifierExpr>(p->args[i])) {
+        os << id->name;
+      } else if (auto call = ast_cast<CallExpr>(p->args[i])) {
+        if (auto callee = ast_cast<IdentifierExpr>(call->callee))
+          os << callee->name << "()";
+        else
+          os << "<call>()";
       } else {
         os << "<expr>";
       }
@@ -62,3 +67,33 @@ std::string typeToString(const Type* t) {
   }
   return "<unknown-type>";
 }
+
+std::unique_ptr<Type> cloneType(const Type* t) {
+  if (!t) return nullptr;
+  if (auto n = dynamic_cast<const NamedType*>(t)) {
+    return std::make_unique<NamedType>(n->Name);
+  }
+  if (auto g = dynamic_cast<const GenericType*>(t)) {
+    auto out = std::make_unique<GenericType>();
+    out->Base = cloneType(g->Base.get());
+    for (auto &a : g->Args) out->Args.push_back(cloneType(a.get()));
+    return out;
+  }
+  if (auto a = dynamic_cast<const ArrayType*>(t)) {
+    return std::make_unique<ArrayType>(cloneType(a->Element.get()));
+  }
+  if (auto u = dynamic_cast<const UnionType*>(t)) {
+    auto out = std::make_unique<UnionType>();
+    for (auto &o : u->Options) out->Options.push_back(cloneType(o.get()));
+    return out;
+  }
+  if (auto it = dynamic_cast<const IntersectionType*>(t)) {
+    auto out = std::make_unique<IntersectionType>();
+    for (auto &p : it->Parts) out->Parts.push_back(cloneType(p.get()));
+    return out;
+  }
+  if (auto r = dynamic_cast<const RawType*>(t)) {
+    return std::make_unique<RawType>(r->Raw);
+  }
+  return nullptr;
+}
@@ -2,59 +2,384 @@
 
 #pragma once
 #include "token.h"
+#include "arena.h"
+#include <cstdint>
 #include <memory>
 #include <string>
+#include <string_view>
+#include <type_traits>
 #include <vector>
 #include <utility>
 
+// AST nodes for expressions and statements are allocated from an AstContext
+// and are trivially destructible: the whole tree is released at once with its
+// context. Children are plain pointers, child sequences are AstLists in the
+// same arena, identifiers are interned (equal names share storage) and literal
+// text is a span of the source, so nodes never own heap memory of their own.
+// Use ast_cast<T>() to test a node's concrete type.
+
+// Fixed-size sequence stored in the AST arena.
+template <typename T>
+struct AstList {
+  const T *items = nullptr;
+  uint32_t count = 0;
+  const T *begin() const { return items; }
+  const T *end() const { return items + count; }
+  size_t size() const { return count; }
+  bool empty() const { return count == 0; }
+  const T &operator[](size_t i) const { return items[i]; }
+  const T &front() const { return items[0]; }
+  const T &back() const { return items[count - 1]; }
+};
+
+enum class ExprKind : uint8_t {
+  Literal,
+  Identifier,
+  Member,
+  Index,
+  Object,
+  Call,
+  Unary,
+  Binary,
+  Assign,
+  Conditional,
+  Sequence,
+  Function,
+  Raw
+};
+
+enum class StmtKind : uint8_t {
+  Program,
+  VarDecl,
+  Print,
+  Expr,
+  Block,
+  Return,
+  If,
+  While,
+  DoWhile,
+  For,
+  Break,
+  Continue,
+  FunctionDecl,
+  ClassDecl,
+  Import,
+  Raw
+};
+
 // AST base classes
 struct Expr {
-  virtual ~Expr() = default;
+  const ExprKind nodeKind;
+protected:
+  explicit Expr(ExprKind k) : nodeKind(k) {}
 };
 struct Stmt {
-  virtual ~Stmt() = default;
+  const StmtKind nodeKind;
+protected:
+  explicit Stmt(StmtKind k) : nodeKind(k) {}
 };
 
+// Checked downcast: returns null when `n` is null or not a T.
+template <typename T, typename N>
+auto ast_cast(N *n) -> std::conditional_t<std::is_const<N>::value, const T *, T *> {
+  return n && n->nodeKind == T::ClassKind ? static_cast<std::conditional_t<std::is_const<N>::value, const T *, T *>>(n) : nullptr;
+}
+
 // Variable/const declaration statement
 struct VarDeclStmt : Stmt {
-  std::string name;
-  std::unique_ptr<Expr> value;
-  VarDeclStmt(const std::string& n, std::unique_ptr<Expr> v)
-    : name(n), value(std::move(v)) {}
+  static constexpr StmtKind ClassKind = StmtKind::VarDecl;
+  std::string_view name;
+  Expr *value; // may be null
+  std::string_view type; // annotation as typeToString prints it, empty if none
+  VarDeclStmt(std::string_view n, Expr *v, std::string_view t = {}) : Stmt(ClassKind), name(n), value(v), type(t) {}
 };
 
 // Program node: holds a list of statements
 struct Program : Stmt {
-  std::vector<std::unique_ptr<Stmt>> statements;
-  explicit Program(std::vector<std::unique_ptr<Stmt>> stmts)
-    : statements(std::move(stmts)) {}
+  static constexpr StmtKind ClassKind = StmtKind::Program;
+  AstList<Stmt *> statements;
+  explicit Program(AstList<Stmt *> stmts) : Stmt(ClassKind), statements(stmts) {}
 };
 
 // Expression types
 
+// Literal value. String literals have their quotes stripped; numeric and
+// boolean literals keep their source text.
 struct LiteralExpr : Expr {
-  std::string value;
-  explicit LiteralExpr(const std::string& v) : value(v) {}
+  static constexpr ExprKind ClassKind = ExprKind::Literal;
+  enum Kind
+  {
+    STRING,
+    NUMBER,
+    BOOL,
+    NUL,
+    UNDEFINED
+  } kind;
+  std::string_view value;
+  explicit LiteralExpr(std::string_view v, Kind k = STRING) : Expr(ClassKind), kind(k), value(v) {}
 };
 
 struct IdentifierExpr : Expr {
-  std::string name;
-  explicit IdentifierExpr(const std::string& n) : name(n) {}
+  static constexpr ExprKind ClassKind = ExprKind::Identifier;
+  std::string_view name;
+  explicit IdentifierExpr(std::string_view n) : Expr(ClassKind), name(n) {}
+};
+
+// object.property or object?.property
+struct MemberExpr : Expr {
+  static constexpr ExprKind ClassKind = ExprKind::Member;
+  Expr *object;
+  std::string_view property;
+  bool optional;
+  MemberExpr(Expr *o, std::string_view p, bool opt) : Expr(ClassKind), object(o), property(p), optional(opt) {}
+};
+
+// object[index]
+struct IndexExpr : Expr {
+  static constexpr ExprKind ClassKind = ExprKind::Index;
+  Expr *object;
+  Expr *index;
+  size_t pos;
+  IndexExpr(Expr *o, Expr *i, size_t p) : Expr(ClassKind), object(o), index(i), pos(p) {}
+};
+
+// `key: value` entry of an object literal; shorthand `{ a }` has an
+// IdentifierExpr value. String keys have their quotes stripped.
+struct ObjectProperty {
+  std::string_view key;
+  Expr *value;
+};
+
+// Object literal whose properties are all plain `key: value` or shorthand
+// entries; computed keys, spreads and methods make the literal a RawExpr.
+struct ObjectExpr : Expr {
+  static constexpr ExprKind ClassKind = ExprKind::Object;
+  AstList<ObjectProperty> properties;
+  size_t pos;
+  ObjectExpr(AstList<ObjectProperty> props, size_t p) : Expr(ClassKind), properties(props), pos(p) {}
 };
 
 struct CallExpr : Expr {
-  std::string callee;
-  std::vector<std::unique_ptr<Expr>> args;
-  CallExpr(const std::string& c, std::vector<std::unique_ptr<Expr>> a)
-    : callee(c), args(std::move(a)) {}
+  static constexpr ExprKind ClassKind = ExprKind::Call;
+  Expr *callee;
+  AstList<Expr *> args;
+  CallExpr(Expr *c, AstList<Expr *> a) : Expr(ClassKind), callee(c), args(a) {}
+};
+
+// Prefix (-x, !x, ++x, ...) or postfix (x++, x--) operator application.
+struct UnaryExpr : Expr {
+  static constexpr ExprKind ClassKind = ExprKind::Unary;
+  TokenKind op;
+  Expr *operand;
+  bool prefix;
+  UnaryExpr(TokenKind o, Expr *e, bool pre) : Expr(ClassKind), op(o), operand(e), prefix(pre) {}
+};
+
+struct BinaryExpr : Expr {
+  static constexpr ExprKind ClassKind = ExprKind::Binary;
+  TokenKind op;
+  Expr *lhs;
+  Expr *rhs;
+  BinaryExpr(TokenKind o, Expr *l, Expr *r) : Expr(ClassKind), op(o), lhs(l), rhs(r) {}
+};
+
+// target = value, target += value, ... (`op` is the assignment token)
+struct AssignExpr : Expr {
+  static constexpr ExprKind ClassKind = ExprKind::Assign;
+  TokenKind op;
+  Expr *target;
+  Expr *value;
+  AssignExpr(TokenKind o, Expr *t, Expr *v) : Expr(ClassKind), op(o), target(t), value(v) {}
+};
+
+// cond ? consequent : alternate
+struct ConditionalExpr : Expr {
+  static constexpr ExprKind ClassKind = ExprKind::Conditional;
+  Expr *cond;
+  Expr *consequent;
+  Expr *alternate;
+  ConditionalExpr(Expr *c, Expr *t, Expr *e) : Expr(ClassKind), cond(c), consequent(t), alternate(e) {}
+};
+
+// Comma-separated expressionSequence with more than one element.
+struct SequenceExpr : Expr {
+  static constexpr ExprKind ClassKind = ExprKind::Sequence;
+  AstList<Expr *> exprs;
+  explicit SequenceExpr(AstList<Expr *> e) : Expr(ClassKind), exprs(e) {}
+};
+
+struct BlockStmt;
+
+// Function expression or arrow function with plain identifier parameters.
+// `name` is empty for anonymous functions; an arrow function's expression
+// body is stored as a block holding a single return statement.
+struct FunctionExpr : Expr {
+  static constexpr ExprKind ClassKind = ExprKind::Function;
+  std::string_view name;
+  AstList<std::string_view> params;
+  BlockStmt *body;
+  bool arrow;
+  size_t pos;
+  FunctionExpr(std::string_view n, AstList<std::string_view> p, BlockStmt *b, bool a, size_t at)
+    : Expr(ClassKind), name(n), params(p), body(b), arrow(a), pos(at) {}
+};
+
+// RawExpr: conservative sink for expression forms the parser recognizes but
+// doesn't model yet (array literals, `new`, `this`, templates, ...); records
+// where the expression started.
+struct RawExpr : Expr {
+  static constexpr ExprKind ClassKind = ExprKind::Raw;
+  size_t pos;
+  explicit RawExpr(size_t p) : Expr(ClassKind), pos(p) {}
 };
 
 // Print statement now stores a list of Expr (for multiple arguments)
 struct PrintStmt : Stmt {
-  std::vector<std::unique_ptr<Expr>> args;
+  static constexpr StmtKind ClassKind = StmtKind::Print;
+  AstList<Expr *> args;
   TokenKind origin;
-  PrintStmt(std::vector<std::unique_ptr<Expr>> a, TokenKind k)
-    : args(std::move(a)), origin(k) {}
+  PrintStmt(AstList<Expr *> a, TokenKind k) : Stmt(ClassKind), args(a), origin(k) {}
+};
+
+// Statement types
+
+struct ExprStmt : Stmt {
+  static constexpr StmtKind ClassKind = StmtKind::Expr;
+  Expr *expr;
+  explicit ExprStmt(Expr *e) : Stmt(ClassKind), expr(e) {}
+};
+
+// `declList` marks the declarations of one `let a = 1, b = 2;`, which
+// belong to the enclosing scope; any other block opens a scope of its own.
+struct BlockStmt : Stmt {
+  static constexpr StmtKind ClassKind = StmtKind::Block;
+  AstList<Stmt *> statements;
+  bool declList;
+  explicit BlockStmt(AstList<Stmt *> stmts, bool list = false) : Stmt(ClassKind), statements(stmts), declList(list) {}
+};
+
+// `value` is null for a bare `return;`
+struct ReturnStmt : Stmt {
+  static constexpr StmtKind ClassKind = StmtKind::Return;
+  Expr *value;
+  explicit ReturnStmt(Expr *v) : Stmt(ClassKind), value(v) {}
+};
+
+struct IfStmt : Stmt {
+  static constexpr StmtKind ClassKind = StmtKind::If;
+  Expr *cond;
+  Stmt *then;
+  Stmt *otherwise; // may be null
+  IfStmt(Expr *c, Stmt *t, Stmt *e) : Stmt(ClassKind), cond(c), then(t), otherwise(e) {}
+};
+
+struct WhileStmt : Stmt {
+  static constexpr StmtKind ClassKind = StmtKind::While;
+  Expr *cond;
+  Stmt *body;
+  WhileStmt(Expr *c, Stmt *b) : Stmt(ClassKind), cond(c), body(b) {}
+};
+
+struct DoWhileStmt : Stmt {
+  static constexpr StmtKind ClassKind = StmtKind::DoWhile;
+  Stmt *body;
+  Expr *cond;
+  DoWhileStmt(Stmt *b, Expr *c) : Stmt(ClassKind), body(b), cond(c) {}
+};
+
+// for (init; cond; update) body -- every clause is optional
+struct ForStmt : Stmt {
+  static constexpr StmtKind ClassKind = StmtKind::For;
+  Stmt *init;
+  Expr *cond;
+  Expr *update;
+  Stmt *body;
+  ForStmt(Stmt *i, Expr *c, Expr *u, Stmt *b) : Stmt(ClassKind), init(i), cond(c), update(u), body(b) {}
+};
+
+struct BreakStmt : Stmt {
+  static constexpr StmtKind ClassKind = StmtKind::Break;
+  BreakStmt() : Stmt(ClassKind) {}
+};
+struct ContinueStmt : Stmt {
+  static constexpr StmtKind ClassKind = StmtKind::Continue;
+  ContinueStmt() : Stmt(ClassKind) {}
+};
+
+// function name(params) { body } -- only plain identifier parameters are
+// modeled; `body` holds the statements of the function body. `paramTypes`
+// holds one annotation per parameter and `returnType` the return annotation,
+// as typeToString prints them (empty if none). `exported` is set for
+// `export function`.
+struct FunctionDecl : Stmt {
+  static constexpr StmtKind ClassKind = StmtKind::FunctionDecl;
+  std::string_view name;
+  AstList<std::string_view> params;
+  BlockStmt *body;
+  AstList<std::string_view> paramTypes;
+  std::string_view returnType;
+  bool exported = false;
+  FunctionDecl(std::string_view n, AstList<std::string_view> p, BlockStmt *b, AstList<std::string_view> pt = {},
+               std::string_view rt = {})
+    : Stmt(ClassKind), name(n), params(p), body(b), paramTypes(pt), returnType(rt) {}
+};
+
+// import { a, b as c } from "./m" -- `from` is the module specifier without
+// its quotes. A default import binds imported name "default", a namespace
+// import (`* as m`) binds "*"; a bare `import "./m"` has no bindings.
+struct ImportBinding {
+  std::string_view imported;
+  std::string_view local;
+};
+struct ImportStmt : Stmt {
+  static constexpr StmtKind ClassKind = StmtKind::Import;
+  std::string_view from;
+  AstList<ImportBinding> bindings;
+  size_t pos;
+  ImportStmt(std::string_view f, AstList<ImportBinding> b, size_t p) : Stmt(ClassKind), from(f), bindings(b), pos(p) {}
+};
+
+// class name extends superClass { ... } -- members are recognized by the
+// parser but not modeled yet.
+struct ClassDecl : Stmt {
+  static constexpr StmtKind ClassKind = StmtKind::ClassDecl;
+  std::string_view name;
+  Expr *superClass; // may be null
+  size_t pos;
+  ClassDecl(std::string_view n, Expr *s, size_t p) : Stmt(ClassKind), name(n), superClass(s), pos(p) {}
+};
+
+// RawStmt: statement the parser recognized but doesn't build a node for yet
+// (switch, try, throw, labelled statements, ...).
+struct RawStmt : Stmt {
+  static constexpr StmtKind ClassKind = StmtKind::Raw;
+  size_t pos;
+  explicit RawStmt(size_t p) : Stmt(ClassKind), pos(p) {}
+};
+
+// Owner of the nodes of one compilation: an arena for the nodes and their
+// lists plus the identifier interner.
+class AstContext {
+public:
+  AstContext() : Names(Nodes) {}
+  template <typename T, typename... Args>
+  T *make(Args &&...args) {
+    ++NodeCount;
+    return Nodes.make<T>(std::forward<Args>(args)...);
+  }
+  template <typename T>
+  AstList<T> list(const std::vector<T> &items) {
+    return {Nodes.copyArray(items.data(), items.size()), static_cast<uint32_t>(items.size())};
+  }
+  std::string_view intern(std::string_view name) { return Names.intern(name); }
+  size_t bytesAllocated() const { return Nodes.bytesAllocated(); }
+  // Nodes made so far (list storage and names not included).
+  size_t nodeCount() const { return NodeCount; }
+
+private:
+  Arena Nodes;
+  StringInterner Names;
+  size_t NodeCount = 0;
 };
 
 // Minimal Type AST for lightweight printing and future wiring
@@ -95,3 +420,5 @@ struct RawType : Type {
 // Utilities
 std::string stmtToString(const Stmt* s);
 std::string typeToString(const Type* t);
+// Deep copy of a Type tree (nullptr for nullptr).
+std::unique_ptr<Type> cloneType(const Type* t);
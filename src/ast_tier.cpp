@@ -0,0 +1,1563 @@
+#include "ast_tier.h"
+#include "runtime.h"
+#include "semantics.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <limits>
+#include <map>
+#include <optional>
+#include <set>
+
+#include <llvm/Support/thread.h>
+
+namespace
+{
+
+using Kind = ValueKind;
+
+// Calls, or loop iterations, after which a function is worth compiling.
+constexpr uint32_t HotCalls = 1000;
+constexpr uint32_t HotIterations = 10000;
+// Every oong call nests several interpreter frames, so the program runs on a
+// thread whose stack is deep enough for recursion native code would survive.
+constexpr std::optional<unsigned> StackSize = 1u << 30;
+
+const double NaN = std::numeric_limits<double>::quiet_NaN();
+
+double tagged(uint64_t bits)
+{
+    double v;
+    std::memcpy(&v, &bits, sizeof v);
+    return v;
+}
+
+uint64_t bits_of(double v)
+{
+    uint64_t bits;
+    std::memcpy(&bits, &v, sizeof bits);
+    return bits;
+}
+
+// undefined and null, as codegen keeps them in a double (see value.h)
+const double Undefined = tagged(Value::UndefinedTag);
+const double Null = tagged(Value::NullTag);
+
+bool is_nullish(double v)
+{
+    uint64_t bits = bits_of(v);
+    return bits == Value::UndefinedTag || bits == Value::NullTag;
+}
+
+// ToNumber: undefined is NaN, null is 0
+double numeric(double v)
+{
+    uint64_t bits = bits_of(v);
+    return bits == Value::UndefinedTag ? NaN : bits == Value::NullTag ? 0 : v;
+}
+
+enum class Op : uint8_t
+{
+    // Expressions evaluate to a double; booleans are 0 or 1.
+    Const,
+    Load,    // index: slot
+    Store,   // slot = a
+    Update,  // ++/-- (tok) on a slot; flag: prefix
+    Discard, // evaluate list, yield num
+    Numeric, // a as a number: undefined is NaN, null 0
+    Neg,
+    Not,
+    ToBool,
+    BitNot,
+    Add,
+    Sub,
+    Mul,
+    Div,
+    Mod,
+    Pow,
+    Eq,
+    Ne,
+    Lt,
+    Gt,
+    Le,
+    Ge,
+    NullishEq, // tok: ==, !=, === or !== where a or b may be undefined/null
+    BitAnd,
+    BitOr,
+    BitXor,
+    Shl,
+    Sar,
+    Shr,
+    Logical,     // tok: &&, || or ??
+    Conditional, // a ? b : c
+    Sequence,
+    Call,    // index: function, list: arguments
+    Math,    // math(first argument)
+    Round,
+    MathPow,
+    Min,
+    Max,
+    DateNow,
+    // Statements
+    Eval,
+    Block,
+    If,      // a: cond, b: then, c: else
+    While,   // a: cond, b: body
+    DoWhile, // a: body, b: cond
+    For,     // a: init, b: cond, c: update, d: body
+    Return,
+    Break,
+    Continue,
+    Print, // index: print line
+};
+
+struct Node
+{
+    Op op;
+    Kind kind = Kind::Number;
+    TokenKind tok = TokenKind::Tok_Invalid;
+    bool global = false; // Load/Store/Update: index is a top-level variable
+    bool flag = false;
+    bool nullish = false; // a number that may be undefined or null
+    uint32_t index = 0;
+    double num = 0;
+    double (*math)(double) = nullptr;
+    const Node *a = nullptr, *b = nullptr, *c = nullptr, *d = nullptr;
+    std::vector<const Node *> list;
+};
+
+// A print statement as codegen emits it: each segment writes its text, then
+// its value; `tail` ends the line (as a whole line when nothing is dynamic).
+struct PrintLine
+{
+    struct Segment
+    {
+        std::string text;
+        const Node *value;
+        bool colored = true; // false: in yellow only when it is not undefined/null
+    };
+    std::vector<Segment> segments;
+    std::string tail;
+    bool plain = true;
+    bool err = false; // console.error/warn: to stderr
+};
+
+struct Function
+{
+    std::string_view name;
+    Kind ret = Kind::Number;
+    uint32_t arity = 0;
+    std::vector<Kind> params;
+    uint32_t slots = 0;
+    std::vector<const Node *> body;
+    std::set<uint32_t> callees;
+    bool usesGlobals = false;
+    bool promotable = false; // nothing it reaches uses globals
+
+    uint32_t calls = 0;
+    uint32_t iterations = 0;
+    std::atomic<AstTier::NativeFn> native{nullptr};
+};
+
+struct Code
+{
+    std::deque<Node> nodes;
+    std::deque<PrintLine> lines;
+    std::deque<Function> functions;
+    std::map<std::string_view, uint32_t> functionIndex;
+    std::vector<double> globals; // initial values
+    std::vector<const Node *> main;
+    uint32_t mainSlots = 0;
+};
+
+// Resolves the AST into Code, making the same decisions (and rejecting the
+// same programs) as the Emitter in codegen.cpp.
+class Lowering
+{
+public:
+    Lowering(Code &code, const ProgramInfo &info) : C(code), Info(info) {}
+    bool run(const Program &prog);
+    std::string Error;
+
+private:
+    struct Slot
+    {
+        bool global;
+        uint32_t index;
+        Kind kind;
+    };
+
+    Code &C;
+    const ProgramInfo &Info;
+    std::map<std::string_view, Slot> Globals;
+    std::vector<std::map<std::string_view, Slot>> Scopes;
+    Function *CurFn = nullptr; // null while lowering the top level
+    const FunctionDecl *CurDecl = nullptr;
+    uint32_t Slots = 0;
+    int Loops = 0;
+
+    bool fail(const std::string &msg)
+    {
+        if (Error.empty())
+            Error = msg;
+        return false;
+    }
+    const Node *failValue(const std::string &msg)
+    {
+        fail(msg);
+        return nullptr;
+    }
+    std::string where(size_t pos) const { return Info.where(pos); }
+
+    Node *make(Op op, Kind kind = Kind::Number)
+    {
+        Node &n = C.nodes.emplace_back();
+        n.op = op;
+        n.kind = kind;
+        return &n;
+    }
+    const Node *constant(double v, Kind kind = Kind::Number)
+    {
+        Node *n = make(Op::Const, kind);
+        n->num = v;
+        return n;
+    }
+    const Node *retag(const Node *n, Kind kind)
+    {
+        if (n->kind == kind)
+            return n;
+        Node *copy = make(n->op);
+        *copy = *n;
+        copy->kind = kind;
+        return copy;
+    }
+    // The value of `n` for arithmetic (booleans already are 0/1): only a
+    // nullish one needs converting.
+    const Node *numeric(const Node *n)
+    {
+        if (!n->nullish)
+            return n;
+        Node *m = make(Op::Numeric);
+        m->a = n;
+        return m;
+    }
+    // Booleans are already 0/1 numbers; numbers become booleans by truthiness.
+    const Node *convert(const Node *n, Kind to)
+    {
+        if (to == Kind::Number || n->kind == Kind::Bool)
+            return retag(n, to);
+        Node *b = make(Op::ToBool, Kind::Bool);
+        b->a = n;
+        return b;
+    }
+
+    const Slot *lookup(std::string_view name);
+    Slot declare(std::string_view name, Kind kind);
+    Node *access(Op op, const Slot &slot);
+
+    bool lowerFunction(Function &fn, const FunctionDecl *decl);
+    bool lowerStmt(const Stmt *s, const Node *&out, bool topLevel = false);
+    bool lowerVarDecl(const VarDeclStmt *v, const Node *&out, bool topLevel);
+    const Node *lowerPrint(const PrintStmt *ps);
+    bool readsConstant(const MemberExpr *m)
+    {
+        const IdentifierExpr *root = member_root(m);
+        return root && !lookup(root->name) && Info.consts.count(root->name);
+    }
+    const Node *lowerExpr(const Expr *e);
+    const Node *lowerValue(const Expr *e);
+    const Node *lowerArithmetic(TokenKind op, const Node *l, const Node *r);
+    const Node *lowerLogical(TokenKind op, const Expr *lhs, const Expr *rhs);
+    const Node *lowerAssign(const AssignExpr *a);
+    const Node *lowerUpdate(const UnaryExpr *u);
+    const Node *lowerCall(const CallExpr *c);
+};
+
+const Lowering::Slot *Lowering::lookup(std::string_view name)
+{
+    for (auto it = Scopes.rbegin(); it != Scopes.rend(); ++it)
+    {
+        auto v = it->find(name);
+        if (v != it->end())
+            return &v->second;
+    }
+    auto g = Globals.find(name);
+    if (g != Globals.end())
+        return &g->second;
+    return nullptr;
+}
+
+Lowering::Slot Lowering::declare(std::string_view name, Kind kind)
+{
+    Slot s{false, Slots++, kind};
+    Scopes.back()[name] = s;
+    return s;
+}
+
+Node *Lowering::access(Op op, const Slot &slot)
+{
+    Node *n = make(op, slot.kind);
+    n->global = slot.global;
+    n->index = slot.index;
+    if (slot.global && CurFn)
+        CurFn->usesGlobals = true;
+    return n;
+}
+
+bool Lowering::run(const Program &prog)
+{
+    for (const auto &kv : Info.functions)
+    {
+        C.functionIndex[kv.first] = static_cast<uint32_t>(C.functions.size());
+        Function &fn = C.functions.emplace_back();
+        fn.name = kv.first;
+        fn.ret = kv.second.ret;
+        fn.arity = static_cast<uint32_t>(kv.second.decl->params.size());
+        fn.params = kv.second.params;
+    }
+    for (const auto &kv : Info.globals)
+    {
+        Globals[kv.first] = Slot{true, static_cast<uint32_t>(C.globals.size()), kv.second};
+        C.globals.push_back(kv.second == Kind::Bool ? 0 : NaN);
+    }
+
+    // Codegen turns a function it cannot lower into a run-time error; the tier
+    // has no such fallback, so the JIT takes those programs.
+    for (const auto &kv : Info.functions)
+    {
+        uint32_t index = C.functionIndex[kv.first];
+        if (!lowerFunction(C.functions[index], kv.second.decl))
+        {
+            Error = "function '" + std::string(kv.first) + "': " + Error;
+            return false;
+        }
+    }
+
+    CurFn = nullptr;
+    CurDecl = nullptr;
+    Scopes.assign(1, {});
+    Slots = 0;
+    Loops = 0;
+    for (const auto &s : prog.statements)
+    {
+        if (ast_cast<FunctionDecl>(s))
+            continue;
+        const Node *n = nullptr;
+        if (!lowerStmt(s, n, true))
+            return false;
+        if (n)
+            C.main.push_back(n);
+    }
+    C.mainSlots = Slots;
+
+    // A function may be promoted when nothing it reaches touches a top-level
+    // variable.
+    for (Function &fn : C.functions)
+    {
+        bool pure = true;
+        std::set<uint32_t> seen;
+        std::vector<uint32_t> work{C.functionIndex[fn.name]};
+        while (!work.empty())
+        {
+            uint32_t i = work.back();
+            work.pop_back();
+            if (!seen.insert(i).second)
+                continue;
+            const Function &f = C.functions[i];
+            pure = pure && !f.usesGlobals;
+            work.insert(work.end(), f.callees.begin(), f.callees.end());
+        }
+        fn.promotable = pure;
+    }
+    return true;
+}
+
+bool Lowering::lowerFunction(Function &fn, const FunctionDecl *decl)
+{
+    CurFn = &fn;
+    CurDecl = decl;
+    Scopes.assign(1, {});
+    Slots = 0;
+    Loops = 0;
+    for (size_t i = 0; i < decl->params.size(); ++i)
+        declare(decl->params[i], fn.params[i]);
+    for (const auto &s : decl->body->statements)
+    {
+        const Node *n = nullptr;
+        if (!lowerStmt(s, n))
+            return false;
+        if (n)
+            fn.body.push_back(n);
+    }
+    fn.slots = Slots;
+    return true;
+}
+
+bool Lowering::lowerVarDecl(const VarDeclStmt *v, const Node *&out, bool topLevel)
+{
+    if (topLevel && Info.consts.count(v->name))
+        return true;
+    std::optional<Kind> declared = annotated_kind(v->type);
+    // a `boolean` one without an initializer is never read (see
+    // ProgramInfo::analyze)
+    const Node *value = declared == Kind::Bool ? constant(0, Kind::Bool) : constant(Undefined);
+    if (v->value)
+    {
+        value = lowerExpr(v->value);
+        if (!value)
+            return false;
+    }
+    if (declared && value->kind != *declared)
+        return fail(*declared == Kind::Bool ? "cannot store a number in boolean variable '" + std::string(v->name) + "'"
+                                            : "cannot store a boolean in number variable '" + std::string(v->name) + "'");
+    if (topLevel && Globals.count(v->name))
+    {
+        Slot g = Globals[v->name];
+        if (g.kind != value->kind)
+            return fail(g.kind == Kind::Bool ? "cannot store a number in boolean variable '" + std::string(v->name) + "'"
+                                             : "cannot store a boolean in number variable '" + std::string(v->name) + "'");
+        Node *store = access(Op::Store, g);
+        store->a = value;
+        Node *stmt = make(Op::Eval);
+        stmt->a = store;
+        out = stmt;
+        return true;
+    }
+    Node *store = access(Op::Store, declare(v->name, value->kind));
+    store->a = value;
+    Node *stmt = make(Op::Eval);
+    stmt->a = store;
+    out = stmt;
+    return true;
+}
+
+bool Lowering::lowerStmt(const Stmt *s, const Node *&out, bool topLevel)
+{
+    out = nullptr;
+    if (!s)
+        return true;
+    if (auto v = ast_cast<VarDeclStmt>(s))
+        return lowerVarDecl(v, out, topLevel);
+    if (auto p = ast_cast<PrintStmt>(s))
+        return (out = lowerPrint(p)) != nullptr;
+    if (auto x = ast_cast<ExprStmt>(s))
+    {
+        const Node *e = lowerExpr(x->expr);
+        if (!e)
+            return false;
+        Node *n = make(Op::Eval);
+        n->a = e;
+        out = n;
+        return true;
+    }
+    if (auto b = ast_cast<BlockStmt>(s))
+    {
+        if (!b->declList)
+            Scopes.emplace_back();
+        Node *block = make(Op::Block);
+        for (const auto &c : b->statements)
+        {
+            const Node *n = nullptr;
+            if (!lowerStmt(c, n, topLevel && b->declList))
+                return false;
+            if (n)
+                block->list.push_back(n);
+        }
+        if (!b->declList)
+            Scopes.pop_back();
+        out = block;
+        return true;
+    }
+    if (auto r = ast_cast<ReturnStmt>(s))
+    {
+        if (!CurFn)
+            return fail("return outside of a function");
+        const Node *value = constant(Undefined);
+        if (r->value)
+        {
+            value = lowerExpr(r->value);
+            if (!value)
+                return false;
+        }
+        if (CurFn->ret == Kind::Number && value->kind == Kind::Bool)
+            return fail("cannot return a boolean from a function that returns numbers");
+        Node *ret = make(Op::Return);
+        if (CurFn->ret == Kind::Bool && !r->value)
+            ret->a = constant(0, Kind::Bool);
+        else
+            ret->a = convert(value, CurFn->ret);
+        out = ret;
+        return true;
+    }
+    if (auto i = ast_cast<IfStmt>(s))
+    {
+        const Node *cond = lowerExpr(i->cond);
+        if (!cond)
+            return false;
+        Node *n = make(Op::If);
+        n->a = cond;
+        Scopes.emplace_back();
+        if (!lowerStmt(i->then, n->b))
+            return false;
+        Scopes.pop_back();
+        if (i->otherwise)
+        {
+            Scopes.emplace_back();
+            if (!lowerStmt(i->otherwise, n->c))
+                return false;
+            Scopes.pop_back();
+        }
+        out = n;
+        return true;
+    }
+    if (auto w = ast_cast<WhileStmt>(s))
+    {
+        Node *n = make(Op::While);
+        if (!(n->a = lowerExpr(w->cond)))
+            return false;
+        ++Loops;
+        Scopes.emplace_back();
+        if (!lowerStmt(w->body, n->b))
+            return false;
+        Scopes.pop_back();
+        --Loops;
+        out = n;
+        return true;
+    }
+    if (auto d = ast_cast<DoWhileStmt>(s))
+    {
+        Node *n = make(Op::DoWhile);
+        ++Loops;
+        Scopes.emplace_back();
+        if (!lowerStmt(d->body, n->a))
+            return false;
+        Scopes.pop_back();
+        --Loops;
+        if (!(n->b = lowerExpr(d->cond)))
+            return false;
+        out = n;
+        return true;
+    }
+    if (auto f = ast_cast<ForStmt>(s))
+    {
+        Node *n = make(Op::For);
+        Scopes.emplace_back();
+        if (!lowerStmt(f->init, n->a))
+            return false;
+        if (f->cond && !(n->b = lowerExpr(f->cond)))
+            return false;
+        ++Loops;
+        Scopes.emplace_back();
+        if (!lowerStmt(f->body, n->d))
+            return false;
+        Scopes.pop_back();
+        --Loops;
+        if (f->update && !(n->c = lowerExpr(f->update)))
+            return false;
+        Scopes.pop_back();
+        out = n;
+        return true;
+    }
+    if (ast_cast<BreakStmt>(s) || ast_cast<ContinueStmt>(s))
+    {
+        bool isBreak = ast_cast<BreakStmt>(s) != nullptr;
+        if (!Loops)
+            return fail(isBreak ? "break outside of a loop" : "continue outside of a loop");
+        out = make(isBreak ? Op::Break : Op::Continue);
+        return true;
+    }
+    if (ast_cast<FunctionDecl>(s))
+        return fail("nested function declarations are not supported yet");
+    if (auto cd = ast_cast<ClassDecl>(s))
+        return fail("classes are not supported yet (" + where(cd->pos) + ")");
+    if (auto raw = ast_cast<RawStmt>(s))
+        return fail("unsupported statement at " + where(raw->pos));
+    return fail("unsupported statement");
+}
+
+const Node *Lowering::lowerPrint(const PrintStmt *ps)
+{
+    std::string color = print_color(ps->origin);
+    bool isConsole = ps->origin != TokenKind::Tok_Print;
+    PrintLine &line = C.lines.emplace_back();
+    line.err = prints_to_stderr(ps->origin);
+    Node *n = make(Op::Print);
+    n->index = static_cast<uint32_t>(C.lines.size() - 1);
+    // Same text bookkeeping as Emitter::emitPrint: `pending` becomes the text
+    // written before the next runtime value.
+    std::string pending;
+    auto emitRuntime = [&](const Node *v, const std::string &prefix)
+    {
+        line.plain = false;
+        if (v->nullish)
+        {
+            line.segments.push_back({pending + prefix, v, false});
+            pending.clear();
+            return;
+        }
+        pending += v->kind == Kind::Bool ? yellow : prefix + yellow;
+        line.segments.push_back({pending, v});
+        pending = reset;
+    };
+
+    if (!color.empty())
+        pending += color;
+    for (size_t i = 0; i < ps->args.size(); ++i)
+    {
+        if (i > 0)
+            pending += " ";
+        const Expr *arg = ps->args[i];
+        if (auto lit = ast_cast<LiteralExpr>(arg))
+        {
+            switch (lit->kind)
+            {
+            case LiteralExpr::BOOL:
+                pending += yellow + std::string(lit->value) + reset;
+                break;
+            case LiteralExpr::NUMBER:
+                pending += yellow + format_number(parse_number_literal(std::string(lit->value))) + reset;
+                break;
+            case LiteralExpr::NUL:
+                pending += color + "null";
+                break;
+            case LiteralExpr::UNDEFINED:
+                pending += color + "undefined";
+                break;
+            default:
+                pending += color + std::string(lit->value);
+                break;
+            }
+            continue;
+        }
+        if (auto o = ast_cast<ObjectExpr>(arg))
+        {
+            Value obj;
+            if (!Info.foldObject(o, obj, Error))
+                return nullptr;
+            pending += color;
+            serialize(obj, isConsole ? color : "", pending);
+            continue;
+        }
+        if (auto id = ast_cast<IdentifierExpr>(arg))
+        {
+            if (const Slot *v = lookup(id->name))
+            {
+                Node *load = access(Op::Load, *v);
+                load->nullish = v->kind == Kind::Number && Info.mayBeNullish(id, CurDecl);
+                emitRuntime(load, color);
+                continue;
+            }
+            auto it = Info.consts.find(id->name);
+            if (it != Info.consts.end())
+            {
+                pending += color;
+                serialize(it->second, isConsole ? color : "", pending);
+                continue;
+            }
+            if (id->name != "NaN" && id->name != "Infinity")
+            {
+                pending += color + "<undefined>";
+                continue;
+            }
+        }
+        if (auto m = ast_cast<MemberExpr>(arg); m && readsConstant(m))
+        {
+            Value v;
+            if (!Info.constMember(m, v, Error))
+                return nullptr;
+            pending += print_constant(v, color, isConsole);
+            continue;
+        }
+        const Node *value = lowerExpr(arg);
+        if (!value)
+            return nullptr;
+        emitRuntime(value, "");
+    }
+    if (!color.empty())
+        pending += reset;
+    if (!line.plain)
+        pending += "\n";
+    line.tail = pending;
+    return n;
+}
+
+const Node *Lowering::lowerExpr(const Expr *e)
+{
+    const Node *n = lowerValue(e);
+    if (!n || n->kind != Kind::Number || n->nullish || !Info.mayBeNullish(e, CurDecl))
+        return n;
+    // Nodes are made here and only handed out as const, so this marks one of
+    // ours. A node that was passed up unchanged (`a ?? b` with a never nullish)
+    // is the same value as the outer expression, which is no less nullish.
+    Node *marked = const_cast<Node *>(n);
+    marked->nullish = true;
+    return marked;
+}
+
+const Node *Lowering::lowerValue(const Expr *e)
+{
+    if (auto lit = ast_cast<LiteralExpr>(e))
+    {
+        switch (lit->kind)
+        {
+        case LiteralExpr::NUMBER:
+            return constant(parse_number_literal(std::string(lit->value)));
+        case LiteralExpr::BOOL:
+            return constant(lit->value == "true" ? 1 : 0, Kind::Bool);
+        case LiteralExpr::NUL:
+            return constant(Null);
+        case LiteralExpr::UNDEFINED:
+            return constant(Undefined);
+        default:
+            return failValue("string values can only be printed or bound by top-level declarations");
+        }
+    }
+    if (auto id = ast_cast<IdentifierExpr>(e))
+    {
+        if (const Slot *v = lookup(id->name))
+            return access(Op::Load, *v);
+        if (id->name == "NaN")
+            return constant(NaN);
+        if (id->name == "undefined")
+            return constant(Undefined);
+        if (id->name == "Infinity")
+            return constant(std::numeric_limits<double>::infinity());
+        if (Info.consts.count(id->name))
+            return failValue("'" + std::string(id->name) + "' is a string or object constant and can only be printed");
+        if (C.functionIndex.count(id->name))
+            return failValue("functions are not first-class values yet ('" + std::string(id->name) + "')");
+        return failValue("unknown identifier '" + std::string(id->name) + "'");
+    }
+    if (auto m = ast_cast<MemberExpr>(e); m && readsConstant(m))
+    {
+        Value v;
+        if (!Info.constMember(m, v, Error))
+            return nullptr;
+        if (v.type() == Value::Type::Number)
+            return constant(v.number());
+        if (v.type() == Value::Type::Bool)
+            return constant(v.boolean() ? 1 : 0, Kind::Bool);
+        if (v.type() == Value::Type::Undefined)
+            return constant(Undefined);
+        if (v.type() == Value::Type::Null)
+            return constant(Null);
+        return failValue("'." + std::string(m->property) + "' is a string or object and can only be printed");
+    }
+    if (auto m = ast_cast<MemberExpr>(e))
+    {
+        auto obj = ast_cast<IdentifierExpr>(m->object);
+        if (obj && obj->name == "Math" && m->property == "PI")
+            return constant(M_PI);
+        if (obj && obj->name == "Math" && m->property == "E")
+            return constant(M_E);
+        return failValue("unsupported property access '." + std::string(m->property) + "'");
+    }
+    if (auto c = ast_cast<CallExpr>(e))
+        return lowerCall(c);
+    if (auto u = ast_cast<UnaryExpr>(e))
+    {
+        if (u->op == TokenKind::Tok_PlusPlus || u->op == TokenKind::Tok_MinusMinus)
+            return lowerUpdate(u);
+        const Node *v = lowerExpr(u->operand);
+        if (!v)
+            return nullptr;
+        Node *n;
+        switch (u->op)
+        {
+        case TokenKind::Tok_Minus:
+            n = make(Op::Neg);
+            v = numeric(v);
+            break;
+        case TokenKind::Tok_Plus:
+            return retag(numeric(v), Kind::Number);
+        case TokenKind::Tok_Not:
+            n = make(Op::Not, Kind::Bool);
+            break;
+        case TokenKind::Tok_BitNot:
+            n = make(Op::BitNot);
+            v = numeric(v);
+            break;
+        case TokenKind::Tok_Void:
+            n = make(Op::Discard);
+            n->num = Undefined;
+            n->list.push_back(v);
+            return n;
+        default:
+            return failValue("unsupported unary operator");
+        }
+        n->a = v;
+        return n;
+    }
+    if (auto b = ast_cast<BinaryExpr>(e))
+    {
+        if (b->op == TokenKind::Tok_LogicalAnd || b->op == TokenKind::Tok_LogicalOr || b->op == TokenKind::Tok_NullCoalesce)
+            return lowerLogical(b->op, b->lhs, b->rhs);
+        const Node *l = lowerExpr(b->lhs);
+        if (!l)
+            return nullptr;
+        const Node *r = lowerExpr(b->rhs);
+        if (!r)
+            return nullptr;
+        return lowerArithmetic(b->op, l, r);
+    }
+    if (auto a = ast_cast<AssignExpr>(e))
+        return lowerAssign(a);
+    if (auto c = ast_cast<ConditionalExpr>(e))
+    {
+        const Node *cond = lowerExpr(c->cond);
+        if (!cond)
+            return nullptr;
+        const Node *t = lowerExpr(c->consequent);
+        if (!t)
+            return nullptr;
+        const Node *f = lowerExpr(c->alternate);
+        if (!f)
+            return nullptr;
+        Node *n = make(Op::Conditional, t->kind == f->kind ? t->kind : Kind::Number);
+        n->a = cond;
+        n->b = t;
+        n->c = f;
+        return n;
+    }
+    if (auto q = ast_cast<SequenceExpr>(e))
+    {
+        if (q->exprs.empty())
+            return failValue("unsupported expression");
+        Node *n = make(Op::Sequence);
+        for (const auto &x : q->exprs)
+        {
+            const Node *v = lowerExpr(x);
+            if (!v)
+                return nullptr;
+            n->list.push_back(v);
+        }
+        n->kind = n->list.back()->kind;
+        return n;
+    }
+    if (auto o = ast_cast<ObjectExpr>(e))
+        return failValue("object values can only be printed or bound by top-level declarations (" + where(o->pos) + ")");
+    if (auto ix = ast_cast<IndexExpr>(e))
+        return failValue("index expressions are not supported yet (" + where(ix->pos) + ")");
+    if (auto fn = ast_cast<FunctionExpr>(e))
+        return failValue("function expressions are not supported yet (" + where(fn->pos) + ")");
+    if (auto raw = ast_cast<RawExpr>(e))
+        return failValue("unsupported expression at " + where(raw->pos));
+    return failValue("unsupported expression");
+}
+
+const Node *Lowering::lowerArithmetic(TokenKind op, const Node *l, const Node *r)
+{
+    Op code;
+    Kind kind = Kind::Number;
+    switch (op)
+    {
+    case TokenKind::Tok_IdentityEquals:
+    case TokenKind::Tok_IdentityNotEquals:
+        if (l->kind != r->kind)
+        {
+            // Both operands still run for their side effects
+            Node *n = make(Op::Discard, Kind::Bool);
+            n->num = op == TokenKind::Tok_IdentityNotEquals;
+            n->list = {l, r};
+            return n;
+        }
+        code = op == TokenKind::Tok_IdentityEquals ? Op::Eq : Op::Ne;
+        kind = Kind::Bool;
+        break;
+    case TokenKind::Tok_Equals:
+        code = Op::Eq;
+        kind = Kind::Bool;
+        break;
+    case TokenKind::Tok_NotEquals:
+        code = Op::Ne;
+        kind = Kind::Bool;
+        break;
+    case TokenKind::Tok_Plus:
+        code = Op::Add;
+        break;
+    case TokenKind::Tok_Minus:
+        code = Op::Sub;
+        break;
+    case TokenKind::Tok_Multiply:
+        code = Op::Mul;
+        break;
+    case TokenKind::Tok_Divide:
+        code = Op::Div;
+        break;
+    case TokenKind::Tok_Modulus:
+        code = Op::Mod;
+        break;
+    case TokenKind::Tok_Power:
+        code = Op::Pow;
+        break;
+    case TokenKind::Tok_LessThan:
+        code = Op::Lt;
+        kind = Kind::Bool;
+        break;
+    case TokenKind::Tok_MoreThan:
+        code = Op::Gt;
+        kind = Kind::Bool;
+        break;
+    case TokenKind::Tok_LessThanEquals:
+        code = Op::Le;
+        kind = Kind::Bool;
+        break;
+    case TokenKind::Tok_GreaterThanEquals:
+        code = Op::Ge;
+        kind = Kind::Bool;
+        break;
+    case TokenKind::Tok_BitAnd:
+        code = Op::BitAnd;
+        break;
+    case TokenKind::Tok_BitOr:
+        code = Op::BitOr;
+        break;
+    case TokenKind::Tok_BitXor:
+        code = Op::BitXor;
+        break;
+    case TokenKind::Tok_LeftShiftArithmetic:
+        code = Op::Shl;
+        break;
+    case TokenKind::Tok_RightShiftArithmetic:
+        code = Op::Sar;
+        break;
+    case TokenKind::Tok_RightShiftLogical:
+        code = Op::Shr;
+        break;
+    default:
+        return failValue("unsupported binary operator");
+    }
+    if (code == Op::Eq || code == Op::Ne)
+    {
+        Node *n = make(l->nullish || r->nullish ? Op::NullishEq : code, kind);
+        n->tok = op;
+        n->a = l;
+        n->b = r;
+        return n;
+    }
+    Node *n = make(code, kind);
+    n->a = numeric(l);
+    n->b = numeric(r);
+    return n;
+}
+
+const Node *Lowering::lowerLogical(TokenKind op, const Expr *lhs, const Expr *rhs)
+{
+    const Node *l = lowerExpr(lhs);
+    if (!l)
+        return nullptr;
+    if (op == TokenKind::Tok_NullCoalesce && !l->nullish)
+        return l; // booleans and most numbers are never nullish; codegen never lowers rhs
+    bool boolResult = l->kind == Kind::Bool && Info.isBoolExpr(rhs, {});
+    Kind kind = boolResult ? Kind::Bool : Kind::Number;
+    const Node *r = lowerExpr(rhs);
+    if (!r)
+        return nullptr;
+    Node *n = make(Op::Logical, kind);
+    n->tok = op;
+    n->a = l;
+    n->b = convert(r, kind);
+    return n;
+}
+
+const Node *Lowering::lowerAssign(const AssignExpr *a)
+{
+    auto id = ast_cast<IdentifierExpr>(a->target);
+    if (!id)
+        return failValue("only plain variables can be assigned to yet");
+    const Slot *var = lookup(id->name);
+    if (!var)
+    {
+        if (Info.consts.count(id->name))
+            return failValue("cannot assign to string or object constant '" + std::string(id->name) + "'");
+        return failValue("assignment to undeclared variable '" + std::string(id->name) + "'");
+    }
+    Slot target = *var;
+    const Node *value;
+    if (a->op == TokenKind::Tok_Assign)
+        value = lowerExpr(a->value);
+    else
+    {
+        TokenKind op = compound_operator(a->op);
+        if (op == TokenKind::Tok_Invalid)
+            return failValue("unsupported assignment operator");
+        if (op == TokenKind::Tok_NullCoalesce)
+            value = lowerLogical(op, id, a->value);
+        else
+        {
+            // the current value is read before the right-hand side runs
+            Node *current = access(Op::Load, target);
+            current->nullish = target.kind == Kind::Number && Info.mayBeNullish(id, CurDecl);
+            const Node *rhs = lowerExpr(a->value);
+            if (!rhs)
+                return nullptr;
+            value = lowerArithmetic(op, current, rhs);
+        }
+    }
+    if (!value)
+        return nullptr;
+    if (target.kind != value->kind)
+        return failValue(target.kind == Kind::Bool
+                             ? "cannot store a number in boolean variable '" + std::string(id->name) + "'"
+                             : "cannot store a boolean in number variable '" + std::string(id->name) + "'");
+    Node *store = access(Op::Store, target);
+    store->a = value;
+    return store;
+}
+
+const Node *Lowering::lowerUpdate(const UnaryExpr *u)
+{
+    auto id = ast_cast<IdentifierExpr>(u->operand);
+    if (!id)
+        return failValue("increment and decrement need a plain variable operand");
+    const Slot *var = lookup(id->name);
+    if (!var)
+        return failValue("unknown identifier '" + std::string(id->name) + "'");
+    if (var->kind != Kind::Number)
+        return failValue("cannot increment boolean variable '" + std::string(id->name) + "'");
+    Node *n = access(Op::Update, *var);
+    n->tok = u->op;
+    n->flag = u->prefix;
+    return n;
+}
+
+const Node *Lowering::lowerCall(const CallExpr *c)
+{
+    std::vector<const Node *> args;
+    for (const auto &a : c->args)
+    {
+        const Node *v = lowerExpr(a);
+        if (!v)
+            return nullptr;
+        args.push_back(v);
+    }
+
+    if (auto id = ast_cast<IdentifierExpr>(c->callee))
+    {
+        auto it = C.functionIndex.find(id->name);
+        if (it == C.functionIndex.end())
+            return failValue("call to unknown function '" + std::string(id->name) + "'");
+        const std::vector<Kind> &params = C.functions[it->second].params;
+        for (size_t i = 0; i < params.size() && i < args.size(); ++i)
+        {
+            if (params[i] != args[i]->kind)
+                return failValue("argument " + std::to_string(i + 1) + " of '" + std::string(id->name) +
+                                 (params[i] == Kind::Bool ? "' must be a boolean" : "' must be a number"));
+        }
+        Node *n = make(Op::Call, C.functions[it->second].ret);
+        n->index = it->second;
+        n->list = std::move(args);
+        if (CurFn)
+            CurFn->callees.insert(it->second);
+        return n;
+    }
+
+    auto m = ast_cast<MemberExpr>(c->callee);
+    auto obj = m ? ast_cast<IdentifierExpr>(m->object) : nullptr;
+    Node *n = nullptr;
+    if (obj && obj->name == "Date" && m->property == "now")
+        n = make(Op::DateNow);
+    else if (obj && obj->name == "Math")
+    {
+        std::string_view fn = m->property;
+        static const std::map<std::string_view, double (*)(double)> unary = {
+            {"floor", [](double x) { return std::floor(x); }},
+            {"ceil", [](double x) { return std::ceil(x); }},
+            {"trunc", [](double x) { return std::trunc(x); }},
+            {"sqrt", [](double x) { return std::sqrt(x); }},
+            {"abs", [](double x) { return std::fabs(x); }},
+            {"sin", [](double x) { return std::sin(x); }},
+            {"cos", [](double x) { return std::cos(x); }},
+            {"exp", [](double x) { return std::exp(x); }},
+            {"log", [](double x) { return std::log(x); }},
+        };
+        auto u = unary.find(fn);
+        if (u != unary.end())
+        {
+            n = make(Op::Math);
+            n->math = u->second;
+        }
+        else if (fn == "round")
+            n = make(Op::Round);
+        else if (fn == "pow")
+            n = make(Op::MathPow);
+        else if (fn == "min" || fn == "max")
+            n = make(fn == "min" ? Op::Min : Op::Max);
+        else
+            return failValue("unsupported builtin 'Math." + std::string(fn) + "'");
+    }
+    else
+        return failValue("unsupported call expression");
+    // arguments are evaluated even when the builtin ignores them
+    for (const Node *&arg : args)
+        arg = numeric(arg);
+    n->list = std::move(args);
+    return n;
+}
+
+int64_t clock_nanos()
+{
+    using namespace std::chrono;
+    return duration_cast<nanoseconds>(steady_clock::now().time_since_epoch()).count();
+}
+
+bool truthy(double v) { return v != 0 && !std::isnan(v); }
+
+int32_t to_int32(double d)
+{
+    // fptosi.sat to i64, then truncated to 32 bits, as codegen does
+    int64_t i;
+    if (std::isnan(d))
+        i = 0;
+    else if (d >= 9223372036854775807.0)
+        i = std::numeric_limits<int64_t>::max();
+    else if (d <= -9223372036854775808.0)
+        i = std::numeric_limits<int64_t>::min();
+    else
+        i = static_cast<int64_t>(d);
+    return static_cast<int32_t>(static_cast<uint32_t>(static_cast<uint64_t>(i)));
+}
+
+enum class Flow
+{
+    Normal,
+    Break,
+    Continue,
+    Return,
+    Restart, // rerun the current function natively
+};
+
+} // namespace
+
+struct AstTier::State : Code
+{
+    std::function<void()> OnHot;
+    bool HotReported = false;
+    std::atomic<NativeMain> Main{nullptr};
+    uint32_t MainIterations = 0;
+    int64_t NativeNanos = 0; // time spent in native calls
+    std::vector<double> Globals;
+    std::vector<double> Stack; // every frame's slots
+
+    struct Frame
+    {
+        size_t base;
+        Function *fn; // null for the top level
+        OongRtPosition start; // on entry, for restarts
+        double ret;
+        int64_t nativeAtEntry;
+        int64_t decidedAt = -1; // when native code was first seen
+        int64_t nativeAtDecision = 0;
+        uint32_t polls = 0;
+    };
+
+    double &slot(const Node *n, Frame &f) { return n->global ? Globals[n->index] : Stack[f.base + n->index]; }
+    double eval(const Node *n, Frame &f);
+    double call(const Node *n, Frame &f);
+    double callNative(NativeFn native, const double *args)
+    {
+        int64_t start = clock_nanos();
+        double result = native(args);
+        NativeNanos += clock_nanos() - start;
+        return result;
+    }
+    Flow exec(const Node *n, Frame &f);
+    Flow execList(const std::vector<const Node *> &list, Frame &f)
+    {
+        for (const Node *n : list)
+            if (Flow flow = exec(n, f); flow != Flow::Normal)
+                return flow;
+        return Flow::Normal;
+    }
+    // Loop back-edge: counts the iteration and says whether to restart. The
+    // native rerun does everything since entry again; its writes and clock
+    // reads up to this point are replayed by the runtime. Native calls made
+    // since entry are repeated too, so if there were any the loop only
+    // restarts once it has spent as long being interpreted as those calls
+    // take: that way a restart at most doubles the time spent, and a loop
+    // whose time goes into native calls anyway never restarts.
+    bool backEdge(Frame &f)
+    {
+        uint32_t &count = f.fn ? f.fn->iterations : MainIterations;
+        if (++count == HotIterations)
+            hot();
+        bool native = f.fn ? f.fn->native.load(std::memory_order_acquire) != nullptr
+                           : Main.load(std::memory_order_acquire) != nullptr;
+        if (!native)
+            return false;
+        if (f.decidedAt < 0)
+        {
+            if (NativeNanos == f.nativeAtEntry)
+                return oong_rt_replay(f.start);
+            f.decidedAt = clock_nanos();
+            f.nativeAtDecision = NativeNanos;
+            return false;
+        }
+        if (++f.polls % 256 != 0)
+            return false;
+        int64_t repeated = NativeNanos - f.nativeAtEntry;
+        int64_t interpreted = clock_nanos() - f.decidedAt - (NativeNanos - f.nativeAtDecision);
+        return interpreted >= repeated && oong_rt_replay(f.start);
+    }
+    void hot()
+    {
+        if (HotReported)
+            return;
+        HotReported = true;
+        if (OnHot)
+            OnHot();
+    }
+    void print(const PrintLine &line, Frame &f);
+};
+
+double AstTier::State::eval(const Node *n, Frame &f)
+{
+    switch (n->op)
+    {
+    case Op::Const:
+        return n->num;
+    case Op::Load:
+        return slot(n, f);
+    case Op::Store:
+    {
+        double v = eval(n->a, f);
+        slot(n, f) = v;
+        return v;
+    }
+    case Op::Update:
+    {
+        double &s = slot(n, f);
+        double old = numeric(s);
+        double updated = n->tok == TokenKind::Tok_PlusPlus ? old + 1 : old - 1;
+        s = updated;
+        return n->flag ? updated : old;
+    }
+    case Op::Discard:
+        for (const Node *x : n->list)
+            eval(x, f);
+        return n->num;
+    case Op::Numeric:
+        return numeric(eval(n->a, f));
+    case Op::Neg:
+        return -eval(n->a, f);
+    case Op::Not:
+        return truthy(eval(n->a, f)) ? 0 : 1;
+    case Op::ToBool:
+        return truthy(eval(n->a, f)) ? 1 : 0;
+    case Op::BitNot:
+        return ~to_int32(eval(n->a, f));
+    case Op::Logical:
+    {
+        double l = eval(n->a, f);
+        bool takeRhs = n->tok == TokenKind::Tok_LogicalAnd  ? truthy(l)
+                       : n->tok == TokenKind::Tok_LogicalOr ? !truthy(l)
+                                                            : is_nullish(l);
+        return takeRhs ? eval(n->b, f) : l;
+    }
+    case Op::Conditional:
+        return truthy(eval(n->a, f)) ? eval(n->b, f) : eval(n->c, f);
+    case Op::Sequence:
+    {
+        double v = 0;
+        for (const Node *x : n->list)
+            v = eval(x, f);
+        return v;
+    }
+    case Op::Call:
+        return call(n, f);
+    case Op::Math:
+    case Op::Round:
+    case Op::MathPow:
+    case Op::Min:
+    case Op::Max:
+    case Op::DateNow:
+    {
+        // NaN if any argument is NaN; Math.min() is Infinity, Math.max() -Infinity
+        double first = NaN, second = NaN;
+        double acc = n->op == Op::Min ? std::numeric_limits<double>::infinity()
+                                      : -std::numeric_limits<double>::infinity();
+        for (size_t i = 0; i < n->list.size(); ++i)
+        {
+            double v = eval(n->list[i], f);
+            if (i == 0)
+                first = v;
+            else if (i == 1)
+                second = v;
+            if (!std::isnan(acc) && (n->op == Op::Min ? !(v >= acc) : !(v <= acc)))
+                acc = v;
+        }
+        switch (n->op)
+        {
+        case Op::Math:
+            return n->math(first);
+        case Op::Round:
+            return std::floor(first + 0.5);
+        case Op::MathPow:
+            return std::pow(first, second);
+        case Op::DateNow:
+            return oong_rt_date_now();
+        default:
+            return acc;
+        }
+    }
+    default:
+        break;
+    }
+
+    double a = eval(n->a, f), b = eval(n->b, f);
+    switch (n->op)
+    {
+    case Op::Add:
+        return a + b;
+    case Op::Sub:
+        return a - b;
+    case Op::Mul:
+        return a * b;
+    case Op::Div:
+        return a / b;
+    case Op::Mod:
+        return std::fmod(a, b);
+    case Op::Pow:
+        return std::pow(a, b);
+    case Op::Eq:
+        return a == b;
+    case Op::Ne:
+        return a != b;
+    case Op::Lt:
+        return a < b;
+    case Op::Gt:
+        return a > b;
+    case Op::Le:
+        return a <= b;
+    case Op::Ge:
+        return a >= b;
+    case Op::NullishEq:
+    {
+        // undefined and null equal each other (`===`: only themselves) and
+        // nothing else
+        bool loose = n->tok == TokenKind::Tok_Equals || n->tok == TokenKind::Tok_NotEquals;
+        bool la = is_nullish(a), rb = is_nullish(b);
+        bool eq = la || rb ? (loose ? la && rb : bits_of(a) == bits_of(b)) : a == b;
+        bool negate = n->tok == TokenKind::Tok_NotEquals || n->tok == TokenKind::Tok_IdentityNotEquals;
+        return eq != negate;
+    }
+    default:
+        break;
+    }
+    // ToInt32 on both operands, shift counts masked to 5 bits
+    int32_t x = to_int32(a), y = to_int32(b);
+    uint32_t count = static_cast<uint32_t>(y) & 31;
+    switch (n->op)
+    {
+    case Op::BitAnd:
+        return x & y;
+    case Op::BitOr:
+        return x | y;
+    case Op::BitXor:
+        return x ^ y;
+    case Op::Shl:
+        return static_cast<int32_t>(static_cast<uint32_t>(x) << count);
+    case Op::Sar:
+        return x >> count;
+    default:
+        // '>>>' yields an unsigned 32-bit result
+        return static_cast<uint32_t>(x) >> count;
+    }
+}
+
+double AstTier::State::call(const Node *n, Frame &f)
+{
+    Function &fn = functions[n->index];
+    // missing arguments are undefined (a boolean parameter always has one, see
+    // ProgramInfo::analyze), extra arguments are evaluated and dropped
+    size_t argc = n->list.size();
+    std::vector<double> heap;
+    double inlineArgs[8];
+    double *args = inlineArgs;
+    if (std::max<size_t>(argc, fn.arity) > std::size(inlineArgs))
+    {
+        heap.resize(std::max<size_t>(argc, fn.arity));
+        args = heap.data();
+    }
+    for (size_t i = 0; i < argc; ++i)
+        args[i] = eval(n->list[i], f);
+    for (size_t i = argc; i < fn.arity; ++i)
+        args[i] = Undefined;
+
+    if (++fn.calls == HotCalls)
+        hot();
+    if (NativeFn native = fn.native.load(std::memory_order_acquire))
+        return callNative(native, args);
+
+    size_t base = Stack.size();
+    Stack.resize(base + fn.slots, NaN);
+    std::copy(args, args + fn.arity, Stack.begin() + base);
+    Frame callee{base, &fn, oong_rt_position(), fn.ret == Kind::Bool ? 0 : Undefined, NativeNanos};
+    Flow flow = execList(fn.body, callee);
+    Stack.resize(base);
+    if (flow == Flow::Restart)
+        return callNative(fn.native.load(std::memory_order_acquire), args);
+    return callee.ret;
+}
+
+Flow AstTier::State::exec(const Node *n, Frame &f)
+{
+    if (!n)
+        return Flow::Normal;
+    switch (n->op)
+    {
+    case Op::Eval:
+        eval(n->a, f);
+        return Flow::Normal;
+    case Op::Block:
+        return execList(n->list, f);
+    case Op::If:
+        if (truthy(eval(n->a, f)))
+            return exec(n->b, f);
+        return exec(n->c, f);
+    case Op::While:
+        while (truthy(eval(n->a, f)))
+        {
+            Flow flow = exec(n->b, f);
+            if (flow == Flow::Break)
+                break;
+            if (flow == Flow::Return || flow == Flow::Restart)
+                return flow;
+            if (backEdge(f))
+                return Flow::Restart;
+        }
+        return Flow::Normal;
+    case Op::DoWhile:
+        for (;;)
+        {
+            Flow flow = exec(n->a, f);
+            if (flow == Flow::Break)
+                break;
+            if (flow == Flow::Return || flow == Flow::Restart)
+                return flow;
+            if (!truthy(eval(n->b, f)))
+                break;
+            if (backEdge(f))
+                return Flow::Restart;
+        }
+        return Flow::Normal;
+    case Op::For:
+        exec(n->a, f);
+        while (!n->b || truthy(eval(n->b, f)))
+        {
+            Flow flow = exec(n->d, f);
+            if (flow == Flow::Break)
+                break;
+            if (flow == Flow::Return || flow == Flow::Restart)
+                return flow;
+            if (n->c)
+                eval(n->c, f);
+            if (backEdge(f))
+                return Flow::Restart;
+        }
+        return Flow::Normal;
+    case Op::Return:
+        f.ret = eval(n->a, f);
+        return Flow::Return;
+    case Op::Break:
+        return Flow::Break;
+    case Op::Continue:
+        return Flow::Continue;
+    case Op::Print:
+        print(lines[n->index], f);
+        return Flow::Normal;
+    default:
+        return Flow::Normal;
+    }
+}
+
+void AstTier::State::print(const PrintLine &line, Frame &f)
+{
+    auto write = line.err ? oong_rt_write_err : oong_rt_write;
+    for (const auto &seg : line.segments)
+    {
+        double v = eval(seg.value, f);
+        if (!seg.text.empty())
+            write(seg.text.c_str());
+        // as many writes as codegen makes, so that replays line up
+        bool word = !seg.colored && is_nullish(v);
+        if (!seg.colored)
+            write(word ? "" : yellow.c_str());
+        if (seg.value->kind == Kind::Bool)
+            write(v != 0 ? "true" : "false");
+        else if (line.err)
+            oong_rt_write_number_err(v);
+        else
+            oong_rt_write_number(v);
+        if (!seg.colored)
+            write(word ? "" : reset.c_str());
+    }
+    if (line.plain)
+        (line.err ? oong_rt_write_line_err : oong_rt_write_line)(line.tail.c_str());
+    else if (!line.tail.empty())
+        write(line.tail.c_str());
+}
+
+AstTier::AstTier(std::unique_ptr<State> s) : S(std::move(s)) {}
+AstTier::~AstTier() = default;
+
+std::unique_ptr<AstTier> AstTier::prepare(const Program &prog, std::string_view source, std::string &why)
+{
+    ProgramInfo info;
+    if (!info.analyze(prog, source, why))
+        return nullptr;
+    auto state = std::make_unique<State>();
+    Lowering lowering(*state, info);
+    if (!lowering.run(prog))
+    {
+        why = lowering.Error;
+        return nullptr;
+    }
+    state->Globals = state->globals;
+    return std::unique_ptr<AstTier>(new AstTier(std::move(state)));
+}
+
+std::vector<std::string_view> AstTier::promotable() const
+{
+    std::vector<std::string_view> names;
+    for (const Function &fn : S->functions)
+        if (fn.promotable)
+            names.push_back(fn.name);
+    return names;
+}
+
+void AstTier::onHot(std::function<void()> callback) { S->OnHot = std::move(callback); }
+
+void AstTier::setNative(std::string_view function, NativeFn fn)
+{
+    auto it = S->functionIndex.find(function);
+    if (it != S->functionIndex.end() && S->functions[it->second].promotable)
+        S->functions[it->second].native.store(fn, std::memory_order_release);
+}
+
+void AstTier::setNativeMain(NativeMain fn) { S->Main.store(fn, std::memory_order_release); }
+
+int AstTier::run()
+{
+    int rc = 0;
+    auto body = [this, &rc]()
+    {
+        S->Stack.assign(S->mainSlots, NaN);
+        State::Frame top{0, nullptr, oong_rt_position(), NaN, 0};
+        oong_rt_replay_enable(true);
+        Flow flow = S->execList(S->main, top);
+        // nothing restarts from here on, so the runtime can let go of what
+        // it kept for replays
+        oong_rt_replay_enable(false);
+        // a top-level restart reruns the whole program natively
+        if (flow == Flow::Restart)
+            rc = S->Main.load(std::memory_order_acquire)();
+    };
+    llvm::thread runner(StackSize, body);
+    runner.join();
+    return rc;
+}
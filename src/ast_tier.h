@@ -0,0 +1,52 @@
+#pragma once
+#include <functional>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "ast.h"
+
+// Fast-start tier: runs a program from a resolved form of its AST, so short
+// scripts produce output without waiting for LLVM to initialize and compile
+// them. prepare() binds every name to a slot and checks the program against
+// the rules codegen applies; anything outside them is refused before a single
+// statement has run, and the caller uses the JIT instead.
+//
+// Functions count their calls and loop iterations. The first time a function
+// or top-level loop gets hot, the tier calls the onHot callback (on the
+// running thread, once); whoever compiles the program hands back native entry
+// points with setNative()/setNativeMain(), from any thread. Later calls of a
+// promoted function run natively. A hot loop can also move to native code
+// mid-run by rerunning its function (for top-level loops: the program)
+// natively from the start; the runtime replays the output and Date.now()
+// results of the part that already ran, so the restart cannot be observed.
+class AstTier
+{
+public:
+    // `double entry(const double *args)`: a function's native code taking its
+    // arguments as an array and returning its result as a number.
+    using NativeFn = double (*)(const double *args);
+    // The whole program's native entry (`int oong_main()`).
+    using NativeMain = int (*)();
+
+    // Null (with the reason in `why`) when the program must go to the JIT.
+    // `prog` must outlive the tier.
+    static std::unique_ptr<AstTier> prepare(const Program &prog, std::string_view source, std::string &why);
+    ~AstTier();
+
+    // Functions that may switch to native code: those that touch no top-level
+    // variable, directly or through the functions they call (the two tiers
+    // keep separate copies of those).
+    std::vector<std::string_view> promotable() const;
+    void onHot(std::function<void()> callback);
+    void setNative(std::string_view function, NativeFn fn);
+    void setNativeMain(NativeMain fn);
+
+    // Run the program; returns its exit code.
+    int run();
+
+private:
+    struct State;
+    explicit AstTier(std::unique_ptr<State> s);
+    std::unique_ptr<State> S;
+};
@@ -0,0 +1,1202 @@
+#include "codegen.h"
+#include "runtime.h"
+#include "semantics.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <map>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <llvm/IR/IRBuilder.h>
+#include <llvm/IR/Intrinsics.h>
+#include <llvm/IR/LLVMContext.h>
+#include <llvm/IR/Module.h>
+#include <llvm/Passes/PassBuilder.h>
+
+namespace
+{
+
+using Kind = ValueKind;
+
+struct TypedValue
+{
+    llvm::Value *v = nullptr;
+    Kind kind = Kind::Number;
+    bool nullish = false; // a number that may be undefined or null
+};
+
+// A runtime variable: an entry-block alloca or an internal global.
+struct Var
+{
+    llvm::Value *ptr;
+    Kind kind;
+};
+
+struct FunctionInfo
+{
+    const FunctionDecl *decl; // null for imported functions
+    llvm::Function *fn = nullptr;
+    Kind ret = Kind::Number;
+    std::vector<Kind> params; // `boolean` parameters are i1, the others double
+};
+
+class Emitter
+{
+public:
+    Emitter(llvm::Module &M, std::string_view source, const ModuleLinkage *linkage, bool deferErrors)
+        : Ctx(M.getContext()), M(M), B(M.getContext()), Src(source), Linkage(linkage), DeferErrors(deferErrors)
+    {
+    }
+
+    bool run(const Program &prog, const std::string &entryName);
+    std::string Error;
+
+private:
+    llvm::LLVMContext &Ctx;
+    llvm::Module &M;
+    llvm::IRBuilder<> B;
+    std::string_view Src;
+    const ModuleLinkage *Linkage;
+    bool DeferErrors;
+
+    // Names are interned AST strings, which outlive the emitter.
+    ProgramInfo Info;
+    const std::map<std::string_view, Value> &Consts = Info.consts;
+    std::map<std::string_view, Var> Globals;
+    std::vector<std::map<std::string_view, Var>> Scopes;
+    std::map<std::string_view, FunctionInfo> Functions;
+    std::map<std::string, llvm::Constant *> Strings;
+    struct LoopTargets
+    {
+        llvm::BasicBlock *breakTo;
+        llvm::BasicBlock *continueTo;
+    };
+    std::vector<LoopTargets> Loops;
+    FunctionInfo *CurFn = nullptr; // null while emitting the entry function
+    llvm::Function *CurLLVMFn = nullptr;
+
+    bool fail(const std::string &msg)
+    {
+        if (Error.empty())
+            Error = msg;
+        return false;
+    }
+    TypedValue failValue(const std::string &msg)
+    {
+        fail(msg);
+        return {};
+    }
+    std::string where(size_t pos) const { return Info.where(pos); }
+
+    llvm::Type *typeOf(Kind k) { return k == Kind::Bool ? B.getInt1Ty() : B.getDoubleTy(); }
+    llvm::Type *charPtrTy() { return llvm::PointerType::getUnqual(llvm::Type::getInt8Ty(Ctx)); }
+    llvm::Constant *nan() { return llvm::ConstantFP::getNaN(B.getDoubleTy()); }
+    llvm::Constant *tagged(uint64_t bits)
+    {
+        return llvm::ConstantFP::get(Ctx, llvm::APFloat(llvm::APFloat::IEEEdouble(), llvm::APInt(64, bits)));
+    }
+    llvm::Constant *undefinedValue() { return tagged(Value::UndefinedTag); }
+    llvm::Constant *nullValue() { return tagged(Value::NullTag); }
+    llvm::Constant *str(const std::string &s);
+    llvm::FunctionCallee runtime(const char *name, llvm::Type *ret, llvm::ArrayRef<llvm::Type *> params)
+    {
+        return M.getOrInsertFunction(name, llvm::FunctionType::get(ret, params, false));
+    }
+
+    bool foldObject(const ObjectExpr *o, Value &out) { return Info.foldObject(o, out, Error); }
+    // Whether `m` reads out of an object constant (see ProgramInfo::constMember).
+    bool readsConstant(const MemberExpr *m)
+    {
+        const IdentifierExpr *root = member_root(m);
+        return root && !lookup(root->name) && Consts.count(root->name);
+    }
+
+    bool isBoolExpr(const Expr *e, const std::map<std::string_view, Kind> &locals) const
+    {
+        return Info.isBoolExpr(e, locals);
+    }
+    bool mayBeNullish(const Expr *e) const { return Info.mayBeNullish(e, CurFn ? CurFn->decl : nullptr); }
+
+    Var *lookup(std::string_view name);
+    Var declare(std::string_view name, Kind kind);
+    llvm::AllocaInst *entryAlloca(Kind kind, std::string_view name);
+    void startDeadBlock();
+
+    TypedValue toNumber(TypedValue v);
+    llvm::Value *isNullish(llvm::Value *number);
+    TypedValue numeric(TypedValue v);
+    llvm::Value *toBool(TypedValue v);
+    TypedValue convert(TypedValue v, Kind to);
+
+    bool emitFunction(FunctionInfo &info);
+    bool emitStmt(const Stmt *s, bool topLevel = false);
+    bool emitVarDecl(const VarDeclStmt *v, bool topLevel);
+    bool emitPrint(const PrintStmt *ps);
+    TypedValue emitExpr(const Expr *e);
+    TypedValue emitValue(const Expr *e);
+    TypedValue emitBinary(TokenKind op, const Expr *lhs, const Expr *rhs);
+    TypedValue emitArithmetic(TokenKind op, TypedValue l, TypedValue r);
+    TypedValue emitLogical(TokenKind op, const Expr *lhs, const Expr *rhs);
+    TypedValue emitAssign(const AssignExpr *a);
+    TypedValue emitUpdate(const UnaryExpr *u);
+    TypedValue emitCall(const CallExpr *c);
+    TypedValue emitConditional(const ConditionalExpr *c);
+};
+
+llvm::Constant *Emitter::str(const std::string &s)
+{
+    auto it = Strings.find(s);
+    if (it != Strings.end())
+        return it->second;
+    auto *c = B.CreateGlobalStringPtr(s, ".str", 0, &M);
+    Strings[s] = c;
+    return c;
+}
+
+Var *Emitter::lookup(std::string_view name)
+{
+    for (auto it = Scopes.rbegin(); it != Scopes.rend(); ++it)
+    {
+        auto v = it->find(name);
+        if (v != it->end())
+            return &v->second;
+    }
+    auto g = Globals.find(name);
+    if (g != Globals.end())
+        return &g->second;
+    return nullptr;
+}
+
+llvm::AllocaInst *Emitter::entryAlloca(Kind kind, std::string_view name)
+{
+    llvm::IRBuilder<> entry(&CurLLVMFn->getEntryBlock(), CurLLVMFn->getEntryBlock().begin());
+    return entry.CreateAlloca(typeOf(kind), nullptr, name);
+}
+
+Var Emitter::declare(std::string_view name, Kind kind)
+{
+    Var v{entryAlloca(kind, name), kind};
+    Scopes.back()[name] = v;
+    return v;
+}
+
+void Emitter::startDeadBlock()
+{
+    // Statements after return/break/continue still need a block to go into.
+    B.SetInsertPoint(llvm::BasicBlock::Create(Ctx, "dead", CurLLVMFn));
+}
+
+TypedValue Emitter::toNumber(TypedValue v)
+{
+    if (v.kind == Kind::Number)
+        return v;
+    return {B.CreateUIToFP(v.v, B.getDoubleTy()), Kind::Number};
+}
+
+llvm::Value *Emitter::isNullish(llvm::Value *number)
+{
+    llvm::Value *bits = B.CreateBitCast(number, B.getInt64Ty());
+    return B.CreateOr(B.CreateICmpEQ(bits, B.getInt64(Value::UndefinedTag)),
+                      B.CreateICmpEQ(bits, B.getInt64(Value::NullTag)));
+}
+
+TypedValue Emitter::numeric(TypedValue v)
+{
+    v = toNumber(v);
+    if (!v.nullish)
+        return v;
+    // ToNumber: undefined is NaN, null is 0
+    llvm::Value *bits = B.CreateBitCast(v.v, B.getInt64Ty());
+    llvm::Value *n = B.CreateSelect(B.CreateICmpEQ(bits, B.getInt64(Value::NullTag)),
+                                    llvm::ConstantFP::get(B.getDoubleTy(), 0.0), v.v);
+    n = B.CreateSelect(B.CreateICmpEQ(bits, B.getInt64(Value::UndefinedTag)), nan(), n);
+    return {n, Kind::Number};
+}
+
+llvm::Value *Emitter::toBool(TypedValue v)
+{
+    if (v.kind == Kind::Bool)
+        return v.v;
+    // JS truthiness for numbers: neither 0 nor NaN (undefined and null are
+    // NaNs too)
+    return B.CreateFCmpONE(v.v, llvm::ConstantFP::get(B.getDoubleTy(), 0.0));
+}
+
+TypedValue Emitter::convert(TypedValue v, Kind to)
+{
+    if (to == Kind::Number)
+        return toNumber(v);
+    return {toBool(v), Kind::Bool};
+}
+
+bool Emitter::run(const Program &prog, const std::string &entryName)
+{
+    if (Linkage)
+        Info.link(*Linkage);
+    if (!Info.analyze(prog, Src, Error))
+        return false;
+    for (const auto &kv : Info.functions)
+    {
+        FunctionInfo &info = Functions[kv.first];
+        info = FunctionInfo{kv.second.decl, nullptr, kv.second.ret, kv.second.params};
+        std::vector<llvm::Type *> params;
+        for (Kind k : info.params)
+            params.push_back(typeOf(k));
+        auto *type = llvm::FunctionType::get(typeOf(info.ret), params, false);
+        if (Linkage && (info.decl->exported || Linkage->exportAll))
+            info.fn = llvm::Function::Create(type, llvm::Function::ExternalLinkage,
+                                             Linkage->exportPrefix + std::string(kv.first), M);
+        else
+            info.fn = llvm::Function::Create(type, llvm::Function::InternalLinkage, kv.first, M);
+    }
+    for (const auto &kv : Info.imports)
+    {
+        FunctionInfo &info = Functions[kv.first];
+        info = FunctionInfo{nullptr, nullptr, kv.second.ret, kv.second.params};
+        std::vector<llvm::Type *> params;
+        for (Kind k : info.params)
+            params.push_back(typeOf(k));
+        auto *type = llvm::FunctionType::get(typeOf(info.ret), params, false);
+        info.fn = llvm::Function::Create(type, llvm::Function::ExternalLinkage, kv.second.symbol, M);
+    }
+    // top-level variables used inside functions become internal globals;
+    // those of REPL entries are shared with the entries after them
+    for (const auto &kv : Info.globals)
+    {
+        llvm::Constant *init = kv.second == Kind::Bool ? static_cast<llvm::Constant *>(B.getFalse()) : nan();
+        const ExportedVariable *imported = nullptr;
+        if (Linkage)
+            if (auto it = Linkage->variables.find(kv.first); it != Linkage->variables.end())
+                imported = &it->second;
+        llvm::GlobalVariable *g;
+        if (imported)
+            g = new llvm::GlobalVariable(M, typeOf(kv.second), false, llvm::GlobalValue::ExternalLinkage, nullptr,
+                                         imported->symbol);
+        else if (Linkage && Linkage->exportAll)
+            g = new llvm::GlobalVariable(M, typeOf(kv.second), false, llvm::GlobalValue::ExternalLinkage, init,
+                                         Linkage->exportPrefix + std::string(kv.first));
+        else
+            g = new llvm::GlobalVariable(M, typeOf(kv.second), false, llvm::GlobalValue::InternalLinkage, init, kv.first);
+        Globals[kv.first] = Var{g, kv.second};
+    }
+
+    for (auto &kv : Functions)
+    {
+        if (kv.second.decl && !emitFunction(kv.second))
+        {
+            if (!DeferErrors)
+            {
+                Error = "function '" + std::string(kv.first) + "': " + Error;
+                return false;
+            }
+            // Only calls of the function are affected: its body reports the
+            // problem at run time so unrelated code still compiles.
+            auto *fn = kv.second.fn;
+            fn->deleteBody();
+            B.SetInsertPoint(llvm::BasicBlock::Create(Ctx, "entry", fn));
+            auto fatal = runtime("oong_rt_fatal", B.getVoidTy(), {charPtrTy()});
+            B.CreateCall(fatal, {str("function '" + std::string(kv.first) + "': " + Error)});
+            B.CreateUnreachable();
+            Error.clear();
+        }
+    }
+
+    auto *mainType = llvm::FunctionType::get(B.getInt32Ty(), false);
+    CurLLVMFn = llvm::Function::Create(mainType, llvm::Function::ExternalLinkage, entryName, M);
+    CurFn = nullptr;
+    B.SetInsertPoint(llvm::BasicBlock::Create(Ctx, "entry", CurLLVMFn));
+    Scopes.assign(1, {});
+    for (const auto &s : prog.statements)
+    {
+        if (ast_cast<FunctionDecl>(s))
+            continue;
+        if (!emitStmt(s, true))
+            return false;
+    }
+    B.CreateRet(B.getInt32(0));
+    return true;
+}
+
+bool Emitter::emitFunction(FunctionInfo &info)
+{
+    CurFn = &info;
+    CurLLVMFn = info.fn;
+    Loops.clear();
+    Scopes.assign(1, {});
+    B.SetInsertPoint(llvm::BasicBlock::Create(Ctx, "entry", info.fn));
+    size_t i = 0;
+    for (auto &arg : info.fn->args())
+    {
+        std::string_view name = info.decl->params[i];
+        arg.setName(name);
+        B.CreateStore(&arg, declare(name, info.params[i++]).ptr);
+    }
+    for (const auto &s : info.decl->body->statements)
+    {
+        if (!emitStmt(s))
+            return false;
+    }
+    // falling off the end returns undefined
+    if (!B.GetInsertBlock()->getTerminator())
+    {
+        if (info.ret == Kind::Bool)
+            B.CreateRet(B.getFalse()); // unreachable: analyze() requires a return
+        else
+            B.CreateRet(undefinedValue());
+    }
+    return true;
+}
+
+bool Emitter::emitVarDecl(const VarDeclStmt *v, bool topLevel)
+{
+    if (topLevel && Consts.count(v->name))
+        return true;
+    std::optional<Kind> declared = annotated_kind(v->type);
+    // a `boolean` one without an initializer is never read (see
+    // ProgramInfo::analyze)
+    TypedValue value = declared == Kind::Bool ? TypedValue{B.getFalse(), Kind::Bool}
+                                              : TypedValue{undefinedValue(), Kind::Number};
+    if (v->value)
+    {
+        value = emitExpr(v->value);
+        if (!value.v)
+            return false;
+    }
+    if (declared && value.kind != *declared)
+        return fail(*declared == Kind::Bool ? "cannot store a number in boolean variable '" + std::string(v->name) + "'"
+                                            : "cannot store a boolean in number variable '" + std::string(v->name) + "'");
+    if (topLevel && Globals.count(v->name))
+    {
+        Var &g = Globals[v->name];
+        if (g.kind != value.kind)
+            return fail(g.kind == Kind::Bool ? "cannot store a number in boolean variable '" + std::string(v->name) + "'"
+                                             : "cannot store a boolean in number variable '" + std::string(v->name) + "'");
+        B.CreateStore(value.v, g.ptr);
+        return true;
+    }
+    B.CreateStore(value.v, declare(v->name, value.kind).ptr);
+    return true;
+}
+
+bool Emitter::emitStmt(const Stmt *s, bool topLevel)
+{
+    if (!s)
+        return true;
+    if (auto v = ast_cast<VarDeclStmt>(s))
+        return emitVarDecl(v, topLevel);
+    if (auto p = ast_cast<PrintStmt>(s))
+        return emitPrint(p);
+    if (auto x = ast_cast<ExprStmt>(s))
+        return emitExpr(x->expr).v != nullptr;
+    if (auto b = ast_cast<BlockStmt>(s))
+    {
+        if (!b->declList)
+            Scopes.emplace_back();
+        for (const auto &c : b->statements)
+        {
+            if (!emitStmt(c, topLevel && b->declList))
+                return false;
+        }
+        if (!b->declList)
+            Scopes.pop_back();
+        return true;
+    }
+    if (auto r = ast_cast<ReturnStmt>(s))
+    {
+        if (!CurFn)
+            return fail("return outside of a function");
+        TypedValue value{undefinedValue(), Kind::Number};
+        if (r->value)
+        {
+            value = emitExpr(r->value);
+            if (!value.v)
+                return false;
+        }
+        if (CurFn->ret == Kind::Number && value.kind == Kind::Bool)
+            return fail("cannot return a boolean from a function that returns numbers");
+        if (CurFn->ret == Kind::Bool && !r->value)
+            B.CreateRet(B.getFalse());
+        else
+            B.CreateRet(convert(value, CurFn->ret).v);
+        startDeadBlock();
+        return true;
+    }
+    if (auto i = ast_cast<IfStmt>(s))
+    {
+        TypedValue cond = emitExpr(i->cond);
+        if (!cond.v)
+            return false;
+        auto *thenBB = llvm::BasicBlock::Create(Ctx, "if.then", CurLLVMFn);
+        auto *elseBB = i->otherwise ? llvm::BasicBlock::Create(Ctx, "if.else", CurLLVMFn) : nullptr;
+        auto *endBB = llvm::BasicBlock::Create(Ctx, "if.end", CurLLVMFn);
+        B.CreateCondBr(toBool(cond), thenBB, elseBB ? elseBB : endBB);
+        B.SetInsertPoint(thenBB);
+        Scopes.emplace_back();
+        if (!emitStmt(i->then))
+            return false;
+        Scopes.pop_back();
+        B.CreateBr(endBB);
+        if (elseBB)
+        {
+            B.SetInsertPoint(elseBB);
+            Scopes.emplace_back();
+            if (!emitStmt(i->otherwise))
+                return false;
+            Scopes.pop_back();
+            B.CreateBr(endBB);
+        }
+        B.SetInsertPoint(endBB);
+        return true;
+    }
+    if (auto w = ast_cast<WhileStmt>(s))
+    {
+        auto *condBB = llvm::BasicBlock::Create(Ctx, "while.cond", CurLLVMFn);
+        auto *bodyBB = llvm::BasicBlock::Create(Ctx, "while.body", CurLLVMFn);
+        auto *endBB = llvm::BasicBlock::Create(Ctx, "while.end", CurLLVMFn);
+        B.CreateBr(condBB);
+        B.SetInsertPoint(condBB);
+        TypedValue cond = emitExpr(w->cond);
+        if (!cond.v)
+            return false;
+        B.CreateCondBr(toBool(cond), bodyBB, endBB);
+        B.SetInsertPoint(bodyBB);
+        Loops.push_back({endBB, condBB});
+        Scopes.emplace_back();
+        if (!emitStmt(w->body))
+            return false;
+        Scopes.pop_back();
+        Loops.pop_back();
+        B.CreateBr(condBB);
+        B.SetInsertPoint(endBB);
+        return true;
+    }
+    if (auto d = ast_cast<DoWhileStmt>(s))
+    {
+        auto *bodyBB = llvm::BasicBlock::Create(Ctx, "do.body", CurLLVMFn);
+        auto *condBB = llvm::BasicBlock::Create(Ctx, "do.cond", CurLLVMFn);
+        auto *endBB = llvm::BasicBlock::Create(Ctx, "do.end", CurLLVMFn);
+        B.CreateBr(bodyBB);
+        B.SetInsertPoint(bodyBB);
+        Loops.push_back({endBB, condBB});
+        Scopes.emplace_back();
+        if (!emitStmt(d->body))
+            return false;
+        Scopes.pop_back();
+        Loops.pop_back();
+        B.CreateBr(condBB);
+        B.SetInsertPoint(condBB);
+        TypedValue cond = emitExpr(d->cond);
+        if (!cond.v)
+            return false;
+        B.CreateCondBr(toBool(cond), bodyBB, endBB);
+        B.SetInsertPoint(endBB);
+        return true;
+    }
+    if (auto f = ast_cast<ForStmt>(s))
+    {
+        Scopes.emplace_back();
+        if (!emitStmt(f->init))
+            return false;
+        auto *condBB = llvm::BasicBlock::Create(Ctx, "for.cond", CurLLVMFn);
+        auto *bodyBB = llvm::BasicBlock::Create(Ctx, "for.body", CurLLVMFn);
+        auto *updateBB = llvm::BasicBlock::Create(Ctx, "for.update", CurLLVMFn);
+        auto *endBB = llvm::BasicBlock::Create(Ctx, "for.end", CurLLVMFn);
+        B.CreateBr(condBB);
+        B.SetInsertPoint(condBB);
+        if (f->cond)
+        {
+            TypedValue cond = emitExpr(f->cond);
+            if (!cond.v)
+                return false;
+            B.CreateCondBr(toBool(cond), bodyBB, endBB);
+        }
+        else
+            B.CreateBr(bodyBB);
+        B.SetInsertPoint(bodyBB);
+        Loops.push_back({endBB, updateBB});
+        Scopes.emplace_back();
+        if (!emitStmt(f->body))
+            return false;
+        Scopes.pop_back();
+        Loops.pop_back();
+        B.CreateBr(updateBB);
+        B.SetInsertPoint(updateBB);
+        if (f->update && !emitExpr(f->update).v)
+            return false;
+        B.CreateBr(condBB);
+        B.SetInsertPoint(endBB);
+        Scopes.pop_back();
+        return true;
+    }
+    if (ast_cast<BreakStmt>(s) || ast_cast<ContinueStmt>(s))
+    {
+        bool isBreak = ast_cast<BreakStmt>(s) != nullptr;
+        if (Loops.empty())
+            return fail(isBreak ? "break outside of a loop" : "continue outside of a loop");
+        B.CreateBr(isBreak ? Loops.back().breakTo : Loops.back().continueTo);
+        startDeadBlock();
+        return true;
+    }
+    if (ast_cast<FunctionDecl>(s))
+        return fail("nested function declarations are not supported yet");
+    if (auto cd = ast_cast<ClassDecl>(s))
+        return fail("classes are not supported yet (" + where(cd->pos) + ")");
+    if (auto imp = ast_cast<ImportStmt>(s))
+    {
+        // resolved by the module graph, which put the bindings in Linkage
+        if (Linkage && topLevel)
+            return true;
+        return fail("import statements need a multi-file build: compile the entry module with oong -c (" +
+                    where(imp->pos) + ")");
+    }
+    if (auto raw = ast_cast<RawStmt>(s))
+        return fail("unsupported statement at " + where(raw->pos));
+    return fail("unsupported statement");
+}
+
+bool Emitter::emitPrint(const PrintStmt *ps)
+{
+    std::string color = print_color(ps->origin);
+    bool isConsole = ps->origin != TokenKind::Tok_Print;
+    // The line is built from constant text and runtime values; constant text is
+    // accumulated in `pending` and written out only when a runtime value follows.
+    bool err = prints_to_stderr(ps->origin);
+    auto write = runtime(err ? "oong_rt_write_err" : "oong_rt_write", B.getVoidTy(), {charPtrTy()});
+    auto writeNumber =
+        runtime(err ? "oong_rt_write_number_err" : "oong_rt_write_number", B.getVoidTy(), {B.getDoubleTy()});
+    std::string pending;
+    bool dynamic = false;
+    auto flush = [&]()
+    {
+        if (!pending.empty())
+            B.CreateCall(write, {str(pending)});
+        pending.clear();
+        dynamic = true;
+    };
+    auto emitRuntime = [&](TypedValue v, const std::string &prefix)
+    {
+        if (v.nullish)
+        {
+            // undefined and null are printed as words, without the color of
+            // numbers
+            pending += prefix;
+            flush();
+            llvm::Value *tag = isNullish(v.v);
+            B.CreateCall(write, {B.CreateSelect(tag, str(""), str(yellow))});
+            B.CreateCall(writeNumber, {v.v});
+            B.CreateCall(write, {B.CreateSelect(tag, str(""), str(reset))});
+            return;
+        }
+        if (v.kind == Kind::Bool)
+        {
+            pending += yellow;
+            flush();
+            B.CreateCall(write, {B.CreateSelect(v.v, str("true"), str("false"))});
+            pending = reset;
+            return;
+        }
+        pending += prefix + yellow;
+        flush();
+        B.CreateCall(writeNumber, {v.v});
+        pending = reset;
+    };
+
+    if (!color.empty())
+        pending += color;
+    for (size_t i = 0; i < ps->args.size(); ++i)
+    {
+        if (i > 0)
+            pending += " ";
+        const Expr *arg = ps->args[i];
+        if (auto lit = ast_cast<LiteralExpr>(arg))
+        {
+            switch (lit->kind)
+            {
+            case LiteralExpr::BOOL:
+                pending += yellow + std::string(lit->value) + reset;
+                break;
+            case LiteralExpr::NUMBER:
+                pending += yellow + format_number(parse_number_literal(std::string(lit->value))) + reset;
+                break;
+            case LiteralExpr::NUL:
+                pending += color + "null";
+                break;
+            case LiteralExpr::UNDEFINED:
+                pending += color + "undefined";
+                break;
+            default:
+                pending += color + std::string(lit->value);
+                break;
+            }
+            continue;
+        }
+        if (auto o = ast_cast<ObjectExpr>(arg))
+        {
+            Value obj;
+            if (!foldObject(o, obj))
+                return false;
+            pending += color;
+            serialize(obj, isConsole ? color : "", pending);
+            continue;
+        }
+        if (auto id = ast_cast<IdentifierExpr>(arg))
+        {
+            if (Var *v = lookup(id->name))
+            {
+                TypedValue value{B.CreateLoad(typeOf(v->kind), v->ptr, id->name), v->kind};
+                value.nullish = v->kind == Kind::Number && mayBeNullish(id);
+                emitRuntime(value, color);
+                continue;
+            }
+            auto it = Consts.find(id->name);
+            if (it != Consts.end())
+            {
+                pending += color;
+                serialize(it->second, isConsole ? color : "", pending);
+                continue;
+            }
+            if (id->name != "NaN" && id->name != "Infinity")
+            {
+                pending += color + "<undefined>";
+                continue;
+            }
+        }
+        if (auto m = ast_cast<MemberExpr>(arg); m && readsConstant(m))
+        {
+            Value v;
+            if (!Info.constMember(m, v, Error))
+                return false;
+            pending += print_constant(v, color, isConsole);
+            continue;
+        }
+        TypedValue value = emitExpr(arg);
+        if (!value.v)
+            return false;
+        emitRuntime(value, "");
+    }
+    if (!color.empty())
+        pending += reset;
+    if (!dynamic)
+    {
+        auto writeLine = runtime(err ? "oong_rt_write_line_err" : "oong_rt_write_line", B.getVoidTy(), {charPtrTy()});
+        B.CreateCall(writeLine, {str(pending)});
+        return true;
+    }
+    pending += "\n";
+    flush();
+    return true;
+}
+
+TypedValue Emitter::emitExpr(const Expr *e)
+{
+    TypedValue v = emitValue(e);
+    v.nullish = v.v && v.kind == Kind::Number && mayBeNullish(e);
+    return v;
+}
+
+TypedValue Emitter::emitValue(const Expr *e)
+{
+    if (auto lit = ast_cast<LiteralExpr>(e))
+    {
+        switch (lit->kind)
+        {
+        case LiteralExpr::NUMBER:
+            return {llvm::ConstantFP::get(B.getDoubleTy(), parse_number_literal(std::string(lit->value))), Kind::Number};
+        case LiteralExpr::BOOL:
+            return {B.getInt1(lit->value == "true"), Kind::Bool};
+        case LiteralExpr::NUL:
+            return {nullValue(), Kind::Number};
+        case LiteralExpr::UNDEFINED:
+            return {undefinedValue(), Kind::Number};
+        default:
+            return failValue("string values can only be printed or bound by top-level declarations");
+        }
+    }
+    if (auto id = ast_cast<IdentifierExpr>(e))
+    {
+        if (Var *v = lookup(id->name))
+            return {B.CreateLoad(typeOf(v->kind), v->ptr, id->name), v->kind};
+        if (id->name == "NaN")
+            return {nan(), Kind::Number};
+        if (id->name == "undefined")
+            return {undefinedValue(), Kind::Number};
+        if (id->name == "Infinity")
+            return {llvm::ConstantFP::getInfinity(B.getDoubleTy()), Kind::Number};
+        if (Consts.count(id->name))
+            return failValue("'" + std::string(id->name) + "' is a string or object constant and can only be printed");
+        if (Functions.count(id->name))
+            return failValue("functions are not first-class values yet ('" + std::string(id->name) + "')");
+        return failValue("unknown identifier '" + std::string(id->name) + "'");
+    }
+    if (auto m = ast_cast<MemberExpr>(e); m && readsConstant(m))
+    {
+        Value v;
+        if (!Info.constMember(m, v, Error))
+            return {};
+        if (v.type() == Value::Type::Number)
+            return {llvm::ConstantFP::get(B.getDoubleTy(), v.number()), Kind::Number};
+        if (v.type() == Value::Type::Bool)
+            return {B.getInt1(v.boolean()), Kind::Bool};
+        if (v.type() == Value::Type::Undefined)
+            return {undefinedValue(), Kind::Number};
+        if (v.type() == Value::Type::Null)
+            return {nullValue(), Kind::Number};
+        return failValue("'." + std::string(m->property) + "' is a string or object and can only be printed");
+    }
+    if (auto m = ast_cast<MemberExpr>(e))
+    {
+        auto obj = ast_cast<IdentifierExpr>(m->object);
+        if (obj && obj->name == "Math" && m->property == "PI")
+            return {llvm::ConstantFP::get(B.getDoubleTy(), M_PI), Kind::Number};
+        if (obj && obj->name == "Math" && m->property == "E")
+            return {llvm::ConstantFP::get(B.getDoubleTy(), M_E), Kind::Number};
+        return failValue("unsupported property access '." + std::string(m->property) + "'");
+    }
+    if (auto c = ast_cast<CallExpr>(e))
+        return emitCall(c);
+    if (auto u = ast_cast<UnaryExpr>(e))
+    {
+        if (u->op == TokenKind::Tok_PlusPlus || u->op == TokenKind::Tok_MinusMinus)
+            return emitUpdate(u);
+        TypedValue v = emitExpr(u->operand);
+        if (!v.v)
+            return v;
+        switch (u->op)
+        {
+        case TokenKind::Tok_Minus:
+            return {B.CreateFNeg(numeric(v).v), Kind::Number};
+        case TokenKind::Tok_Plus:
+            return numeric(v);
+        case TokenKind::Tok_Not:
+            return {B.CreateNot(toBool(v)), Kind::Bool};
+        case TokenKind::Tok_BitNot:
+        {
+            llvm::Value *i = B.CreateIntrinsic(llvm::Intrinsic::fptosi_sat, {B.getInt64Ty(), B.getDoubleTy()}, {numeric(v).v});
+            llvm::Value *r = B.CreateNot(B.CreateTrunc(i, B.getInt32Ty()));
+            return {B.CreateSIToFP(r, B.getDoubleTy()), Kind::Number};
+        }
+        case TokenKind::Tok_Void:
+            return {undefinedValue(), Kind::Number};
+        default:
+            return failValue("unsupported unary operator");
+        }
+    }
+    if (auto b = ast_cast<BinaryExpr>(e))
+    {
+        if (b->op == TokenKind::Tok_LogicalAnd || b->op == TokenKind::Tok_LogicalOr || b->op == TokenKind::Tok_NullCoalesce)
+            return emitLogical(b->op, b->lhs, b->rhs);
+        return emitBinary(b->op, b->lhs, b->rhs);
+    }
+    if (auto a = ast_cast<AssignExpr>(e))
+        return emitAssign(a);
+    if (auto c = ast_cast<ConditionalExpr>(e))
+        return emitConditional(c);
+    if (auto q = ast_cast<SequenceExpr>(e))
+    {
+        TypedValue last;
+        for (const auto &x : q->exprs)
+        {
+            last = emitExpr(x);
+            if (!last.v)
+                return last;
+        }
+        return last;
+    }
+    if (auto o = ast_cast<ObjectExpr>(e))
+        return failValue("object values can only be printed or bound by top-level declarations (" + where(o->pos) + ")");
+    if (auto ix = ast_cast<IndexExpr>(e))
+        return failValue("index expressions are not supported yet (" + where(ix->pos) + ")");
+    if (auto fn = ast_cast<FunctionExpr>(e))
+        return failValue("function expressions are not supported yet (" + where(fn->pos) + ")");
+    if (auto raw = ast_cast<RawExpr>(e))
+        return failValue("unsupported expression at " + where(raw->pos));
+    return failValue("unsupported expression");
+}
+
+TypedValue Emitter::emitBinary(TokenKind op, const Expr *lhs, const Expr *rhs)
+{
+    TypedValue l = emitExpr(lhs);
+    if (!l.v)
+        return l;
+    TypedValue r = emitExpr(rhs);
+    if (!r.v)
+        return r;
+    return emitArithmetic(op, l, r);
+}
+
+TypedValue Emitter::emitArithmetic(TokenKind op, TypedValue l, TypedValue r)
+{
+    switch (op)
+    {
+    case TokenKind::Tok_IdentityEquals:
+    case TokenKind::Tok_IdentityNotEquals:
+        if (l.kind != r.kind)
+            return {B.getInt1(op == TokenKind::Tok_IdentityNotEquals), Kind::Bool};
+        [[fallthrough]];
+    case TokenKind::Tok_Equals:
+    case TokenKind::Tok_NotEquals:
+    {
+        bool negate = op == TokenKind::Tok_NotEquals || op == TokenKind::Tok_IdentityNotEquals;
+        if (l.kind == Kind::Bool && r.kind == Kind::Bool)
+            return {negate ? B.CreateICmpNE(l.v, r.v) : B.CreateICmpEQ(l.v, r.v), Kind::Bool};
+        llvm::Value *a = toNumber(l).v, *b = toNumber(r).v;
+        if (!l.nullish && !r.nullish)
+            return {negate ? B.CreateFCmpUNE(a, b) : B.CreateFCmpOEQ(a, b), Kind::Bool};
+        // undefined and null equal each other (`===`: only themselves) and
+        // nothing else
+        llvm::Value *la = l.nullish ? isNullish(a) : B.getFalse();
+        llvm::Value *rb = r.nullish ? isNullish(b) : B.getFalse();
+        llvm::Value *same = op == TokenKind::Tok_Equals || op == TokenKind::Tok_NotEquals
+                                ? B.CreateAnd(la, rb)
+                                : B.CreateICmpEQ(B.CreateBitCast(a, B.getInt64Ty()), B.CreateBitCast(b, B.getInt64Ty()));
+        llvm::Value *eq = B.CreateSelect(B.CreateOr(la, rb), same, B.CreateFCmpOEQ(a, b));
+        return {negate ? B.CreateNot(eq) : eq, Kind::Bool};
+    }
+    default:
+        break;
+    }
+
+    llvm::Value *a = numeric(l).v, *b = numeric(r).v;
+    switch (op)
+    {
+    case TokenKind::Tok_Plus:
+        return {B.CreateFAdd(a, b), Kind::Number};
+    case TokenKind::Tok_Minus:
+        return {B.CreateFSub(a, b), Kind::Number};
+    case TokenKind::Tok_Multiply:
+        return {B.CreateFMul(a, b), Kind::Number};
+    case TokenKind::Tok_Divide:
+        return {B.CreateFDiv(a, b), Kind::Number};
+    case TokenKind::Tok_Modulus:
+        return {B.CreateFRem(a, b), Kind::Number};
+    case TokenKind::Tok_Power:
+        return {B.CreateBinaryIntrinsic(llvm::Intrinsic::pow, a, b), Kind::Number};
+    case TokenKind::Tok_LessThan:
+        return {B.CreateFCmpOLT(a, b), Kind::Bool};
+    case TokenKind::Tok_MoreThan:
+        return {B.CreateFCmpOGT(a, b), Kind::Bool};
+    case TokenKind::Tok_LessThanEquals:
+        return {B.CreateFCmpOLE(a, b), Kind::Bool};
+    case TokenKind::Tok_GreaterThanEquals:
+        return {B.CreateFCmpOGE(a, b), Kind::Bool};
+    case TokenKind::Tok_BitAnd:
+    case TokenKind::Tok_BitOr:
+    case TokenKind::Tok_BitXor:
+    case TokenKind::Tok_LeftShiftArithmetic:
+    case TokenKind::Tok_RightShiftArithmetic:
+    case TokenKind::Tok_RightShiftLogical:
+    {
+        // ToInt32 on both operands, shift counts masked to 5 bits
+        auto toInt32 = [&](llvm::Value *d)
+        {
+            llvm::Value *i = B.CreateIntrinsic(llvm::Intrinsic::fptosi_sat, {B.getInt64Ty(), B.getDoubleTy()}, {d});
+            return B.CreateTrunc(i, B.getInt32Ty());
+        };
+        llvm::Value *x = toInt32(a), *y = toInt32(b);
+        llvm::Value *count = B.CreateAnd(y, B.getInt32(31));
+        switch (op)
+        {
+        case TokenKind::Tok_BitAnd:
+            return {B.CreateSIToFP(B.CreateAnd(x, y), B.getDoubleTy()), Kind::Number};
+        case TokenKind::Tok_BitOr:
+            return {B.CreateSIToFP(B.CreateOr(x, y), B.getDoubleTy()), Kind::Number};
+        case TokenKind::Tok_BitXor:
+            return {B.CreateSIToFP(B.CreateXor(x, y), B.getDoubleTy()), Kind::Number};
+        case TokenKind::Tok_LeftShiftArithmetic:
+            return {B.CreateSIToFP(B.CreateShl(x, count), B.getDoubleTy()), Kind::Number};
+        case TokenKind::Tok_RightShiftArithmetic:
+            return {B.CreateSIToFP(B.CreateAShr(x, count), B.getDoubleTy()), Kind::Number};
+        default:
+            // '>>>' yields an unsigned 32-bit result
+            return {B.CreateUIToFP(B.CreateLShr(x, count), B.getDoubleTy()), Kind::Number};
+        }
+    }
+    default:
+        return failValue("unsupported binary operator");
+    }
+}
+
+TypedValue Emitter::emitLogical(TokenKind op, const Expr *lhs, const Expr *rhs)
+{
+    // Short-circuit: the result is one of the operands. When both operands are
+    // booleans the result stays boolean, otherwise both are numbers.
+    TypedValue l = emitExpr(lhs);
+    if (!l.v)
+        return l;
+    if (op == TokenKind::Tok_NullCoalesce && !l.nullish)
+        return l; // booleans and most numbers are never nullish
+    bool boolResult = l.kind == Kind::Bool && isBoolExpr(rhs, {});
+    if (!boolResult)
+        l = toNumber(l);
+    llvm::Value *takeRhs;
+    if (op == TokenKind::Tok_LogicalAnd)
+        takeRhs = toBool(l);
+    else if (op == TokenKind::Tok_LogicalOr)
+        takeRhs = B.CreateNot(toBool(l));
+    else
+        takeRhs = isNullish(l.v);
+    auto *lhsBB = B.GetInsertBlock();
+    auto *rhsBB = llvm::BasicBlock::Create(Ctx, "logic.rhs", CurLLVMFn);
+    auto *endBB = llvm::BasicBlock::Create(Ctx, "logic.end", CurLLVMFn);
+    B.CreateCondBr(takeRhs, rhsBB, endBB);
+    B.SetInsertPoint(rhsBB);
+    TypedValue r = emitExpr(rhs);
+    if (!r.v)
+        return r;
+    r = convert(r, l.kind);
+    rhsBB = B.GetInsertBlock();
+    B.CreateBr(endBB);
+    B.SetInsertPoint(endBB);
+    auto *phi = B.CreatePHI(typeOf(l.kind), 2);
+    phi->addIncoming(l.v, lhsBB);
+    phi->addIncoming(r.v, rhsBB);
+    return {phi, l.kind};
+}
+
+TypedValue Emitter::emitConditional(const ConditionalExpr *c)
+{
+    TypedValue cond = emitExpr(c->cond);
+    if (!cond.v)
+        return cond;
+    auto *thenBB = llvm::BasicBlock::Create(Ctx, "cond.then", CurLLVMFn);
+    auto *elseBB = llvm::BasicBlock::Create(Ctx, "cond.else", CurLLVMFn);
+    auto *endBB = llvm::BasicBlock::Create(Ctx, "cond.end", CurLLVMFn);
+    B.CreateCondBr(toBool(cond), thenBB, elseBB);
+
+    // Emit both arms first; the result kind is only known once both are lowered.
+    B.SetInsertPoint(thenBB);
+    TypedValue t = emitExpr(c->consequent);
+    if (!t.v)
+        return t;
+    auto *thenEnd = B.GetInsertBlock();
+    B.SetInsertPoint(elseBB);
+    TypedValue f = emitExpr(c->alternate);
+    if (!f.v)
+        return f;
+    auto *elseEnd = B.GetInsertBlock();
+    Kind kind = t.kind == f.kind ? t.kind : Kind::Number;
+
+    B.SetInsertPoint(thenEnd);
+    t = convert(t, kind);
+    B.CreateBr(endBB);
+    B.SetInsertPoint(elseEnd);
+    f = convert(f, kind);
+    B.CreateBr(endBB);
+    B.SetInsertPoint(endBB);
+    auto *phi = B.CreatePHI(typeOf(kind), 2);
+    phi->addIncoming(t.v, thenEnd);
+    phi->addIncoming(f.v, elseEnd);
+    return {phi, kind};
+}
+
+TypedValue Emitter::emitAssign(const AssignExpr *a)
+{
+    auto id = ast_cast<IdentifierExpr>(a->target);
+    if (!id)
+        return failValue("only plain variables can be assigned to yet");
+    Var *var = lookup(id->name);
+    if (!var)
+    {
+        if (Consts.count(id->name))
+            return failValue("cannot assign to string or object constant '" + std::string(id->name) + "'");
+        return failValue("assignment to undeclared variable '" + std::string(id->name) + "'");
+    }
+    Var target = *var;
+    TypedValue value;
+    if (a->op == TokenKind::Tok_Assign)
+        value = emitExpr(a->value);
+    else
+    {
+        TokenKind op = compound_operator(a->op);
+        if (op == TokenKind::Tok_Invalid)
+            return failValue("unsupported assignment operator");
+        TypedValue current{B.CreateLoad(typeOf(target.kind), target.ptr, id->name), target.kind,
+                           target.kind == Kind::Number && mayBeNullish(id)};
+        if (op == TokenKind::Tok_NullCoalesce)
+        {
+            // x ??= y assigns only when x is nullish
+            value = emitLogical(op, id, a->value);
+        }
+        else
+        {
+            TypedValue rhs = emitExpr(a->value);
+            if (!rhs.v)
+                return rhs;
+            value = emitArithmetic(op, current, rhs);
+        }
+    }
+    if (!value.v)
+        return value;
+    if (target.kind != value.kind)
+        return failValue(target.kind == Kind::Bool
+                             ? "cannot store a number in boolean variable '" + std::string(id->name) + "'"
+                             : "cannot store a boolean in number variable '" + std::string(id->name) + "'");
+    B.CreateStore(value.v, target.ptr);
+    return value;
+}
+
+TypedValue Emitter::emitUpdate(const UnaryExpr *u)
+{
+    auto id = ast_cast<IdentifierExpr>(u->operand);
+    if (!id)
+        return failValue("increment and decrement need a plain variable operand");
+    Var *var = lookup(id->name);
+    if (!var)
+        return failValue("unknown identifier '" + std::string(id->name) + "'");
+    if (var->kind != Kind::Number)
+        return failValue("cannot increment boolean variable '" + std::string(id->name) + "'");
+    llvm::Value *old = numeric({B.CreateLoad(B.getDoubleTy(), var->ptr, id->name), Kind::Number, mayBeNullish(id)}).v;
+    llvm::Value *one = llvm::ConstantFP::get(B.getDoubleTy(), 1.0);
+    llvm::Value *updated = u->op == TokenKind::Tok_PlusPlus ? B.CreateFAdd(old, one) : B.CreateFSub(old, one);
+    B.CreateStore(updated, var->ptr);
+    return {u->prefix ? updated : old, Kind::Number};
+}
+
+TypedValue Emitter::emitCall(const CallExpr *c)
+{
+    std::vector<TypedValue> values;
+    for (const auto &a : c->args)
+    {
+        TypedValue v = emitExpr(a);
+        if (!v.v)
+            return v;
+        values.push_back(v);
+    }
+
+    if (auto id = ast_cast<IdentifierExpr>(c->callee))
+    {
+        auto it = Functions.find(id->name);
+        if (it == Functions.end())
+            return failValue("call to unknown function '" + std::string(id->name) + "'");
+        // missing arguments are undefined (a boolean parameter always has
+        // one, see ProgramInfo::analyze), extra arguments are evaluated and
+        // dropped
+        const std::vector<Kind> &params = it->second.params;
+        std::vector<llvm::Value *> args(params.size());
+        for (size_t i = 0; i < params.size(); ++i)
+        {
+            if (i >= values.size())
+                args[i] = undefinedValue();
+            else if (params[i] == values[i].kind)
+                args[i] = values[i].v;
+            else
+                return failValue("argument " + std::to_string(i + 1) + " of '" + std::string(id->name) +
+                                 (params[i] == Kind::Bool ? "' must be a boolean" : "' must be a number"));
+        }
+        return {B.CreateCall(it->second.fn, args), it->second.ret};
+    }
+
+    auto m = ast_cast<MemberExpr>(c->callee);
+    auto obj = m ? ast_cast<IdentifierExpr>(m->object) : nullptr;
+    if (obj && obj->name == "Date" && m->property == "now")
+    {
+        auto now = runtime("oong_rt_date_now", B.getDoubleTy(), {});
+        return {B.CreateCall(now), Kind::Number};
+    }
+    if (obj && obj->name == "Math")
+    {
+        std::string_view fn = m->property;
+        std::vector<llvm::Value *> args;
+        for (const TypedValue &v : values)
+            args.push_back(numeric(v).v);
+        auto arg = [&](size_t i)
+        { return i < args.size() ? args[i] : static_cast<llvm::Value *>(nan()); };
+        static const std::map<std::string_view, llvm::Intrinsic::ID> unary = {
+            {"floor", llvm::Intrinsic::floor},
+            {"ceil", llvm::Intrinsic::ceil},
+            {"trunc", llvm::Intrinsic::trunc},
+            {"sqrt", llvm::Intrinsic::sqrt},
+            {"abs", llvm::Intrinsic::fabs},
+            {"sin", llvm::Intrinsic::sin},
+            {"cos", llvm::Intrinsic::cos},
+            {"exp", llvm::Intrinsic::exp},
+            {"log", llvm::Intrinsic::log},
+        };
+        auto u = unary.find(fn);
+        if (u != unary.end())
+            return {B.CreateUnaryIntrinsic(u->second, arg(0)), Kind::Number};
+        if (fn == "round")
+        {
+            llvm::Value *half = llvm::ConstantFP::get(B.getDoubleTy(), 0.5);
+            return {B.CreateUnaryIntrinsic(llvm::Intrinsic::floor, B.CreateFAdd(arg(0), half)), Kind::Number};
+        }
+        if (fn == "pow")
+            return {B.CreateBinaryIntrinsic(llvm::Intrinsic::pow, arg(0), arg(1)), Kind::Number};
+        if (fn == "min" || fn == "max")
+        {
+            // NaN if any argument is NaN; Math.min() is Infinity, Math.max() -Infinity
+            llvm::Value *acc = llvm::ConstantFP::getInfinity(B.getDoubleTy(), fn == "max");
+            for (llvm::Value *v : args)
+            {
+                llvm::Value *pick = fn == "min" ? B.CreateFCmpULT(v, acc) : B.CreateFCmpUGT(v, acc);
+                acc = B.CreateSelect(B.CreateFCmpUNO(acc, acc), acc, B.CreateSelect(pick, v, acc));
+            }
+            return {acc, Kind::Number};
+        }
+        return failValue("unsupported builtin 'Math." + std::string(fn) + "'");
+    }
+    return failValue("unsupported call expression");
+}
+
+} // namespace
+
+bool codegen_program(const Program &prog, llvm::Module &module, const std::string &entryName,
+                     std::string_view source, std::string &error, const ModuleLinkage *linkage, bool deferErrors)
+{
+    Emitter E(module, source, linkage, deferErrors);
+    if (!E.run(prog, entryName))
+    {
+        error = E.Error;
+        return false;
+    }
+    return true;
+}
+
+bool codegen_export_function(llvm::Module &module, std::string_view name, const std::string &exportName)
+{
+    llvm::Function *fn = module.getFunction(llvm::StringRef(name.data(), name.size()));
+    if (!fn || fn->isDeclaration())
+        return false;
+    llvm::IRBuilder<> B(module.getContext());
+    auto *type = llvm::FunctionType::get(B.getDoubleTy(), {llvm::PointerType::getUnqual(B.getDoubleTy())}, false);
+    auto *wrapper = llvm::Function::Create(type, llvm::Function::ExternalLinkage, exportName, module);
+    B.SetInsertPoint(llvm::BasicBlock::Create(module.getContext(), "entry", wrapper));
+    std::vector<llvm::Value *> args;
+    for (unsigned i = 0; i < fn->arg_size(); ++i)
+    {
+        llvm::Value *arg =
+            B.CreateLoad(B.getDoubleTy(), B.CreateConstInBoundsGEP1_64(B.getDoubleTy(), wrapper->getArg(0), i));
+        // a boolean parameter takes the argument's truthiness
+        if (fn->getArg(i)->getType()->isIntegerTy(1))
+            arg = B.CreateFCmpONE(arg, llvm::ConstantFP::get(B.getDoubleTy(), 0.0));
+        args.push_back(arg);
+    }
+    llvm::Value *result = B.CreateCall(fn, args);
+    if (result->getType()->isIntegerTy(1))
+        result = B.CreateUIToFP(result, B.getDoubleTy());
+    B.CreateRet(result);
+    return true;
+}
+
+void optimize_module(llvm::Module &module, unsigned optLevel, llvm::TargetMachine *target)
+{
+    if (optLevel == 0)
+        return;
+    llvm::LoopAnalysisManager LAM;
+    llvm::FunctionAnalysisManager FAM;
+    llvm::CGSCCAnalysisManager CGAM;
+    llvm::ModuleAnalysisManager MAM;
+    llvm::PassBuilder PB(target);
+    PB.registerModuleAnalyses(MAM);
+    PB.registerCGSCCAnalyses(CGAM);
+    PB.registerFunctionAnalyses(FAM);
+    PB.registerLoopAnalyses(LAM);
+    PB.crossRegisterProxies(LAM, FAM, CGAM, MAM);
+    llvm::OptimizationLevel level = optLevel == 1   ? llvm::OptimizationLevel::O1
+                                    : optLevel == 2 ? llvm::OptimizationLevel::O2
+                                                    : llvm::OptimizationLevel::O3;
+    llvm::ModulePassManager MPM = PB.buildPerModuleDefaultPipeline(level);
+    MPM.run(module, MAM);
+}
@@ -0,0 +1,38 @@
+#pragma once
+#include <string>
+#include <string_view>
+#include "ast.h"
+
+namespace llvm
+{
+class Module;
+class TargetMachine;
+}
+struct ModuleLinkage;
+
+// Lower a parsed Program into `module`, emitting `int entryName()` that runs
+// the program's top-level statements. Numbers are native doubles and booleans
+// are i1; string and object literals bound by top-level declarations are folded
+// into the printed text at compile time. `source` is only used for diagnostics.
+// Returns false and sets `error` when the program uses a construct the code
+// generator does not support yet. With `linkage` the program is one module of
+// a multi-file program: imported functions become external declarations and
+// exported ones external definitions (see ModuleLinkage); without it, import
+// statements are an error. With `deferErrors` a function the code generator
+// cannot lower still compiles, into a call of oong_rt_fatal, so the program
+// only fails (and exits) if it calls it; without it that is an error here too.
+bool codegen_program(const Program &prog, llvm::Module &module, const std::string &entryName,
+                     std::string_view source, std::string &error, const ModuleLinkage *linkage = nullptr,
+                     bool deferErrors = true);
+
+// Add `double exportName(const double *args)` to a module built by
+// codegen_program: it calls top-level function `name` with its arguments read
+// from the array (a `boolean` parameter gets the argument's truthiness) and
+// returns the result as a number (booleans as 0/1). Used
+// to enter compiled functions from the AST tier. Returns false if there is no
+// such function.
+bool codegen_export_function(llvm::Module &module, std::string_view name, const std::string &exportName);
+
+// Run LLVM's default per-module pipeline for optLevel (0-3) over `module`.
+// With a TargetMachine the passes use its cost model (vector widths etc.).
+void optimize_module(llvm::Module &module, unsigned optLevel, llvm::TargetMachine *target = nullptr);
@@ -1,145 +1,396 @@
 #include "compiler.h"
 #include <iostream>
-#include <fstream>
-#include <iterator>
 #include <string>
 #include <filesystem>
+#include <functional>
 #include <optional>
-#include <regex>
+#include <thread>
+#include <vector>
+
+#include "modules.h"
+#include "codegen.h"
+#include "object_cache.h"
+#include "stats.h"
 
 #include <llvm/IR/LLVMContext.h>
 #include <llvm/IR/Module.h>
-#include <llvm/IR/IRBuilder.h>
 #include <llvm/IR/Verifier.h>
 #include <llvm/Support/raw_ostream.h>
 #include <llvm/Support/TargetSelect.h>
 #include <llvm/TargetParser/Host.h>
 #include <llvm/Target/TargetMachine.h>
+#include <llvm/MC/MCSubtargetInfo.h>
 #include <llvm/MC/TargetRegistry.h>
 #include <llvm/Support/FileSystem.h>
 #include <llvm/Support/ToolOutputFile.h>
 #include <llvm/TargetParser/Triple.h>
+#include <llvm/TargetParser/SubtargetFeature.h>
+#include <llvm/ADT/StringMap.h>
 #include <llvm/IR/LegacyPassManager.h>
+#include <llvm/IR/IRBuilder.h>
+#include <llvm/Bitcode/BitcodeReader.h>
+#include <llvm/Bitcode/BitcodeWriter.h>
+#include <llvm/Linker/Linker.h>
+#include <llvm/Support/MemoryBuffer.h>
+#include <llvm/Support/Program.h>
 
-int run_compiler(const std::string &inputPath, const std::string &outPath) {
-    std::string content;
-    std::ifstream in(inputPath);
-    if (!in) { std::cerr << "Could not open file: " << inputPath << "\n"; return 2; }
-    content.assign((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+namespace
+{
 
-    std::regex r(R"(^\s*print\s*\(\s*([0-9]+)\s*\)\s*$)", std::regex::ECMAScript);
-    std::smatch m;
-    if (!content.empty() && std::regex_search(content, m, r) && m.size() >= 2) {
-        std::string val = m[1].str();
-        std::filesystem::path outp = outPath.empty() ? std::filesystem::path("a.exe") : std::filesystem::path(outPath);
+llvm::CodeGenOptLevel codegenOptLevel(unsigned optLevel)
+{
+    switch (optLevel)
+    {
+    case 0: return llvm::CodeGenOptLevel::None;
+    case 1: return llvm::CodeGenOptLevel::Less;
+    case 2: return llvm::CodeGenOptLevel::Default;
+    default: return llvm::CodeGenOptLevel::Aggressive;
+    }
+}
 
-        // Build LLVM module
-        llvm::LLVMContext ctx;
-        auto module = std::make_unique<llvm::Module>("oong_module", ctx);
-        llvm::IRBuilder<> builder(ctx);
-
-        std::vector<llvm::Type*> printf_arg_types;
-        printf_arg_types.push_back(llvm::PointerType::getUnqual(llvm::Type::getInt8Ty(ctx)));
-        auto printf_type = llvm::FunctionType::get(llvm::Type::getInt32Ty(ctx), printf_arg_types, true);
-        auto printf_func = llvm::Function::Create(printf_type, llvm::Function::ExternalLinkage, "printf", module.get());
-
-        auto main_type = llvm::FunctionType::get(llvm::Type::getInt32Ty(ctx), false);
-        auto main_func = llvm::Function::Create(main_type, llvm::Function::ExternalLinkage, "main", module.get());
-        auto bb = llvm::BasicBlock::Create(ctx, "entry", main_func);
-        builder.SetInsertPoint(bb);
-
-        auto format_str = builder.CreateGlobalStringPtr("%d\n");
-        int intval = 0;
-        try { intval = std::stoi(val); } catch (...) { intval = 0; }
-        auto const_val = llvm::ConstantInt::get(llvm::Type::getInt32Ty(ctx), intval);
-        builder.CreateCall(printf_func, {format_str, const_val});
-        builder.CreateRet(llvm::ConstantInt::get(llvm::Type::getInt32Ty(ctx), 0));
-
-        // initialize native target
-        llvm::InitializeNativeTarget();
-        llvm::InitializeNativeTargetAsmPrinter();
-        llvm::InitializeNativeTargetAsmParser();
+// The runtime (src/runtime.cpp) is built as a static library next to the oong
+// executable; compiled programs are linked against it.
+std::filesystem::path findRuntimeLibrary()
+{
+    std::string exe = llvm::sys::fs::getMainExecutable(nullptr, reinterpret_cast<void *>(&run_compiler));
+    std::filesystem::path dir = std::filesystem::path(exe).parent_path();
+    for (const char *name : {"oong_runtime.lib", "liboong_runtime.a"})
+        if (std::filesystem::exists(dir / name))
+            return dir / name;
+    return {};
+}
 
-        auto targetTriple = llvm::sys::getDefaultTargetTriple();
-        module->setTargetTriple(targetTriple);
+std::optional<llvm::CodeModel::Model> codeModel(const std::string &name, bool &ok)
+{
+    ok = true;
+    if (name.empty()) return std::nullopt;
+    if (name == "tiny") return llvm::CodeModel::Tiny;
+    if (name == "small") return llvm::CodeModel::Small;
+    if (name == "kernel") return llvm::CodeModel::Kernel;
+    if (name == "medium") return llvm::CodeModel::Medium;
+    if (name == "large") return llvm::CodeModel::Large;
+    ok = false;
+    return std::nullopt;
+}
 
-        std::string targetErr;
-        const llvm::Target *target = llvm::TargetRegistry::lookupTarget(targetTriple, targetErr);
-        if (!target) { std::cerr << "Target lookup failed: " << targetErr << "\n"; return 5; }
+// "native" expands to the host CPU and every feature it reports; -mattr
+// entries come last so they can turn host features off again.
+void resolveTarget(const CompileOptions &options, std::string &cpu, std::string &features)
+{
+    llvm::SubtargetFeatures f;
+    cpu = options.cpu;
+    if (cpu == "native")
+    {
+        cpu = llvm::sys::getHostCPUName().str();
+        llvm::StringMap<bool> host;
+        if (llvm::sys::getHostCPUFeatures(host))
+            for (const auto &h : host)
+                f.AddFeature(h.getKey(), h.getValue());
+    }
+    llvm::SubtargetFeatures extra(options.features);
+    for (const std::string &attr : extra.getFeatures())
+        f.AddFeature(attr);
+    features = f.getString();
+}
 
-        std::string CPU = "generic";
-        std::string features = "";
-        llvm::TargetOptions opt;
-        std::optional<llvm::Reloc::Model> RM = std::nullopt;
-        std::unique_ptr<llvm::TargetMachine> targetMachine(target->createTargetMachine(targetTriple, CPU, features, opt, RM));
-        module->setDataLayout(targetMachine->createDataLayout());
+std::string quote(const std::filesystem::path &p)
+{
+    return "\"" + p.string() + "\"";
+}
 
-        std::string objExt = (targetTriple.find("windows") != std::string::npos) ? ".obj" : ".o";
-        std::filesystem::path objPath = outp.parent_path();
-        if (objPath.empty()) objPath = std::filesystem::current_path();
-        std::string stem = outp.stem().string();
-        objPath /= (stem + objExt);
+// the optimizer reads the target from each function, not the TargetMachine
+void setFunctionTarget(llvm::Module &module, const std::string &cpu, const std::string &features)
+{
+    for (llvm::Function &fn : module)
+    {
+        if (fn.isDeclaration()) continue;
+        fn.addFnAttr("target-cpu", cpu);
+        if (!features.empty()) fn.addFnAttr("target-features", features);
+    }
+}
 
-        std::error_code EC;
+// Lower the modules of a multi-file program. Each module is lowered and
+// optimized on its own, `threads` at a time, in a context of its own, unless
+// the cache still has what an earlier build made of it (see
+// ModuleGraph::Module::fingerprint). Normally the results come back as
+// bitcode and are linked into `out`, and everything but main() is then
+// internal, so optimizing the linked module inlines across module boundaries.
+// With `objects`, each module is compiled to an object of its own instead,
+// which ends up there in evaluation order, and `out` only gets main(). Either
+// way main() runs every module's top-level code in evaluation order. Returns 0
+// or the exit code to fail with.
+int lowerModules(ModuleGraph &graph, unsigned threads, const CompileOptions &options,
+                 const std::function<std::unique_ptr<llvm::TargetMachine>()> &createTargetMachine,
+                 const std::string &cpu, const std::string &features, llvm::Module &out,
+                 std::vector<llvm::SmallVector<char, 0>> *objects)
+{
+    const std::vector<size_t> &order = graph.order();
+    std::vector<llvm::SmallVector<char, 0>> artifacts(order.size());
+    std::vector<std::string> errors(order.size());
+    std::vector<int> codes(order.size(), 0);
+    std::string cacheDir;
+    if (options.cache)
+        cacheDir = options.cacheDir.empty() ? ObjectFileCache::default_dir() : options.cacheDir;
+    auto initName = [](const ModuleGraph::Module &m)
+    {
+        const std::string &prefix = m.linkage.exportPrefix;
+        return "oong.init." + prefix.substr(0, prefix.size() - 1);
+    };
+    parallel_for(order.size(), threads, [&](size_t k)
+    {
+        ModuleGraph::Module &m = graph[order[k]];
+        PhaseTimer timer("module");
+        std::unique_ptr<ObjectFileCache> cache;
+        if (!cacheDir.empty())
         {
-            llvm::ToolOutputFile outFile(objPath.string(), EC, llvm::sys::fs::OF_None);
-            if (EC) { std::cerr << "Could not create object file: " << EC.message() << "\n"; return 6; }
-
+            // one entry per module and kind of artifact
+            std::string what = std::string(objects ? "object " : "bitcode ") + options.codeModel + " " + m.fingerprint;
+            cache = std::make_unique<ObjectFileCache>(
+                cacheDir, ObjectFileCache::make_key(what, out.getTargetTriple(), cpu, features, options.optLevel));
+            PhaseTimer timer("cache-load");
+            auto hit = cache->load();
+            if (hit.size() == 1)
+            {
+                artifacts[k].assign(hit[0]->getBufferStart(), hit[0]->getBufferEnd());
+                stats_count(Counter::ModulesReused, 1);
+                return;
+            }
+        }
+        llvm::LLVMContext ctx;
+        llvm::Module part(m.path, ctx);
+        part.setTargetTriple(out.getTargetTriple());
+        part.setDataLayout(out.getDataLayout());
+        if (PhaseTimer timer("ir-build"); !codegen_program(*m.program, part, initName(m), m.file->text(), errors[k], &m.linkage))
+        {
+            errors[k] = m.path + ": Codegen error: " + errors[k];
+            codes[k] = 1;
+            return;
+        }
+        stats_count(Counter::IrInstructions, part.getInstructionCount());
+        if (PhaseTimer timer("verify"); llvm::verifyModule(part, &llvm::errs()))
+        {
+            errors[k] = m.path + ": Generated module is broken";
+            codes[k] = 3;
+            return;
+        }
+        setFunctionTarget(part, cpu, features);
+        std::unique_ptr<llvm::TargetMachine> targetMachine = createTargetMachine();
+        {
+            PhaseTimer timer("optimize");
+            optimize_module(part, options.optLevel, targetMachine.get());
+        }
+        llvm::raw_svector_ostream os(artifacts[k]);
+        if (objects)
+        {
+            PhaseTimer timer("emit-object");
             llvm::legacy::PassManager pass;
-            if (targetMachine->addPassesToEmitFile(pass, outFile.os(), nullptr, llvm::CodeGenFileType::ObjectFile)) {
-                std::cerr << "TargetMachine can't emit object file\n"; return 7;
+            if (targetMachine->addPassesToEmitFile(pass, os, nullptr, llvm::CodeGenFileType::ObjectFile))
+            {
+                errors[k] = "TargetMachine can't emit object file";
+                codes[k] = 7;
+                return;
             }
-            pass.run(*module);
-            outFile.keep();
+            pass.run(part);
+        }
+        else
+        {
+            llvm::WriteBitcodeToFile(part, os);
+        }
+        stats_count(Counter::ModulesCompiled, 1);
+        if (cache)
+        {
+            PhaseTimer timer("cache-store");
+            cache->notifyObjectCompiled(&part, llvm::MemoryBufferRef(llvm::StringRef(artifacts[k].data(), artifacts[k].size()), m.path));
+            cache->store(1);
         }
+    });
+    for (size_t k = 0; k < order.size(); ++k)
+        if (codes[k]) { std::cerr << errors[k] << "\n"; return codes[k]; }
 
-        // try linkers in order
-        int rc = -1;
-        std::string cmd;
+    if (objects)
+    {
+        *objects = std::move(artifacts);
+    }
+    else
+    {
+        PhaseTimer timer("link-ir");
+        llvm::Linker linker(out);
+        for (size_t k = 0; k < order.size(); ++k)
+        {
+            llvm::MemoryBufferRef buffer(llvm::StringRef(artifacts[k].data(), artifacts[k].size()), graph[order[k]].path);
+            auto part = llvm::parseBitcodeFile(buffer, out.getContext());
+            if (!part)
+            {
+                llvm::logAllUnhandledErrors(part.takeError(), llvm::errs(), "Could not read back " + graph[order[k]].path + ": ");
+                return 3;
+            }
+            if (linker.linkInModule(std::move(*part))) { std::cerr << "Could not link " << graph[order[k]].path << "\n"; return 3; }
+        }
+        for (llvm::Function &fn : out)
+            if (!fn.isDeclaration())
+                fn.setLinkage(llvm::GlobalValue::InternalLinkage);
+    }
 
-        rc = std::system((std::string("clang --version >nul 2>&1")).c_str());
-        if (rc == 0) {
-            cmd = "clang -o " + std::string("\"") + outp.string() + "\" " + std::string("\"") + objPath.string() + "\"";
-            rc = std::system(cmd.c_str());
-            if (rc == 0) { std::cout << "Wrote " << outp.string() << "\n"; return 0; }
+    llvm::IRBuilder<> B(out.getContext());
+    auto *mainFn = llvm::Function::Create(llvm::FunctionType::get(B.getInt32Ty(), false), llvm::Function::ExternalLinkage, "main", out);
+    B.SetInsertPoint(llvm::BasicBlock::Create(out.getContext(), "entry", mainFn));
+    for (size_t i : order)
+        B.CreateCall(out.getOrInsertFunction(initName(graph[i]), B.getInt32Ty()));
+    B.CreateRet(B.getInt32(0));
+    setFunctionTarget(out, cpu, features);
+    return 0;
+}
+
+} // namespace
+
+int run_compiler(const std::string &inputPath, const std::string &outPath, const CompileOptions &options) {
+    unsigned threads = options.threads ? options.threads : std::max(1u, std::thread::hardware_concurrency());
+    ModuleGraph graph;
+    std::string error;
+    if (!graph.load(inputPath, threads, error) || !graph.link(error)) { std::cerr << error << "\n"; return 1; }
+
+    std::filesystem::path outp = outPath.empty() ? std::filesystem::path("a.exe") : std::filesystem::path(outPath);
+
+    // initialize native target
+    {
+        PhaseTimer timer("init-target");
+        llvm::InitializeNativeTarget();
+        llvm::InitializeNativeTargetAsmPrinter();
+        llvm::InitializeNativeTargetAsmParser();
+    }
+
+    auto targetTriple = llvm::sys::getDefaultTargetTriple();
+    std::string targetErr;
+    const llvm::Target *target = llvm::TargetRegistry::lookupTarget(targetTriple, targetErr);
+    if (!target) { std::cerr << "Target lookup failed: " << targetErr << "\n"; return 5; }
+
+    std::string CPU, features;
+    resolveTarget(options, CPU, features);
+    // LLVM aborts on a CPU it does not know; the host's name (-mcpu=native) always is one
+    if (!options.cpu.empty() && options.cpu != "native")
+    {
+        std::unique_ptr<llvm::MCSubtargetInfo> subtarget(target->createMCSubtargetInfo(targetTriple, "", ""));
+        if (!subtarget || !subtarget->isCPUStringValid(CPU)) { std::cerr << "Unknown CPU for " << targetTriple << ": " << CPU << "\n"; return 2; }
+    }
+    llvm::TargetOptions opt;
+    // PIC so the object links into the PIE executables toolchains produce by default
+    std::optional<llvm::Reloc::Model> RM = llvm::Reloc::PIC_;
+    bool knownModel;
+    std::optional<llvm::CodeModel::Model> CM = codeModel(options.codeModel, knownModel);
+    if (!knownModel) { std::cerr << "Unknown code model: " << options.codeModel << "\n"; return 2; }
+    auto createTargetMachine = [&]() {
+        return std::unique_ptr<llvm::TargetMachine>(
+            target->createTargetMachine(targetTriple, CPU, features, opt, RM, CM, codegenOptLevel(options.optLevel)));
+    };
+    std::unique_ptr<llvm::TargetMachine> targetMachine = createTargetMachine();
+    if (!targetMachine) { std::cerr << "Could not create a target machine for " << targetTriple << "\n"; return 5; }
+
+    // Same front end, codegen and pipeline as the JIT; the program's top-level
+    // statements become the executable's main().
+    llvm::LLVMContext ctx;
+    auto module = std::make_unique<llvm::Module>("oong_module", ctx);
+    module->setTargetTriple(targetTriple);
+    module->setDataLayout(targetMachine->createDataLayout());
+    // --incremental: the modules' own objects, linked as they are
+    std::vector<llvm::SmallVector<char, 0>> moduleObjects;
+    if (graph.size() > 1)
+    {
+        if (int rc = lowerModules(graph, threads, options, createTargetMachine, CPU, features, *module,
+                                  options.incremental ? &moduleObjects : nullptr))
+            return rc;
+    }
+    else
+    {
+        const ModuleGraph::Module &m = graph[0];
+        if (PhaseTimer timer("ir-build"); !codegen_program(*m.program, *module, "main", m.file->text(), error)) { std::cerr << "Codegen error: " << error << "\n"; return 1; }
+        stats_count(Counter::IrInstructions, module->getInstructionCount());
+        if (PhaseTimer timer("verify"); llvm::verifyModule(*module, &llvm::errs())) { std::cerr << "Generated module is broken\n"; return 3; }
+        setFunctionTarget(*module, CPU, features);
+    }
+    {
+        PhaseTimer timer("optimize");
+        optimize_module(*module, options.optLevel, targetMachine.get());
+    }
+
+    std::filesystem::path runtimeLib = findRuntimeLibrary();
+    if (runtimeLib.empty()) { std::cerr << "oong runtime library (oong_runtime) not found next to the oong executable\n"; return 8; }
+
+    std::string objExt = (targetTriple.find("windows") != std::string::npos) ? ".obj" : ".o";
+    std::filesystem::path objPath = outp.parent_path();
+    if (objPath.empty()) objPath = std::filesystem::current_path();
+    std::string stem = outp.stem().string();
+    std::filesystem::path objDir = objPath;
+    objPath /= (stem + objExt);
+    std::vector<std::string> objects{objPath.string()};
+
+    std::error_code EC;
+    {
+        PhaseTimer timer("emit-object");
+        llvm::ToolOutputFile outFile(objPath.string(), EC, llvm::sys::fs::OF_None);
+        if (EC) { std::cerr << "Could not create object file: " << EC.message() << "\n"; return 6; }
+
+        llvm::legacy::PassManager pass;
+        if (targetMachine->addPassesToEmitFile(pass, outFile.os(), nullptr, llvm::CodeGenFileType::ObjectFile)) {
+            std::cerr << "TargetMachine can't emit object file\n"; return 7;
         }
+        pass.run(*module);
+        outFile.keep();
 
-        rc = std::system((std::string("gcc --version >nul 2>&1")).c_str());
-        if (rc == 0) {
-            cmd = "gcc -o " + std::string("\"") + outp.string() + "\" " + std::string("\"") + objPath.string() + "\"";
-            rc = std::system(cmd.c_str());
-            if (rc == 0) { std::cout << "Wrote " << outp.string() << "\n"; return 0; }
+        for (size_t k = 0; k < moduleObjects.size(); ++k)
+        {
+            std::filesystem::path p = objDir / (stem + "." + std::to_string(k) + objExt);
+            llvm::ToolOutputFile moduleFile(p.string(), EC, llvm::sys::fs::OF_None);
+            if (EC) { std::cerr << "Could not create object file: " << EC.message() << "\n"; return 6; }
+            moduleFile.os().write(moduleObjects[k].data(), moduleObjects[k].size());
+            moduleFile.keep();
+            objects.push_back(p.string());
         }
+    }
 
-        rc = std::system((std::string("cl /? >nul 2>&1")).c_str());
+    // Use the first of the C++ drivers (the runtime is C++) found on PATH. It
+    // runs directly, so a link is one process and no shell; if it fails, its
+    // own diagnostics say why, and the next driver would only repeat them.
+    struct Linker
+    {
+        const char *name;
+        std::vector<std::string> args;
+    };
+    std::vector<std::string> inputs = objects;
+    inputs.push_back(runtimeLib.string());
+    auto gnu = [&]()
+    {
+        std::vector<std::string> args{"-o", outp.string()};
+        args.insert(args.end(), inputs.begin(), inputs.end());
+        return args;
+    };
+    // /MD matches the DLL C runtime CMake builds oong_runtime against
+    std::vector<std::string> msvc{"/nologo", "/MD"};
+    msvc.insert(msvc.end(), inputs.begin(), inputs.end());
+    msvc.push_back("/Fe:" + outp.string());
+    const Linker linkers[] = {{"clang++", gnu()}, {"g++", gnu()}, {"cl", msvc}};
+    PhaseTimer timer("link");
+    for (const auto &l : linkers) {
+        llvm::ErrorOr<std::string> program = llvm::sys::findProgramByName(l.name);
+        if (!program) continue;
+        std::vector<llvm::StringRef> argv{*program};
+        argv.insert(argv.end(), l.args.begin(), l.args.end());
+        std::string message;
+        int rc = llvm::sys::ExecuteAndWait(*program, argv, std::nullopt, {}, 0, 0, &message);
         if (rc == 0) {
-            cmd = std::string("cl /nologo ") + std::string("\"") + objPath.string() + std::string("\"") + std::string(" /Fe:") + std::string("\"") + outp.string() + std::string("\"");
-            rc = std::system(cmd.c_str());
-            if (rc == 0) { std::cout << "Wrote " << outp.string() << "\n"; return 0; }
+            if (!options.keepObjects)
+                for (const std::string &object : objects) std::filesystem::remove(object, EC);
+            std::cout << "Wrote " << outp.string() << "\n";
+            return 0;
         }
-
-        std::cerr << "No usable linker found (tried clang, gcc, cl), or linking failed. You can link manually:\n";
-        std::cerr << "  clang -o \"" << outp.string() << "\" \"" << objPath.string() << "\"\n";
+        std::cerr << "Linking with " << *program << " failed";
+        if (!message.empty()) std::cerr << " (" << message << ")";
+        std::cerr << "; the object files are kept\n";
         return 4;
     }
 
-    // if not the simple print form, emit IR to stdout
-    llvm::LLVMContext ctx;
-    auto module = std::make_unique<llvm::Module>("oong_module", ctx);
-    llvm::IRBuilder<> builder(ctx);
-    std::vector<llvm::Type*> printf_arg_types;
-    printf_arg_types.push_back(llvm::PointerType::getUnqual(llvm::Type::getInt8Ty(ctx)));
-    auto printf_type = llvm::FunctionType::get(llvm::Type::getInt32Ty(ctx), printf_arg_types, true);
-    auto printf_func = llvm::Function::Create(printf_type, llvm::Function::ExternalLinkage, "printf", module.get());
-    auto main_type = llvm::FunctionType::get(llvm::Type::getInt32Ty(ctx), false);
-    auto main_func = llvm::Function::Create(main_type, llvm::Function::ExternalLinkage, "main", module.get());
-    auto bb = llvm::BasicBlock::Create(ctx, "entry", main_func);
-    builder.SetInsertPoint(bb);
-    auto format_str = builder.CreateGlobalStringPtr("Hello from oong: %d\n");
-    auto const_val = llvm::ConstantInt::get(llvm::Type::getInt32Ty(ctx), 42);
-    builder.CreateCall(printf_func, {format_str, const_val});
-    builder.CreateRet(llvm::ConstantInt::get(llvm::Type::getInt32Ty(ctx), 0));
-    if (llvm::verifyModule(*module, &llvm::errs())) { std::cerr << "Generated module is broken\n"; return 1; }
-    module->print(llvm::outs(), nullptr);
-    return 0;
+    std::cerr << "No linker found (tried clang++, g++, cl). You can link manually:\n";
+    std::cerr << "  clang++ -o " << quote(outp);
+    for (const std::string &input : inputs) std::cerr << " " << quote(input);
+    std::cerr << "\n";
+    return 4;
 }
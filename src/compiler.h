@@ -1,6 +1,35 @@
 #pragma once
 #include <string>
+#include <string_view>
 
-// Compile the source file at inputPath to an executable at outPath.
+// Code generation options for `oong -c`.
+struct CompileOptions
+{
+    unsigned optLevel = 2; // -O0..-O3
+    // -mcpu= / -march=; "native" targets the host CPU and all of its features.
+    std::string cpu = "native";
+    // -mattr=, e.g. "+avx2,-avx512f"; applied on top of the CPU's features.
+    std::string features;
+    // -mcmodel=: tiny, small, kernel, medium or large; empty for the target default.
+    std::string codeModel;
+    // Threads that read, parse and lower the modules of a multi-file program
+    // (--jit-threads=N). 0: one per hardware thread.
+    unsigned threads = 0;
+    // Reuse what earlier builds made of the modules whose fingerprint has not
+    // changed (--no-cache turns this off). cacheDir empty:
+    // ObjectFileCache::default_dir().
+    bool cache = true;
+    std::string cacheDir;
+    // --incremental: compile each module of a multi-file program to an object
+    // of its own and link those, so a rebuild only compiles (and optimizes)
+    // the modules that changed. Calls across modules are not inlined.
+    bool incremental = false;
+    // --keep-objects: leave the object files next to the executable after a
+    // successful link (a failed one always leaves them, for linking by hand).
+    bool keepObjects = false;
+};
+
+// Compile the program whose entry module is the file at inputPath, together
+// with every module it imports (see ModuleGraph), to an executable at outPath.
 // Returns 0 on success, non-zero on failure.
-int run_compiler(const std::string &inputPath, const std::string &outPath);
+int run_compiler(const std::string &inputPath, const std::string &outPath, const CompileOptions &options);
@@ -0,0 +1,250 @@
+#include "engine.h"
+#include "codegen.h"
+#include "interpreter.h"
+#include "parser.h"
+#include "runtime.h"
+#include "semantics.h"
+
+#include <llvm/ExecutionEngine/Orc/Core.h>
+#include <llvm/ExecutionEngine/Orc/LLJIT.h>
+#include <llvm/ExecutionEngine/Orc/ThreadSafeModule.h>
+#include <llvm/IR/LLVMContext.h>
+#include <llvm/IR/Module.h>
+#include <llvm/IR/Verifier.h>
+#include <llvm/Support/Error.h>
+#include <llvm/Support/TargetSelect.h>
+#include <llvm/Support/raw_ostream.h>
+
+namespace
+{
+
+std::string message(llvm::Error err)
+{
+    std::string text;
+    llvm::raw_string_ostream os(text);
+    llvm::logAllUnhandledErrors(std::move(err), os);
+    os.flush();
+    while (!text.empty() && text.back() == '\n')
+        text.pop_back();
+    return text;
+}
+
+// Names of the top-level functions and variables `prog` declares.
+std::vector<std::string_view> declared_names(const Program &prog)
+{
+    std::vector<std::string_view> names;
+    for (const Stmt *s : prog.statements)
+    {
+        if (auto fd = ast_cast<FunctionDecl>(s))
+            names.push_back(fd->name);
+        else if (auto v = ast_cast<VarDeclStmt>(s))
+            names.push_back(v->name);
+        // `let a = 1, b = 2;` arrives as a block of declarations; any other
+        // block is a scope of its own
+        else if (auto b = ast_cast<BlockStmt>(s); b && b->declList)
+        {
+            for (const Stmt *c : b->statements)
+                if (auto v = ast_cast<VarDeclStmt>(c))
+                    names.push_back(v->name);
+        }
+    }
+    return names;
+}
+
+} // namespace
+
+Engine::Engine(const EngineOptions &options) : Options(options) {}
+
+Engine::~Engine() = default;
+
+std::unique_ptr<Engine> Engine::create(const EngineOptions &options, std::string &error)
+{
+    llvm::InitializeNativeTarget();
+    llvm::InitializeNativeTargetAsmPrinter();
+    llvm::InitializeNativeTargetAsmParser();
+
+    std::unique_ptr<Engine> engine(new Engine(options));
+    auto JOrErr = llvm::orc::LLJITBuilder().create();
+    if (!JOrErr)
+    {
+        error = "could not create the JIT: " + message(JOrErr.takeError());
+        return nullptr;
+    }
+    engine->J = std::move(*JOrErr);
+    // in the main JITDylib, which every script links against
+    if (add_runtime_symbols(*engine->J))
+    {
+        error = "could not register the runtime symbols";
+        return nullptr;
+    }
+    return engine;
+}
+
+std::unique_ptr<Script> Engine::compile(std::string_view source, std::string &error)
+{
+    return build(source, error, nullptr);
+}
+
+Script *Engine::compile(std::string_view source, std::string &error, Session &session)
+{
+    std::unique_ptr<Script> script = build(source, error, &session);
+    if (!script)
+        return nullptr;
+    session.Entries.push_back(std::move(script));
+    return session.Entries.back().get();
+}
+
+std::unique_ptr<Script> Engine::build(std::string_view source, std::string &error, Session *session)
+{
+    Parser P(source);
+    auto R = P.parse();
+    if (!R.ok || !R.stmt)
+    {
+        error = "parse error: " + R.error;
+        return nullptr;
+    }
+    const Program *prog = ast_cast<Program>(R.stmt);
+    if (!prog)
+    {
+        error = "unsupported statement";
+        return nullptr;
+    }
+
+    std::string dylibName = "oong.script." + std::to_string(Scripts++);
+    // A session entry links against what the entries before it declared,
+    // except for the names it declares again, and exports everything.
+    ModuleLinkage linkage;
+    if (session)
+    {
+        linkage = *session->Declared;
+        for (std::string_view name : declared_names(*prog))
+        {
+            linkage.imports.erase(name);
+            linkage.variables.erase(name);
+            linkage.consts.erase(name);
+        }
+        linkage.exportPrefix = dylibName + ".";
+        linkage.exportAll = true;
+    }
+
+    llvm::orc::ThreadSafeContext TSCtx(std::make_unique<llvm::LLVMContext>());
+    auto M = std::make_unique<llvm::Module>("oong_script", *TSCtx.getContext());
+    M->setDataLayout(J->getDataLayout());
+    M->setTargetTriple(J->getTargetTriple().str());
+    // Scripts share the process, so a function that cannot be lowered is a
+    // compile error rather than a fatal one when it is called.
+    if (!codegen_program(*prog, *M, "oong_main", source, error, session ? &linkage : nullptr, false))
+        return nullptr;
+    std::map<std::string, Script::Function, std::less<>> functions;
+    for (const Stmt *s : prog->statements)
+        if (auto fd = ast_cast<FunctionDecl>(s))
+        {
+            std::string name(fd->name);
+            if (codegen_export_function(*M, linkage.exportPrefix + name, "oong.call." + name))
+                functions[name] = Script::Function{fd->params.size(), nullptr};
+        }
+    if (llvm::verifyModule(*M, &llvm::errs()))
+    {
+        error = "generated module is broken";
+        return nullptr;
+    }
+    optimize_module(*M, Options.optLevel);
+
+    auto dylib = J->getExecutionSession().createJITDylib(dylibName);
+    if (!dylib)
+    {
+        error = message(dylib.takeError());
+        return nullptr;
+    }
+    dylib->addToLinkOrder(J->getMainJITDylib());
+    if (session)
+        for (const auto &entry : session->Entries)
+            dylib->addToLinkOrder(entry->Dylib);
+    std::unique_ptr<Script> script(new Script(*J, *dylib));
+    if (auto Err = J->addIRModule(*dylib, llvm::orc::ThreadSafeModule(std::move(M), std::move(TSCtx))))
+    {
+        error = message(std::move(Err));
+        return nullptr;
+    }
+    auto main = J->lookup(*dylib, "oong_main");
+    if (!main)
+    {
+        error = message(main.takeError());
+        return nullptr;
+    }
+    script->Main = main->toPtr<Script::MainFn>();
+    for (auto &kv : functions)
+    {
+        auto fn = J->lookup(*dylib, "oong.call." + kv.first);
+        if (!fn)
+        {
+            error = message(fn.takeError());
+            return nullptr;
+        }
+        kv.second.fn = fn->toPtr<Script::CallFn>();
+    }
+    script->Functions = std::move(functions);
+
+    if (session)
+    {
+        // What the entry declared, as the entries after it will see it. The
+        // names are interned: the entry's source goes away.
+        ProgramInfo info;
+        info.link(linkage);
+        if (!info.analyze(*prog, source, error))
+            return nullptr;
+        auto intern = [&](std::string_view name) -> std::string_view { return *session->Names.emplace(name).first; };
+        for (const auto &kv : info.functions)
+            linkage.imports[intern(kv.first)] =
+                ExportedFunction{linkage.exportPrefix + std::string(kv.first), kv.second.params, kv.second.ret};
+        for (const auto &kv : info.globals)
+            if (!linkage.variables.count(kv.first))
+                linkage.variables[intern(kv.first)] =
+                    ExportedVariable{linkage.exportPrefix + std::string(kv.first), kv.second};
+        for (const auto &kv : info.consts)
+            if (!linkage.consts.count(kv.first))
+                linkage.consts[intern(kv.first)] = kv.second;
+        *session->Declared = std::move(linkage);
+    }
+    return script;
+}
+
+Session::Session() : Declared(std::make_unique<ModuleLinkage>()) {}
+
+Session::~Session()
+{
+    // later entries link against earlier ones
+    while (!Entries.empty())
+        Entries.pop_back();
+}
+
+Script::~Script()
+{
+    llvm::consumeError(J.getExecutionSession().removeJITDylib(Dylib));
+}
+
+int Script::run()
+{
+    int rc = Main();
+    oong_rt_flush();
+    return rc;
+}
+
+bool Script::call(std::string_view name, const std::vector<double> &args, double &result, std::string &error)
+{
+    auto it = Functions.find(name);
+    if (it == Functions.end())
+    {
+        error = "no function '" + std::string(name) + "'";
+        return false;
+    }
+    if (args.size() != it->second.arity)
+    {
+        error = "function '" + std::string(name) + "' takes " + std::to_string(it->second.arity) + " arguments, not " +
+                std::to_string(args.size());
+        return false;
+    }
+    result = it->second.fn(args.data());
+    oong_rt_flush();
+    return true;
+}
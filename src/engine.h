@@ -0,0 +1,117 @@
+#pragma once
+#include <map>
+#include <memory>
+#include <set>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace llvm
+{
+namespace orc
+{
+class JITDylib;
+class LLJIT;
+}
+}
+struct ModuleLinkage;
+
+// Embedding API (the liboong library): compile oong programs from memory and
+// run them, or call their top-level functions, inside the host process. An
+// Engine initializes LLVM and creates its JIT once; each Script compiled with
+// it is a JITDylib of its own in that JIT's execution session, so compiling
+// one costs a parse, codegen and a module compile, not a process or a JIT.
+// Output goes to stdout through the runtime's buffer, which is flushed when a
+// run or call returns. A function the code generator cannot lower fails the
+// compile (the command line only fails when it is called), so no script ends
+// the process.
+// An Engine and its Scripts are used from one thread at a time.
+struct EngineOptions
+{
+    unsigned optLevel = 2; // 0..3
+};
+
+class Script;
+class Session;
+
+class Engine
+{
+public:
+    // Null, with `error` set, if the JIT cannot be set up for the host.
+    static std::unique_ptr<Engine> create(const EngineOptions &options, std::string &error);
+    ~Engine();
+
+    // Parse and compile `source`, a whole program, which only needs to stay
+    // alive for the call. Null, with `error` set, on parse and codegen errors.
+    // The Script must not outlive the Engine.
+    std::unique_ptr<Script> compile(std::string_view source, std::string &error);
+    // Compile `source` as the next entry of `session`: it sees the functions,
+    // variables and constants the entries before it declared, and its own
+    // declarations are added for the entries after it. The Script belongs to
+    // the session. Null, with `error` set, on parse and codegen errors; the
+    // session is unchanged then.
+    Script *compile(std::string_view source, std::string &error, Session &session);
+
+private:
+    explicit Engine(const EngineOptions &options);
+    std::unique_ptr<Script> build(std::string_view source, std::string &error, Session *session);
+
+    EngineOptions Options;
+    std::unique_ptr<llvm::orc::LLJIT> J;
+    unsigned Scripts = 0; // JITDylib names
+};
+
+class Script
+{
+public:
+    ~Script(); // frees the script's code
+    Script(const Script &) = delete;
+    Script &operator=(const Script &) = delete;
+
+    // Run the program's top-level statements; returns its exit code. Each
+    // run starts over, but top-level variables used by functions keep the
+    // values the last run or call left them.
+    int run();
+    // Call top-level function `name` with `args`. A `boolean` parameter
+    // takes its argument's truthiness, and booleans come back as 0 or 1.
+    // False, with `error` set, if there is no such function or it takes a
+    // different number of arguments.
+    bool call(std::string_view name, const std::vector<double> &args, double &result, std::string &error);
+
+private:
+    friend class Engine;
+    using MainFn = int();
+    using CallFn = double(const double *);
+    struct Function
+    {
+        size_t arity;
+        CallFn *fn;
+    };
+    Script(llvm::orc::LLJIT &J, llvm::orc::JITDylib &dylib) : J(J), Dylib(dylib) {}
+
+    llvm::orc::LLJIT &J;
+    llvm::orc::JITDylib &Dylib;
+    MainFn *Main = nullptr;
+    std::map<std::string, Function, std::less<>> Functions;
+};
+
+// The entries of a REPL session (see run_repl in repl.h). Each is a Script
+// run once, whose JITDylib stays alive for the entries after it to link
+// against, so an entry costs the same however long the session has been.
+// Declaring a name again binds it anew for the entries that follow;
+// functions of earlier entries keep the binding they were compiled with.
+// A Session must not outlive its Engine.
+class Session
+{
+public:
+    Session();
+    ~Session(); // frees the entries' code, newest first
+    Session(const Session &) = delete;
+    Session &operator=(const Session &) = delete;
+
+private:
+    friend class Engine;
+    std::vector<std::unique_ptr<Script>> Entries;
+    std::unique_ptr<ModuleLinkage> Declared; // for the next entry
+    std::set<std::string, std::less<>> Names; // Declared's keys point into it
+};
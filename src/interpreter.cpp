@@ -1,488 +1,445 @@
 #include "interpreter.h"
+#include <algorithm>
 #include <iostream>
 #include <string>
 #include <memory>
+#include <optional>
+#include <thread>
+#include <vector>
+#include "ast_tier.h"
 #include "parser.h"
+#include "codegen.h"
+#include "object_cache.h"
+#include "runtime.h"
+#include "stats.h"
 
 #include <llvm/Support/Error.h>
 #include <llvm/Support/TargetSelect.h>
 #include <llvm/IR/LLVMContext.h>
 #include <llvm/IR/Module.h>
-#include <llvm/IR/IRBuilder.h>
+#include <llvm/IR/InstrTypes.h>
 #include <llvm/IR/Verifier.h>
 #include <llvm/Support/raw_ostream.h>
 #include <llvm/ExecutionEngine/Orc/LLJIT.h>
 #include <llvm/ExecutionEngine/Orc/ThreadSafeModule.h>
 #include <llvm/ExecutionEngine/Orc/ExecutionUtils.h>
+#include <llvm/ExecutionEngine/Orc/Core.h>
+#include <llvm/ExecutionEngine/Orc/CompileUtils.h>
+#include <llvm/ExecutionEngine/Orc/IRCompileLayer.h>
+#include <llvm/Transforms/Utils/SplitModule.h>
 
-int run_interpreter(const std::string &source)
+static void init_native_target()
 {
-    auto isNumber = [](const std::string &s)
+    PhaseTimer timer("init-target");
+    llvm::InitializeNativeTarget();
+    llvm::InitializeNativeTargetAsmPrinter();
+    llvm::InitializeNativeTargetAsmParser();
+}
+
+// Lower `prog` into modules for J, optimized at optLevel unless that is left
+// to the JIT. Each of `exports` also gets an array-taking entry point named
+// "oong.tier.<function>" (see codegen_export_function). The optimized module
+// is split into up to `parts` modules of whole functions, so that compile
+// threads can generate code for them side by side; optimizing first keeps
+// inlining across the split. Returns 0 or the exit code to fail with.
+static int build_module(const Program &prog, std::string_view source, std::optional<unsigned> optLevel,
+                        unsigned parts, llvm::orc::LLJIT &J, std::vector<llvm::orc::ThreadSafeModule> &out,
+                        const std::vector<std::string_view> &exports = {})
+{
+    // Prepare a thread-safe LLVM context + module
+    llvm::orc::ThreadSafeContext TSCtx(std::make_unique<llvm::LLVMContext>());
+    auto &ctx = *TSCtx.getContext();
+    auto M = std::make_unique<llvm::Module>("oong_interpreter", ctx);
+    M->setDataLayout(J.getDataLayout());
+    M->setTargetTriple(J.getTargetTriple().str());
+
+    // Lower the whole program into oong_main
     {
-        if (s.empty())
-            return false;
-        size_t i = 0;
-        if (s[0] == '-')
-            i = 1;
-        bool dot = false;
-        for (; i < s.size(); ++i)
+        PhaseTimer timer("ir-build");
+        std::string error;
+        if (!codegen_program(prog, *M, "oong_main", source, error))
         {
-            if (s[i] == '.')
-            {
-                if (dot)
-                    return false;
-                dot = true;
-                continue;
-            }
-            if (!isdigit(s[i]))
-                return false;
+            std::cerr << "Interpreter Codegen error: " << error << "\n";
+            return 1;
         }
-        return true;
-    };
+        for (std::string_view name : exports)
+            codegen_export_function(*M, name, "oong.tier." + std::string(name));
+    }
+    stats_count(Counter::IrInstructions, M->getInstructionCount());
 
-    // Simple environment for variables (supports const obj = {...}; with string/number/nested)
-    struct Value
+    if (PhaseTimer timer("verify"); llvm::verifyModule(*M, &llvm::errs()))
     {
-        enum Kind
-        {
-            NUMBER,
-            STRING,
-            OBJECT,
-            BOOL
-        } kind;
-        double num = 0;
-        std::string str;
-        std::map<std::string, Value> obj;
-        bool b = false;
-        Value() : kind(STRING), num(0) {}
-        Value(double n) : kind(NUMBER), num(n) {}
-        Value(const std::string &s) : kind(STRING), str(s) {}
-        Value(const std::map<std::string, Value> &o) : kind(OBJECT), obj(o) {}
-        Value(bool bv) : kind(BOOL), b(bv) {}
-    };
-    std::map<std::string, Value> env;
+        std::cerr << "Generated module is broken\n";
+        return 3;
+    }
+    if (optLevel)
+    {
+        PhaseTimer timer("optimize");
+        optimize_module(*M, *optLevel);
+    }
 
-    // Helper: skip whitespace
-    auto skip_ws = [](const std::string &s, size_t &i)
+    // Make the modules thread-safe for the JIT. They share TSCtx; with compile
+    // threads, LLJIT moves each into a context of its own before compiling it.
+    size_t defined = std::count_if(M->begin(), M->end(), [](const llvm::Function &F) { return !F.isDeclaration(); });
+    parts = unsigned(std::min<size_t>(parts, defined));
+    if (parts <= 1)
     {
-        while (i < s.size() && (s[i] == ' ' || s[i] == '\n' || s[i] == '\r' || s[i] == '\t'))
-            ++i;
-    };
-    // Recursive object literal parser
-    std::function<Value(const std::string &, size_t &)> parse_object;
-    std::function<Value(const std::string &, size_t &)> parse_value;
-    parse_value = [&](const std::string &s, size_t &i) -> Value
+        out.emplace_back(std::move(M), std::move(TSCtx));
+        return 0;
+    }
+    PhaseTimer timer("split");
+    llvm::SplitModule(*M, parts, [&](std::unique_ptr<llvm::Module> part)
+                      {
+                          // distinct identifiers: the object cache keys objects by them
+                          part->setModuleIdentifier(M->getModuleIdentifier() + "." + std::to_string(out.size()));
+                          out.emplace_back(std::move(part), TSCtx);
+                      });
+    return 0;
+}
+
+// Add `modules` to J and compile them all, waiting until they are done. One
+// lookup names a non-local function defined in each, so with compile threads
+// every module starts compiling at once instead of when the linker first
+// needs it.
+static llvm::Error add_and_compile(llvm::orc::LLJIT &J, std::vector<llvm::orc::ThreadSafeModule> modules)
+{
+    PhaseTimer timer("compile");
+    llvm::orc::SymbolLookupSet symbols;
+    for (llvm::orc::ThreadSafeModule &TSM : modules)
     {
-        skip_ws(s, i);
-        if (i < s.size() && s[i] == '{')
-        {
-            return parse_object(s, i);
-        }
-        else if (i < s.size() && (s[i] == '"' || s[i] == '\''))
-        {
-            char quote = s[i++];
-            std::string val;
-            while (i < s.size() && s[i] != quote)
-            {
-                if (s[i] == '\\' && i + 1 < s.size())
-                {
-                    val += s[i + 1];
-                    i += 2;
-                }
-                else
-                    val += s[i++];
-            }
-            if (i < s.size() && s[i] == quote)
-                ++i;
-            return Value(val);
-        }
-        else
-        {
-            // Parse number, bool, or identifier (as string)
-            size_t start = i;
-            while (i < s.size() && (isalnum(s[i]) || s[i] == '.' || s[i] == '-'))
-                ++i;
-            std::string val = s.substr(start, i - start);
-            if (val == "true")
-                return Value(true);
-            if (val == "false")
-                return Value(false);
-            if (!val.empty() && std::all_of(val.begin(), val.end(), [](char c)
-                                            { return isdigit(c) || c == '.' || c == '-'; }))
-            {
-                return Value(std::stod(val));
-            }
-            return Value(val);
-        }
-    };
-    parse_object = [&](const std::string &s, size_t &i) -> Value
+        TSM.withModuleDo([&](llvm::Module &M)
+                         {
+                             for (const llvm::Function &F : M)
+                                 if (!F.isDeclaration() && !F.hasLocalLinkage())
+                                 {
+                                     symbols.add(J.mangleAndIntern(F.getName()));
+                                     break;
+                                 } });
+        if (auto Err = J.addIRModule(std::move(TSM)))
+            return Err;
+    }
+    // Functions split off into their own module are hidden, not exported.
+    auto R = J.getExecutionSession().lookup(
+        llvm::orc::makeJITDylibSearchOrder({&J.getMainJITDylib()}, llvm::orc::JITDylibLookupFlags::MatchAllSymbols),
+        std::move(symbols));
+    return R ? llvm::Error::success() : R.takeError();
+}
+
+// Partition function for LLLazyJIT: the requested functions plus every
+// function they reach through direct calls. Codegen has a fixed cost of
+// several milliseconds per module, so everything a call can reach without a
+// function value is compiled in one go; functions nothing reaches are never
+// compiled.
+static std::optional<llvm::orc::CompileOnDemandLayer::GlobalValueSet>
+reachable_functions(llvm::orc::CompileOnDemandLayer::GlobalValueSet requested)
+{
+    std::vector<const llvm::GlobalValue *> work(requested.begin(), requested.end());
+    while (!work.empty())
     {
-        std::map<std::string, Value> obj;
-        if (i < s.size() && s[i] == '{')
-            ++i;
-        skip_ws(s, i);
-        while (i < s.size() && s[i] != '}')
-        {
-            skip_ws(s, i);
-            // Parse key
-            std::string key;
-            if (s[i] == '"' || s[i] == '\'')
-            {
-                char quote = s[i++];
-                while (i < s.size() && s[i] != quote)
-                {
-                    if (s[i] == '\\' && i + 1 < s.size())
-                    {
-                        key += s[i + 1];
-                        i += 2;
-                    }
-                    else
-                        key += s[i++];
-                }
-                if (i < s.size() && s[i] == quote)
-                    ++i;
-            }
-            else
-            {
-                size_t start = i;
-                while (i < s.size() && (isalnum(s[i]) || s[i] == '_'))
-                    ++i;
-                key = s.substr(start, i - start);
-            }
-            skip_ws(s, i);
-            if (i < s.size() && s[i] == ':')
-                ++i;
-            skip_ws(s, i);
-            // Parse value
-            Value val = parse_value(s, i);
-            obj[key] = val;
-            skip_ws(s, i);
-            if (i < s.size() && s[i] == ',')
-                ++i;
-            skip_ws(s, i);
-        }
-        if (i < s.size() && s[i] == '}')
-            ++i;
-        return Value(obj);
-    };
+        auto *fn = llvm::dyn_cast<llvm::Function>(work.back());
+        work.pop_back();
+        if (!fn || fn->isDeclaration())
+            continue;
+        for (const llvm::BasicBlock &bb : *fn)
+            for (const llvm::Instruction &inst : bb)
+                if (auto *call = llvm::dyn_cast<llvm::CallBase>(&inst))
+                    if (const llvm::Function *callee = call->getCalledFunction())
+                        if (!callee->isDeclaration() && requested.insert(callee).second)
+                            work.push_back(callee);
+    }
+    return requested;
+}
 
-    std::string yellow = "\033[33m";
-    std::string reset = "\033[0m";
+// LLJIT that compiles whole modules, on a pool of `threads` compile threads
+// when that is more than one; with a cache, compiled objects are handed to it.
+static llvm::Expected<std::unique_ptr<llvm::orc::LLJIT>> create_jit(llvm::orc::JITTargetMachineBuilder JTMB,
+                                                                    ObjectFileCache *cache, unsigned threads)
+{
+    PhaseTimer timer("jit-create");
+    llvm::orc::LLJITBuilder builder;
+    builder.setJITTargetMachineBuilder(std::move(JTMB));
+    if (threads > 1)
+        builder.setNumCompileThreads(threads);
+    if (cache)
+        builder.setCompileFunctionCreator(
+            [cache, threads](llvm::orc::JITTargetMachineBuilder JTMB)
+                -> llvm::Expected<std::unique_ptr<llvm::orc::IRCompileLayer::IRCompiler>> {
+                // one TargetMachine per compile, unless compiles never overlap
+                if (threads > 1)
+                    return std::make_unique<llvm::orc::ConcurrentIRCompiler>(std::move(JTMB), cache);
+                auto TM = JTMB.createTargetMachine();
+                if (!TM)
+                    return TM.takeError();
+                return std::make_unique<llvm::orc::TMOwningSimpleCompiler>(std::move(*TM), cache);
+            });
+    return builder.create();
+}
 
-    // Serialize Value to JS-like string, with optional color for the whole object
-    std::function<std::string(const Value &, const std::string &)> serialize;
-    serialize = [&](const Value &v, const std::string &objColor) -> std::string
+int add_runtime_symbols(llvm::orc::LLJIT &J)
+{
+    // Add current process symbols so libm calls resolve to the C runtime
+    if (auto GenOrErr = llvm::orc::DynamicLibrarySearchGenerator::GetForCurrentProcess(J.getDataLayout().getGlobalPrefix()))
     {
-        if (v.kind == Value::NUMBER)
-        {
-            std::ostringstream oss;
-            oss << yellow << v.num << reset;
-            return oss.str();
-        }
-        else if (v.kind == Value::BOOL)
-        {
-            return yellow + (v.b ? std::string("true") : std::string("false")) + reset;
-        }
-        else if (v.kind == Value::STRING)
-        {
-            if (!objColor.empty())
-                return objColor + v.str + reset;
-            else
-                return v.str;
-        }
-        else if (v.kind == Value::OBJECT)
-        {
-            std::string out = objColor + "{ ";
-            bool first = true;
-            for (const auto &kv : v.obj)
-            {
-                if (!first)
-                    out += objColor + ", ";
-                first = false;
-                out += objColor + kv.first + reset + objColor + ": " + serialize(kv.second, objColor);
-            }
-            out += objColor + " }" + reset;
-            return out;
-        }
-        return "<unknown>";
+        auto Gen = std::move(*GenOrErr);
+        J.getMainJITDylib().addGenerator(std::move(Gen));
+    }
+    else
+    {
+        llvm::logAllUnhandledErrors(GenOrErr.takeError(), llvm::errs(), "Failed to create DynamicLibrarySearchGenerator: ");
+    }
+    // The oong runtime lives in this executable, which does not export its
+    // symbols; register their addresses explicitly.
+    struct RuntimeSymbol
+    {
+        const char *name;
+        void *addr;
     };
-    // parse source into AST
-    Parser P(source);
-    auto R = P.parse();
-    if (!R.ok || !R.stmt)
+    const RuntimeSymbol runtimeSymbols[] = {
+        {"oong_rt_write", reinterpret_cast<void *>(&oong_rt_write)},
+        {"oong_rt_write_number", reinterpret_cast<void *>(&oong_rt_write_number)},
+        {"oong_rt_write_line", reinterpret_cast<void *>(&oong_rt_write_line)},
+        {"oong_rt_write_err", reinterpret_cast<void *>(&oong_rt_write_err)},
+        {"oong_rt_write_number_err", reinterpret_cast<void *>(&oong_rt_write_number_err)},
+        {"oong_rt_write_line_err", reinterpret_cast<void *>(&oong_rt_write_line_err)},
+        {"oong_rt_date_now", reinterpret_cast<void *>(&oong_rt_date_now)},
+        {"oong_rt_fatal", reinterpret_cast<void *>(&oong_rt_fatal)},
+    };
+    llvm::orc::SymbolMap symbols;
+    for (const auto &s : runtimeSymbols)
+        symbols[J.mangleAndIntern(s.name)] = llvm::orc::ExecutorSymbolDef(llvm::orc::ExecutorAddr::fromPtr(s.addr), llvm::JITSymbolFlags::Exported);
+    if (auto Err = J.getMainJITDylib().define(llvm::orc::absoluteSymbols(std::move(symbols))))
     {
-        std::cerr << "Interpreter Parse error: " << R.error << "\n";
-        return 1;
+        llvm::logAllUnhandledErrors(std::move(Err), llvm::errs(), "Failed to register runtime symbols: ");
+        return 4;
     }
+    return 0;
+}
 
-    // Initialize native target for JIT
-    llvm::InitializeNativeTarget();
-    llvm::InitializeNativeTargetAsmPrinter();
-    llvm::InitializeNativeTargetAsmParser();
+// Background half of the AST tier: compile the whole program (filling the
+// cache on the way) and hand the tier its native entry points. On any failure
+// the tier simply keeps interpreting.
+static void promote(AstTier &tier, const Program &prog, std::string_view source, unsigned optLevel,
+                    unsigned threads, llvm::orc::JITTargetMachineBuilder JTMB, ObjectFileCache *cache,
+                    std::unique_ptr<llvm::orc::LLJIT> &out)
+{
+    PhaseTimer timer("promote");
+    init_native_target();
 
-    // Create LLJIT
-    auto JOrErr = llvm::orc::LLJITBuilder().create();
+    auto JOrErr = create_jit(std::move(JTMB), cache, threads);
     if (!JOrErr)
     {
-        llvm::logAllUnhandledErrors(JOrErr.takeError(), llvm::errs(), "LLJIT create failed: ");
-        return 2;
+        llvm::consumeError(JOrErr.takeError());
+        return;
+    }
+    llvm::orc::LLJIT &J = **JOrErr;
+    std::vector<std::string_view> exports = tier.promotable();
+    std::vector<llvm::orc::ThreadSafeModule> modules;
+    if (add_runtime_symbols(J) || build_module(prog, source, optLevel, threads, J, modules, exports))
+        return;
+    size_t count = modules.size();
+    if (auto Err = add_and_compile(J, std::move(modules)))
+    {
+        llvm::consumeError(std::move(Err));
+        return;
+    }
+    if (cache)
+    {
+        PhaseTimer timer("cache-store");
+        cache->store(count);
+    }
+    using TierFnType = double(const double *);
+    for (std::string_view name : exports)
+    {
+        auto Sym = J.lookup("oong.tier." + std::string(name));
+        if (!Sym)
+        {
+            llvm::consumeError(Sym.takeError());
+            continue;
+        }
+        auto Addr = *Sym;
+        tier.setNative(name, Addr.toPtr<TierFnType>());
     }
-    auto J = std::move(*JOrErr);
+    if (auto Sym = J.lookup("oong_main"))
+    {
+        using MainFnType = int();
+        auto Addr = *Sym;
+        tier.setNativeMain(Addr.toPtr<MainFnType>());
+    }
+    else
+        llvm::consumeError(Sym.takeError());
+    out = std::move(*JOrErr);
+}
 
-    // Prepare a thread-safe LLVM context + module
-    llvm::orc::ThreadSafeContext TSCtx(std::make_unique<llvm::LLVMContext>());
-    auto &ctx = *TSCtx.getContext();
-    auto M = std::make_unique<llvm::Module>("oong_interpreter", ctx);
-    llvm::IRBuilder<> builder(ctx);
+// Run `prog` in the AST tier. The first time something gets hot, the whole
+// program is compiled on a background thread, and promoted functions switch
+// to native code as soon as it is ready.
+static int run_tiered(AstTier &tier, const Program &prog, std::string_view source, unsigned optLevel,
+                      unsigned threads, llvm::orc::JITTargetMachineBuilder JTMB, ObjectFileCache *cache)
+{
+    std::unique_ptr<llvm::orc::LLJIT> J; // owns the promoted code
+    std::thread compiler;
+    tier.onHot([&]()
+               { compiler = std::thread(promote, std::ref(tier), std::cref(prog), source, optLevel, threads,
+                                        std::move(JTMB), cache, std::ref(J)); });
+    int rc;
+    {
+        PhaseTimer timer("execute");
+        rc = tier.run();
+    }
+    // The compile finishes even if the program already has: its object still
+    // goes into the cache for the next run.
+    if (compiler.joinable())
+        compiler.join();
+    oong_rt_flush();
+    return rc;
+}
 
-    // declare puts
-    auto puts_type = llvm::FunctionType::get(llvm::Type::getInt32Ty(ctx), {llvm::PointerType::getUnqual(llvm::Type::getInt8Ty(ctx))}, false);
-    auto puts_func = llvm::Function::Create(puts_type, llvm::Function::ExternalLinkage, "puts", M.get());
+int run_interpreter(std::string_view source, const InterpreterOptions &options)
+{
+    auto JTMBOrErr = llvm::orc::JITTargetMachineBuilder::detectHost();
+    if (!JTMBOrErr)
+    {
+        llvm::logAllUnhandledErrors(JTMBOrErr.takeError(), llvm::errs(), "Host detection failed: ");
+        return 2;
+    }
 
-    // create oong_main
-    auto main_type = llvm::FunctionType::get(llvm::Type::getInt32Ty(ctx), false);
-    auto main_func = llvm::Function::Create(main_type, llvm::Function::ExternalLinkage, "oong_main", M.get());
-    auto bb = llvm::BasicBlock::Create(ctx, "entry", main_func);
-    builder.SetInsertPoint(bb);
+    // The cache key covers everything the object depends on, so a hit can skip
+    // parsing and code generation entirely.
+    std::unique_ptr<ObjectFileCache> cache;
+    if (options.cache)
+    {
+        std::string dir = options.cacheDir.empty() ? ObjectFileCache::default_dir() : options.cacheDir;
+        if (!dir.empty())
+            cache = std::make_unique<ObjectFileCache>(
+                dir, ObjectFileCache::make_key(source, JTMBOrErr->getTargetTriple().str(), JTMBOrErr->getCPU(),
+                                               JTMBOrErr->getFeatures().getString(), options.optLevel));
+    }
+    std::vector<std::unique_ptr<llvm::MemoryBuffer>> cached;
+    if (cache)
+    {
+        PhaseTimer timer("cache-load");
+        cached = cache->load();
+    }
+    unsigned threads = options.jitThreads ? options.jitThreads : std::max(1u, std::thread::hardware_concurrency());
 
-    // Execute all statements in Program
-    // removed duplicate yellow and reset definitions
-    auto *prog = dynamic_cast<Program *>(R.stmt.get());
-    // Pass 1: collect const obj = {...} declarations (very simple, only top-level, only one object)
-    if (prog)
+    // parse source into AST
+    std::optional<Parser> P;
+    const Program *prog = nullptr;
+    if (cached.empty())
     {
-        // Pass 1: handle VarDeclStmt for const/var declarations
-        for (const auto &s : prog->statements)
+        P.emplace(source);
+        auto R = P->parse();
+        if (!R.ok || !R.stmt)
         {
-            auto *var = dynamic_cast<VarDeclStmt *>(s.get());
-            if (var && var->value)
-            {
-                if (auto lit = dynamic_cast<LiteralExpr *>(var->value.get()))
-                {
-                    std::string v = lit->value;
-                    size_t i = 0;
-                    skip_ws(v, i);
-                    if (!v.empty() && i < v.size() && v[i] == '{')
-                    {
-                        Value obj = parse_object(v, i);
-                        env[var->name] = obj;
-                    }
-                    else if (v == "true")
-                    {
-                        env[var->name] = Value(true);
-                    }
-                    else if (v == "false")
-                    {
-                        env[var->name] = Value(false);
-                    }
-                    else if (!v.empty() && std::all_of(v.begin(), v.end(), [](char c){ return isdigit(c) || c == '.' || c == '-'; }))
-                    {
-                        env[var->name] = Value(std::stod(v));
-                    }
-                    else
-                    {
-                        env[var->name] = Value(v);
-                    }
-                }
-            }
+            std::cerr << "Interpreter Parse error: " << R.error << "\n";
+            return 1;
         }
-        for (const auto &s : prog->statements)
+        prog = ast_cast<Program>(R.stmt);
+        if (!prog)
         {
-            if (auto ps = dynamic_cast<PrintStmt *>(s.get()))
-            {
-                std::string color = "";
-                if (ps->origin == TokenKind::Tok_ConsoleError)
-                {
-                    color = "\033[31m"; // red
-                }
-                else if (ps->origin == TokenKind::Tok_ConsoleWarn)
-                {
-                    color = "\033[38;2;255;165;0m"; // orange-yellow
-                }
-                else if (ps->origin == TokenKind::Tok_ConsoleInfo)
-                {
-                    color = "\033[34m"; // blue
-                }
-                else if (ps->origin == TokenKind::Tok_ConsoleSuccess)
-                {
-                    color = "\033[32m"; // green
-                }
-                std::string result;
-                for (size_t i = 0; i < ps->args.size(); ++i)
-                {
-                    std::string argStr;
-                    if (auto lit = dynamic_cast<LiteralExpr *>(ps->args[i].get()))
-                    {
-                        if (lit->value == "true") {
-                            argStr = yellow + std::string("true") + reset;
-                        } else if (lit->value == "false") {
-                            argStr = yellow + std::string("false") + reset;
-                        } else if (isNumber(lit->value)) {
-                            argStr = yellow + lit->value + reset;
-                        } else {
-                            argStr = color + lit->value;
-                        }
-                    }
-                    else if (auto id = dynamic_cast<IdentifierExpr *>(ps->args[i].get()))
-                    {
-                        // Look up in env
-                        auto it = env.find(id->name);
-                        if (it != env.end())
-                        {
-                            // If the value is BOOL, always output as yellow true/false
-                            if (it->second.kind == Value::BOOL) {
-                                argStr = yellow + (it->second.b ? std::string("true") : std::string("false")) + reset;
-                            } else if (
-                                ps->origin == TokenKind::Tok_ConsoleSuccess ||
-                                ps->origin == TokenKind::Tok_ConsoleError ||
-                                ps->origin == TokenKind::Tok_ConsoleWarn ||
-                                ps->origin == TokenKind::Tok_ConsoleInfo ||
-                                ps->origin == TokenKind::Tok_ConsoleLog
-                            ) {
-                                argStr = color + serialize(it->second, color);
-                            } else {
-                                argStr = color + serialize(it->second, "");
-                            }
-                        }
-                        else
-                        {
-                            argStr =  color + "<undefined>";
-                        }
-                    }
-                    else if (auto call = dynamic_cast<CallExpr *>(ps->args[i].get()))
-                    {
-                        argStr =  color + call->callee + "()";
-                    }
-                    else
-                    {
-                        argStr =  color + "<unsupported expr>";
-                    }
-                    if (i > 0)
-                        result += " ";
-                    result += argStr;
-                }
-                if (!color.empty())
-                {
-                    result = color + result + reset;
-                }
-                auto out_str = builder.CreateGlobalStringPtr(result.c_str());
-                builder.CreateCall(puts_func, {out_str});
-            }
+            std::cerr << "Unsupported statement\n";
+            return 1;
         }
-        builder.CreateRet(llvm::ConstantInt::get(llvm::Type::getInt32Ty(ctx), 0));
     }
-    else if (auto ps = dynamic_cast<PrintStmt *>(R.stmt.get()))
+
+    // Programs the tier can run start right away, without initializing LLVM;
+    // the rest (and cache hits) go straight to the JIT.
+    if (prog && options.tier)
     {
-        std::string color = "";
-        if (ps->origin == TokenKind::Tok_ConsoleError)
-        {
-            color = "\033[31m";
-        }
-        else if (ps->origin == TokenKind::Tok_ConsoleWarn)
-        {
-            color = "\033[38;2;255;165;0m";
-        }
-        else if (ps->origin == TokenKind::Tok_ConsoleInfo)
+        std::string why;
+        std::unique_ptr<AstTier> tier;
         {
-            color = "\033[34m";
+            PhaseTimer timer("tier-prepare");
+            tier = AstTier::prepare(*prog, source, why);
         }
-        else if (ps->origin == TokenKind::Tok_ConsoleSuccess)
-        {
-            color = "\033[32m";
-        }
-        std::string result;
-        for (size_t i = 0; i < ps->args.size(); ++i)
-        {
-            std::string argStr;
-            if (auto lit = dynamic_cast<LiteralExpr *>(ps->args[i].get()))
-            {
-                if (lit->value == "true" || lit->value == "false")
-                {
-                    argStr = yellow + lit->value + reset;
-                }
-                else if (isNumber(lit->value) && ps->origin == TokenKind::Tok_Print)
-                {
-                    argStr = yellow + lit->value + reset;
-                }
-                else
-                {
-                    argStr = color + lit->value;
-                }
-            }
-            else if (auto id = dynamic_cast<IdentifierExpr *>(ps->args[i].get()))
-            {
-                auto it = env.find(id->name);
-                if (it != env.end())
-                {
-                    // If the value is BOOL, always output as yellow true/false
-                    if (it->second.kind == Value::BOOL) {
-                        argStr = yellow + (it->second.b ? std::string("true") : std::string("false")) + reset;
-                    } else if (
-                        ps->origin == TokenKind::Tok_ConsoleSuccess ||
-                        ps->origin == TokenKind::Tok_ConsoleError ||
-                        ps->origin == TokenKind::Tok_ConsoleWarn ||
-                        ps->origin == TokenKind::Tok_ConsoleInfo ||
-                        ps->origin == TokenKind::Tok_ConsoleLog
-                    ) {
-                        argStr = color + serialize(it->second, color);
-                    } else {
-                        argStr = color + serialize(it->second, "");
-                    }
-                }
-                else
-                {
-                    argStr =  color + "<undefined>";
-                }
-            }
-            else if (auto call = dynamic_cast<CallExpr *>(ps->args[i].get()))
-            {
-                argStr = color + call->callee + "()" + reset;
-            }
-            else
-            {
-                argStr = color + "<unsupported expr>" + reset;
-            }
-            if (i > 0)
-                result += " ";
-            result += argStr;
-        }
-        if (!color.empty())
+        if (tier)
+            return run_tiered(*tier, *prog, source, options.optLevel, threads, std::move(*JTMBOrErr), cache.get());
+    }
+
+    init_native_target();
+
+    // Without a cache, compile lazily: LLLazyJIT puts every function behind a
+    // call-through stub, and a partition (see reachable_functions) is
+    // optimized and compiled on the first call into it. The cache needs the whole
+    // object, so with a cache (and on its misses) everything is compiled up
+    // front instead, on `threads` compile threads. (Lazy compiles happen one at
+    // a time on the thread that first calls in, so they get no pool.)
+    std::unique_ptr<llvm::orc::LLJIT> J;
+    llvm::orc::LLLazyJIT *lazyJ = nullptr;
+    if (options.lazy && !cache)
+    {
+        PhaseTimer timer("jit-create");
+        llvm::orc::LLLazyJITBuilder builder;
+        builder.setJITTargetMachineBuilder(std::move(*JTMBOrErr));
+        auto JOrErr = builder.create();
+        if (!JOrErr)
         {
-            result = color + result + reset;
+            llvm::logAllUnhandledErrors(JOrErr.takeError(), llvm::errs(), "LLLazyJIT create failed: ");
+            return 2;
         }
-        auto out_str = builder.CreateGlobalStringPtr(result.c_str());
-        builder.CreateCall(puts_func, {out_str});
-        builder.CreateRet(llvm::ConstantInt::get(llvm::Type::getInt32Ty(ctx), 0));
+        lazyJ = JOrErr->get();
+        lazyJ->setPartitionFunction(reachable_functions);
+        unsigned optLevel = options.optLevel;
+        lazyJ->getIRTransformLayer().setTransform(
+            [optLevel](llvm::orc::ThreadSafeModule TSM, const llvm::orc::MaterializationResponsibility &)
+                -> llvm::Expected<llvm::orc::ThreadSafeModule> {
+                PhaseTimer timer("optimize");
+                TSM.withModuleDo([optLevel](llvm::Module &M) { optimize_module(M, optLevel); });
+                return TSM;
+            });
+        J = std::move(*JOrErr);
     }
     else
     {
-        std::cerr << "Unsupported statement\n";
-        return 1;
+        auto JOrErr = create_jit(std::move(*JTMBOrErr), cache.get(), threads);
+        if (!JOrErr)
+        {
+            llvm::logAllUnhandledErrors(JOrErr.takeError(), llvm::errs(), "LLJIT create failed: ");
+            return 2;
+        }
+        J = std::move(*JOrErr);
     }
 
-    if (llvm::verifyModule(*M, &llvm::errs()))
-    {
-        std::cerr << "Generated module is broken\n";
-        return 3;
-    }
+    if (int rc = add_runtime_symbols(*J))
+        return rc;
 
-    // Make module thread-safe and add to JIT
-    llvm::orc::ThreadSafeModule TSM(std::move(M), std::move(TSCtx));
-    // Add current process symbols so printf resolves to the C runtime
-    if (auto GenOrErr = llvm::orc::DynamicLibrarySearchGenerator::GetForCurrentProcess(J->getDataLayout().getGlobalPrefix()))
+    if (!cached.empty())
     {
-        auto Gen = std::move(*GenOrErr);
-        J->getMainJITDylib().addGenerator(std::move(Gen));
+        PhaseTimer timer("load-objects");
+        for (auto &object : cached)
+            if (auto Err = J->addObjectFile(std::move(object)))
+            {
+                llvm::logAllUnhandledErrors(std::move(Err), llvm::errs(), "Failed to add cached object: ");
+                return 4;
+            }
     }
-    else
+    else if (lazyJ)
     {
-        llvm::logAllUnhandledErrors(GenOrErr.takeError(), llvm::errs(), "Failed to create DynamicLibrarySearchGenerator: ");
+        std::vector<llvm::orc::ThreadSafeModule> modules;
+        if (int rc = build_module(*prog, source, std::nullopt, 1, *J, modules))
+            return rc;
+        if (auto Err = lazyJ->addLazyIRModule(std::move(modules.front())))
+        {
+            llvm::logAllUnhandledErrors(std::move(Err), llvm::errs(), "Failed to add IR module: ");
+            return 4;
+        }
     }
-
-    if (auto Err = J->addIRModule(std::move(TSM)))
+    else
     {
-        llvm::logAllUnhandledErrors(std::move(Err), llvm::errs(), "Failed to add IR module: ");
-        return 4;
+        std::vector<llvm::orc::ThreadSafeModule> modules;
+        if (int rc = build_module(*prog, source, options.optLevel, threads, *J, modules))
+            return rc;
+        size_t count = modules.size();
+        if (auto Err = add_and_compile(*J, std::move(modules)))
+        {
+            llvm::logAllUnhandledErrors(std::move(Err), llvm::errs(), "Failed to compile IR module: ");
+            return 4;
+        }
+        if (cache)
+        {
+            PhaseTimer timer("cache-store");
+            cache->store(count);
+        }
     }
 
     // Lookup symbol and run. LLJIT::lookup returns an ExecutorAddr directly.
@@ -490,7 +447,11 @@ int run_interpreter(const std::string &source)
     // Convert ExecutorAddr to a callable pointer for an in-process JIT.
     using MainFnType = int();
     auto *mainPtr = Addr.toPtr<MainFnType>();
-    int rc = mainPtr();
-    (void)rc; // result printed by printf already
-    return 0;
+    int rc;
+    {
+        PhaseTimer timer("execute");
+        rc = mainPtr();
+    }
+    oong_rt_flush();
+    return rc;
 }
@@ -1,5 +1,37 @@
 #pragma once
 #include <string>
+#include <string_view>
+
+namespace llvm
+{
+namespace orc
+{
+class LLJIT;
+}
+}
+
+struct InterpreterOptions
+{
+    unsigned optLevel = 2; // -O0..-O3
+    // Reuse JIT objects from earlier runs of the same source (--no-cache turns
+    // this off). cacheDir empty: ObjectFileCache::default_dir().
+    bool cache = true;
+    std::string cacheDir;
+    // Compile each function on its first call (--eager turns this off). Only
+    // used when the cache is off, since the cache stores whole objects.
+    bool lazy = true;
+    // Start programs in the AST tier and compile them only once something is
+    // hot (--no-tier turns this off). Cache hits still run the cached object.
+    bool tier = true;
+    // Compile threads for whole-program compiles (--jit-threads=N); the
+    // program is split into as many modules. 0: one per hardware thread.
+    unsigned jitThreads = 0;
+};
 
 // Interpret the given source; returns exit code
-int run_interpreter(const std::string &source);
+int run_interpreter(std::string_view source, const InterpreterOptions &options);
+
+// Make the C runtime and the oong runtime visible to code in J's main
+// JITDylib (also used by Engine). Returns 0 or the exit code to fail with,
+// after logging why.
+int add_runtime_symbols(llvm::orc::LLJIT &J);
@@ -0,0 +1,149 @@
+#include "lexer.h"
+#include <algorithm>
+#include <cstring>
+#include <thread>
+
+namespace
+{
+
+// Sources smaller than this are lexed on one thread, and no chunk gets less:
+// below it, starting threads costs more than it saves.
+constexpr size_t MinChunk = 256 * 1024;
+// Tokens at the start of a chunk the previous chunk's lexer may fall in with.
+constexpr size_t SeamTokens = 64;
+
+// Where lexing the chunk that follows offset `from` starts: after a newline,
+// preferably one followed by what only starts a line at the top level (an
+// identifier or a closing brace in column 0), which is almost never inside a
+// string, template, regex or comment. A wrong guess only costs the seam check.
+size_t split_point(std::string_view src, size_t from)
+{
+  const char *begin = src.data(), *end = src.data() + src.size();
+  size_t first = std::string_view::npos;
+  const char *p = begin + from;
+  for (int lines = 0; lines < 256 && p < end; ++lines)
+  {
+    p = static_cast<const char *>(std::memchr(p, '\n', size_t(end - p)));
+    if (!p || ++p == end)
+      break;
+    size_t at = size_t(p - begin);
+    if (first == std::string_view::npos)
+      first = at;
+    char c = *p;
+    if ((c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c == '_' || c == '$' || c == '}')
+      return at;
+  }
+  return first;
+}
+
+bool same_resume(const Lexer::Resume &a, const Lexer::Resume &b)
+{
+  return a.pos == b.pos && a.inTemplateString == b.inTemplateString;
+}
+
+// One chunk's tokens, lexed as if lexing started at its first byte.
+struct Chunk
+{
+  size_t begin, end;
+  std::vector<Token> tokens; // those starting before `end` (the last chunk: up to Tok_EOF)
+  // Lexer state after each of the first SeamTokens tokens.
+  std::vector<Lexer::Resume> after;
+  // The first token starting at or past `end`, and the state after it.
+  Token next;
+  Lexer::Resume afterNext;
+};
+
+// Lex from `at` up to the first token that starts at or past `end` (or
+// Tok_EOF), which goes to `next` instead of `out`.
+void lex_range(std::string_view src, Lexer::Resume at, size_t end, bool strict, std::vector<Token> &out,
+               std::vector<Lexer::Resume> *after, Token &next, Lexer::Resume &afterNext)
+{
+  Lexer L(src, at, strict);
+  for (;;)
+  {
+    Token t = L.nextToken();
+    if (t.pos >= end || t.kind == TokenKind::Tok_EOF)
+    {
+      next = t;
+      afterNext = L.resumePoint();
+      return;
+    }
+    out.push_back(t);
+    if (after && after->size() < SeamTokens)
+      after->push_back(L.resumePoint());
+  }
+}
+
+} // namespace
+
+std::vector<Token> lex_tokens(std::string_view src, unsigned threads, bool strict)
+{
+  if (threads == 0)
+    threads = std::max(1u, std::thread::hardware_concurrency());
+  size_t count = std::min<size_t>(threads, src.size() / MinChunk);
+  std::vector<Chunk> chunks;
+  for (size_t i = 0, begin = 0; i < count && begin < src.size(); ++i)
+  {
+    size_t end = i + 1 == count ? src.size() : split_point(src, (i + 1) * (src.size() / count));
+    if (end == std::string_view::npos || end <= begin)
+      end = src.size();
+    chunks.push_back(Chunk{begin, end, {}, {}, {}, {}});
+    begin = end;
+  }
+  if (chunks.size() <= 1)
+  {
+    std::vector<Token> tokens;
+    tokens.reserve(src.size() / 4 + 1);
+    Lexer L(src, strict);
+    for (Token t = L.nextToken();; t = L.nextToken())
+    {
+      tokens.push_back(t);
+      if (t.kind == TokenKind::Tok_EOF)
+        return tokens;
+    }
+  }
+
+  // Every chunk is lexed as if it were the start of a line at the top level.
+  auto work = [&](size_t i)
+  {
+    Chunk &c = chunks[i];
+    c.tokens.reserve((c.end - c.begin) / 4 + 1);
+    size_t end = i + 1 == chunks.size() ? std::string_view::npos : c.end;
+    lex_range(src, Lexer::Resume{c.begin, false}, end, strict, c.tokens, i ? &c.after : nullptr, c.next, c.afterNext);
+  };
+  std::vector<std::thread> helpers;
+  for (size_t i = 1; i < chunks.size(); ++i)
+    helpers.emplace_back(work, i);
+  work(0);
+  for (std::thread &h : helpers)
+    h.join();
+
+  // Stitch, checking each seam: the real token stream, continued from the
+  // previous chunk, must reach one of this chunk's tokens in the same state
+  // (position, template-string flag), after which the two agree. Where it
+  // does not, the guess was wrong (say, the split fell in a comment), and
+  // the chunk is lexed again from the real state.
+  std::vector<Token> tokens = std::move(chunks[0].tokens);
+  Token next = chunks[0].next;
+  Lexer::Resume afterNext = chunks[0].afterNext;
+  for (size_t i = 1; i < chunks.size() && next.kind != TokenKind::Tok_EOF; ++i)
+  {
+    Chunk &c = chunks[i];
+    size_t j = 0;
+    while (j < c.after.size() &&
+           !(c.tokens[j].pos == next.pos && c.tokens[j].text.size() == next.text.size() && same_resume(c.after[j], afterNext)))
+      ++j;
+    tokens.push_back(next);
+    if (j < c.after.size())
+    {
+      tokens.insert(tokens.end(), c.tokens.begin() + j + 1, c.tokens.end());
+      next = c.next;
+      afterNext = c.afterNext;
+      continue;
+    }
+    size_t end = i + 1 == chunks.size() ? std::string_view::npos : c.end;
+    lex_range(src, afterNext, end, strict, tokens, nullptr, next, afterNext);
+  }
+  tokens.push_back(next);
+  return tokens;
+}
@@ -1,11 +1,14 @@
 #include <iostream>
 #include "lexer.h"
 #include "token.h"
+#include "scan.h"
 #include <cctype>
+#include <cstdint>
+#include <string_view>
 #include <sstream>
 
 // Helper: detect UTF-8 encoded U+2028 (E2 80 A8) and U+2029 (E2 80 A9)
-static inline bool isUtf8LineSeparator(const std::string &s, size_t pos)
+static inline bool isUtf8LineSeparator(std::string_view s, size_t pos)
 {
   if (pos + 2 >= s.size())
     return false;
@@ -16,7 +19,7 @@ static inline bool isUtf8LineSeparator(const std::string &s, size_t pos)
 }
 
 // Helper: detect UTF-8 encoded U+200C (E2 80 8C) or U+200D (E2 80 8D)
-static inline bool isUtf8ZWNCorZWJ(const std::string &s, size_t pos)
+static inline bool isUtf8ZWNCorZWJ(std::string_view s, size_t pos)
 {
   if (pos + 2 >= s.size())
     return false;
@@ -42,7 +45,7 @@ static inline int utf8SequenceLength(unsigned char lead)
 }
 
 // Handle CRLF as a single line terminator
-static inline size_t lineTerminatorLength(const std::string &s, size_t pos)
+static inline size_t lineTerminatorLength(std::string_view s, size_t pos)
 {
   if (pos >= s.size())
     return 0;
@@ -60,12 +63,20 @@ static inline size_t lineTerminatorLength(const std::string &s, size_t pos)
   return 0;
 }
 
+// Stop sets for the scan_to_any() fast paths: everything else inside a comment
+// or literal body is skipped in bulk.
+static constexpr ScanSet LineTerminatorLeads('\r', '\n', true);
+static constexpr ScanSet CommentDelimiters('*', '/');
+static constexpr ScanSet DoubleQuotedStops('"', '\\', '\r', '\n', true);
+static constexpr ScanSet SingleQuotedStops('\'', '\\', '\r', '\n', true);
+static constexpr ScanSet TemplateAtomStops('\\', '`', '$');
+
 // Regular expression helpers (match grammar fragments RegularExpressionBackslashSequence,
 // RegularExpressionClassChar, RegularExpressionFirstChar, RegularExpressionChar)
 
 // If there's a backslash escape sequence at pos (pos points at '\\'), and the next code unit
 // is not a line terminator, return total length (backslash + code unit length), otherwise 0.
-static inline size_t regBackslashSequenceLength(const std::string &s, size_t pos)
+static inline size_t regBackslashSequenceLength(std::string_view s, size_t pos)
 {
   if (pos + 1 >= s.size())
     return 0;
@@ -82,7 +93,7 @@ static inline size_t regBackslashSequenceLength(const std::string &s, size_t pos
 
 // If there's a character class starting at pos (pos points at '['), return the length up to and including
 // the matching ']' (handles backslash escapes inside the class). Returns 0 if unterminated or invalid.
-static inline size_t regClassLength(const std::string &s, size_t pos)
+static inline size_t regClassLength(std::string_view s, size_t pos)
 {
   if (pos >= s.size() || s[pos] != '[')
     return 0;
@@ -118,7 +129,7 @@ static inline size_t regClassLength(const std::string &s, size_t pos)
 }
 
 // RegularExpressionFirstChar: backslash sequence, class, or a non-line-terminator char (except '/').
-static inline size_t regFirstCharLength(const std::string &s, size_t pos)
+static inline size_t regFirstCharLength(std::string_view s, size_t pos)
 {
   if (pos >= s.size())
     return 0;
@@ -138,7 +149,7 @@ static inline size_t regFirstCharLength(const std::string &s, size_t pos)
 }
 
 // RegularExpressionChar is same as first char for our purposes.
-static inline size_t regCharLength(const std::string &s, size_t pos)
+static inline size_t regCharLength(std::string_view s, size_t pos)
 {
   return regFirstCharLength(s, pos);
 }
@@ -146,7 +157,7 @@ static inline size_t regCharLength(const std::string &s, size_t pos)
 // Grammar fragment LineContinuation: '\\' [\r\n\u2028\u2029]+
 // If there's a line continuation starting at `pos` (which must point at the backslash),
 // return the total byte length of the continuation (including the backslash). Otherwise return 0.
-static inline size_t lineContinuationLength(const std::string &s, size_t pos)
+static inline size_t lineContinuationLength(std::string_view s, size_t pos)
 {
   if (pos >= s.size() || s[pos] != '\\')
     return 0;
@@ -194,7 +205,13 @@ void Lexer::skipWhitespace()
     // Match the grammar's WhiteSpaces: [\t\u000B\u000C\u0020\u00A0]
     // Use explicit checks instead of isspace() so we reliably include NO-BREAK SPACE (0xA0)
     // and avoid accidentally consuming line terminators here (they are handled below).
-    if (c == '\t' || c == '\v' || c == '\f' || c == ' ' || c == 0xA0)
+    if (c == ' ' || c == '\t')
+    {
+      ++Pos;
+      Pos += scan_blanks(Src.data() + Pos, Src.size() - Pos);
+      continue;
+    }
+    if (c == '\v' || c == '\f' || c == 0xA0)
     {
       ++Pos;
       continue;
@@ -236,10 +253,10 @@ bool Lexer::skipSingleLineComment()
   Pos += 2; // skip '//'
   while (Pos < Src.size())
   {
-    size_t lt = lineTerminatorLength(Src, Pos);
-    if (lt)
+    Pos += scan_to_any(Src.data() + Pos, Src.size() - Pos, LineTerminatorLeads);
+    if (Pos >= Src.size() || lineTerminatorLength(Src, Pos))
       break;
-    ++Pos;
+    ++Pos; // non-ASCII byte that does not start U+2028/U+2029
   }
   return true;
 }
@@ -320,10 +337,7 @@ bool Lexer::skipCDataComment()
 
 Token Lexer::makeToken(TokenKind k, size_t start, size_t len, std::optional<int64_t> intVal) const
 {
-  Token t{k, Src.substr(start, len)};
-  t.pos = start;
-  t.intValue = intVal;
-  return t;
+  return Token{k, Src.substr(start, len), start, intVal};
 }
 
 void Lexer::ProcessTemplateOpenBrace()
@@ -456,6 +470,178 @@ std::optional<Token> Lexer::scanRegularExpression(size_t start)
   return makeToken(TokenKind::Tok_Invalid, start, Pos - start);
 }
 
+// Keyword recognition for the identifier path: a perfect hash over the
+// reserved words, built at compile time. `console` is in the table so the
+// console.xxx forms are found by the same probe.
+namespace {
+
+enum class KeywordMode : uint8_t
+{
+  Always,
+  StrictOnly, // a keyword only in strict mode, a plain identifier otherwise
+  Let,        // Tok_NonStrictLet, or Tok_StrictLet in strict mode
+  Console     // start of a console.xxx form
+};
+
+struct Keyword
+{
+  std::string_view text;
+  TokenKind kind;
+  KeywordMode mode;
+};
+
+constexpr Keyword Keywords[] = {
+    // TypeScript type keywords
+    {"any", TokenKind::Tok_Any, KeywordMode::Always},
+    {"number", TokenKind::Tok_Number, KeywordMode::Always},
+    {"never", TokenKind::Tok_Never, KeywordMode::Always},
+    {"boolean", TokenKind::Tok_Boolean, KeywordMode::Always},
+    {"string", TokenKind::Tok_String, KeywordMode::Always},
+    {"unique", TokenKind::Tok_Unique, KeywordMode::Always},
+    {"symbol", TokenKind::Tok_Symbol, KeywordMode::Always},
+    {"undefined", TokenKind::Tok_Undefined, KeywordMode::Always},
+    {"object", TokenKind::Tok_Object, KeywordMode::Always},
+    {"print", TokenKind::Tok_Print, KeywordMode::Always},
+    {"console", TokenKind::Tok_Identifier, KeywordMode::Console},
+    {"break", TokenKind::Tok_Break, KeywordMode::Always},
+    {"do", TokenKind::Tok_Do, KeywordMode::Always},
+    {"instanceof", TokenKind::Tok_Instanceof, KeywordMode::Always},
+    {"typeof", TokenKind::Tok_Typeof, KeywordMode::Always},
+    {"case", TokenKind::Tok_Case, KeywordMode::Always},
+    {"else", TokenKind::Tok_Else, KeywordMode::Always},
+    {"new", TokenKind::Tok_New, KeywordMode::Always},
+    {"var", TokenKind::Tok_Var, KeywordMode::Always},
+    {"catch", TokenKind::Tok_Catch, KeywordMode::Always},
+    {"finally", TokenKind::Tok_Finally, KeywordMode::Always},
+    {"return", TokenKind::Tok_Return, KeywordMode::Always},
+    {"void", TokenKind::Tok_Void, KeywordMode::Always},
+    {"continue", TokenKind::Tok_Continue, KeywordMode::Always},
+    {"for", TokenKind::Tok_For, KeywordMode::Always},
+    {"switch", TokenKind::Tok_Switch, KeywordMode::Always},
+    {"while", TokenKind::Tok_While, KeywordMode::Always},
+    {"debugger", TokenKind::Tok_Debugger, KeywordMode::Always},
+    {"function", TokenKind::Tok_Function, KeywordMode::Always},
+    {"this", TokenKind::Tok_This, KeywordMode::Always},
+    {"with", TokenKind::Tok_With, KeywordMode::Always},
+    {"if", TokenKind::Tok_If, KeywordMode::Always},
+    {"throw", TokenKind::Tok_Throw, KeywordMode::Always},
+    {"delete", TokenKind::Tok_Delete, KeywordMode::Always},
+    {"in", TokenKind::Tok_In, KeywordMode::Always},
+    {"try", TokenKind::Tok_Try, KeywordMode::Always},
+    {"default", TokenKind::Tok_Default, KeywordMode::Always},
+    {"as", TokenKind::Tok_As, KeywordMode::Always},
+    {"from", TokenKind::Tok_From, KeywordMode::Always},
+    {"of", TokenKind::Tok_Of, KeywordMode::Always},
+    {"yield", TokenKind::Tok_Yield, KeywordMode::Always},
+    {"class", TokenKind::Tok_Class, KeywordMode::Always},
+    {"enum", TokenKind::Tok_Enum, KeywordMode::Always},
+    {"extends", TokenKind::Tok_Extends, KeywordMode::Always},
+    {"super", TokenKind::Tok_Super, KeywordMode::Always},
+    {"const", TokenKind::Tok_Const, KeywordMode::Always},
+    {"export", TokenKind::Tok_Export, KeywordMode::Always},
+    {"import", TokenKind::Tok_Import, KeywordMode::Always},
+    {"async", TokenKind::Tok_Async, KeywordMode::Always},
+    {"await", TokenKind::Tok_Await, KeywordMode::Always},
+    {"implements", TokenKind::Tok_Implements, KeywordMode::StrictOnly},
+    {"private", TokenKind::Tok_Private, KeywordMode::StrictOnly},
+    {"public", TokenKind::Tok_Public, KeywordMode::StrictOnly},
+    {"interface", TokenKind::Tok_Interface, KeywordMode::StrictOnly},
+    {"package", TokenKind::Tok_Package, KeywordMode::StrictOnly},
+    {"protected", TokenKind::Tok_Protected, KeywordMode::StrictOnly},
+    {"static", TokenKind::Tok_Static, KeywordMode::StrictOnly},
+    {"let", TokenKind::Tok_NonStrictLet, KeywordMode::Let},
+    {"null", TokenKind::Tok_NullLiteral, KeywordMode::Always},
+    {"true", TokenKind::Tok_BooleanLiteral, KeywordMode::Always},
+    {"false", TokenKind::Tok_BooleanLiteral, KeywordMode::Always},
+};
+
+constexpr size_t KeywordSlots = 256;
+constexpr size_t MinKeywordLength = 2;
+constexpr size_t MaxKeywordLength = 10;
+
+// Only called for lengths in [MinKeywordLength, MaxKeywordLength]. The
+// multipliers were searched offline so that no two keywords share a slot;
+// the static_assert below re-checks that whenever the table changes.
+constexpr size_t keywordHash(std::string_view s)
+{
+  return (static_cast<unsigned char>(s[0]) * 2 + static_cast<unsigned char>(s[1]) * 37 +
+          static_cast<unsigned char>(s[s.size() - 1]) + s.size() * 13) &
+         (KeywordSlots - 1);
+}
+
+// Slot -> 1 + index into Keywords, 0 for an empty slot.
+struct KeywordTable
+{
+  uint8_t slots[KeywordSlots] = {};
+  bool perfect = true;
+};
+
+constexpr KeywordTable buildKeywordTable()
+{
+  KeywordTable t;
+  for (size_t i = 0; i < sizeof(Keywords) / sizeof(Keywords[0]); ++i)
+  {
+    const std::string_view text = Keywords[i].text;
+    if (text.size() < MinKeywordLength || text.size() > MaxKeywordLength)
+    {
+      t.perfect = false;
+      continue;
+    }
+    uint8_t &slot = t.slots[keywordHash(text)];
+    if (slot != 0)
+      t.perfect = false;
+    slot = static_cast<uint8_t>(i + 1);
+  }
+  return t;
+}
+
+constexpr KeywordTable KeywordLookup = buildKeywordTable();
+static_assert(KeywordLookup.perfect, "keyword hash collides or a keyword is out of range; retune keywordHash");
+
+const Keyword *findKeyword(std::string_view s)
+{
+  if (s.size() < MinKeywordLength || s.size() > MaxKeywordLength)
+    return nullptr;
+  uint8_t slot = KeywordLookup.slots[keywordHash(s)];
+  if (slot == 0)
+    return nullptr;
+  const Keyword &k = Keywords[slot - 1];
+  return k.text == s ? &k : nullptr;
+}
+
+// Members that turn `console.<member>` into a single token.
+constexpr Keyword ConsoleMembers[] = {
+    {"log", TokenKind::Tok_ConsoleLog, KeywordMode::Always},
+    {"error", TokenKind::Tok_ConsoleError, KeywordMode::Always},
+    {"warn", TokenKind::Tok_ConsoleWarn, KeywordMode::Always},
+    {"info", TokenKind::Tok_ConsoleInfo, KeywordMode::Always},
+    {"success", TokenKind::Tok_ConsoleSuccess, KeywordMode::Always},
+};
+
+TokenKind keywordKindFor(const Keyword &k, bool strict)
+{
+  switch (k.mode)
+  {
+  case KeywordMode::Always:
+    return k.kind;
+  case KeywordMode::StrictOnly:
+    return strict ? k.kind : TokenKind::Tok_Identifier;
+  case KeywordMode::Let:
+    return strict ? TokenKind::Tok_StrictLet : TokenKind::Tok_NonStrictLet;
+  case KeywordMode::Console:
+    break;
+  }
+  return TokenKind::Tok_Identifier;
+}
+
+} // namespace
+
+TokenKind Lexer::keywordKind(std::string_view ident, bool strict)
+{
+  const Keyword *k = findKeyword(ident);
+  return k ? keywordKindFor(*k, strict) : TokenKind::Tok_Identifier;
+}
+
 Token Lexer::nextToken()
 {
   skipWhitespace();
@@ -470,6 +656,9 @@ Token Lexer::nextToken()
     size_t atomStart = Pos;
     while (Pos < Src.size())
     {
+      Pos += scan_to_any(Src.data() + Pos, Src.size() - Pos, TemplateAtomStops);
+      if (Pos >= Src.size())
+        break;
       // handle escapes inside template atoms: backslash escapes and line continuations
       if (Src[Pos] == '\\')
       {
@@ -656,171 +845,35 @@ Token Lexer::nextToken()
       }
       break;
     }
-  std::string txt = Src.substr(idStart, Pos - idStart);
-  // Debug: print every identifier and special token
-  // std::cout << "[Lexer] TokenKind: " << (int)kind << " text: " << txt << std::endl; // 'kind' is not defined here
-    // Special case: combine console.error as Tok_ConsoleError
-  // ...existing code...
-    // Special case: combine console.log and console.error as single tokens
-    if (txt == "console") {
-      size_t p = Pos;
-      // Skip all whitespace before dot
-      while (p < Src.size() && isspace(Src[p])) ++p;
-      if (p < Src.size() && Src[p] == '.') {
+  std::string_view txt = Src.substr(idStart, Pos - idStart);
+    const Keyword *kw = findKeyword(txt);
+    if (!kw)
+      return makeToken(TokenKind::Tok_Identifier, idStart, txt.size());
+    if (kw->mode != KeywordMode::Console)
+      return makeToken(keywordKindFor(*kw, IsStrictMode()), idStart, txt.size());
+    // Special case: console.log / error / warn / info / success become a single
+    // token spanning `console . member` (whitespace allowed around the dot).
+    size_t p = Pos;
+    while (p < Src.size() && isspace(static_cast<unsigned char>(Src[p])))
+      ++p;
+    if (p < Src.size() && Src[p] == '.')
+    {
+      ++p;
+      while (p < Src.size() && isspace(static_cast<unsigned char>(Src[p])))
         ++p;
-        // Skip all whitespace before 'log', 'error', or 'warn'
-        while (p < Src.size() && isspace(Src[p])) ++p;
-        // Check for 'log'
-        if (p + 2 < Src.size() && Src.substr(p, 3) == "log") {
-          Pos = p + 3;
-          auto tok = makeToken(TokenKind::Tok_ConsoleLog, idStart, Pos - idStart);
-          return tok;
-        }
-        // Check for 'error'
-        if (p + 4 < Src.size() && Src.substr(p, 5) == "error") {
-          Pos = p + 5;
-          auto tok = makeToken(TokenKind::Tok_ConsoleError, idStart, Pos - idStart);
-          return tok;
-        }
-        // Check for 'warn'
-        if (p + 3 < Src.size() && Src.substr(p, 4) == "warn") {
-          Pos = p + 4;
-          auto tok = makeToken(TokenKind::Tok_ConsoleWarn, idStart, Pos - idStart);
-          return tok;
-        }
-        // Check for 'info'
-        if (p + 3 < Src.size() && Src.substr(p, 4) == "info") {
-          Pos = p + 4;
-          auto tok = makeToken(TokenKind::Tok_ConsoleInfo, idStart, Pos - idStart);
-          return tok;
-        }
-        // Check for 'success'
-        if (p + 6 < Src.size() && Src.substr(p, 7) == "success") {
-          Pos = p + 7;
-          auto tok = makeToken(TokenKind::Tok_ConsoleSuccess, idStart, Pos - idStart);
-          return tok;
+      size_t memberStart = p;
+      while (p < Src.size() && (isalnum(static_cast<unsigned char>(Src[p])) || Src[p] == '_' || Src[p] == '$'))
+        ++p;
+      std::string_view member = Src.substr(memberStart, p - memberStart);
+      for (const Keyword &m : ConsoleMembers)
+      {
+        if (m.text == member)
+        {
+          Pos = p;
+          return makeToken(m.kind, idStart, Pos - idStart);
         }
       }
     }
-    // TypeScript type keywords
-    if (txt == "any")
-      return makeToken(TokenKind::Tok_Any, idStart, txt.size());
-    if (txt == "number")
-      return makeToken(TokenKind::Tok_Number, idStart, txt.size());
-    if (txt == "never")
-      return makeToken(TokenKind::Tok_Never, idStart, txt.size());
-    if (txt == "boolean")
-      return makeToken(TokenKind::Tok_Boolean, idStart, txt.size());
-    if (txt == "string")
-      return makeToken(TokenKind::Tok_String, idStart, txt.size());
-    if (txt == "unique")
-      return makeToken(TokenKind::Tok_Unique, idStart, txt.size());
-    if (txt == "symbol")
-      return makeToken(TokenKind::Tok_Symbol, idStart, txt.size());
-    if (txt == "undefined")
-      return makeToken(TokenKind::Tok_Undefined, idStart, txt.size());
-    if (txt == "object")
-      return makeToken(TokenKind::Tok_Object, idStart, txt.size());
-    if (txt == "print")
-      return makeToken(TokenKind::Tok_Print, idStart, txt.size());
-    if (txt == "console.log")
-      return makeToken(TokenKind::Tok_ConsoleLog, idStart, txt.size());
-    if (txt == "break")
-      return makeToken(TokenKind::Tok_Break, idStart, txt.size());
-    if (txt == "do")
-      return makeToken(TokenKind::Tok_Do, idStart, txt.size());
-    if (txt == "instanceof")
-      return makeToken(TokenKind::Tok_Instanceof, idStart, txt.size());
-    if (txt == "typeof")
-      return makeToken(TokenKind::Tok_Typeof, idStart, txt.size());
-    if (txt == "case")
-      return makeToken(TokenKind::Tok_Case, idStart, txt.size());
-    if (txt == "else")
-      return makeToken(TokenKind::Tok_Else, idStart, txt.size());
-    if (txt == "new")
-      return makeToken(TokenKind::Tok_New, idStart, txt.size());
-    if (txt == "var")
-      return makeToken(TokenKind::Tok_Var, idStart, txt.size());
-    if (txt == "catch")
-      return makeToken(TokenKind::Tok_Catch, idStart, txt.size());
-    if (txt == "finally")
-      return makeToken(TokenKind::Tok_Finally, idStart, txt.size());
-    if (txt == "return")
-      return makeToken(TokenKind::Tok_Return, idStart, txt.size());
-    if (txt == "void")
-      return makeToken(TokenKind::Tok_Void, idStart, txt.size());
-    if (txt == "continue")
-      return makeToken(TokenKind::Tok_Continue, idStart, txt.size());
-    if (txt == "for")
-      return makeToken(TokenKind::Tok_For, idStart, txt.size());
-    if (txt == "switch")
-      return makeToken(TokenKind::Tok_Switch, idStart, txt.size());
-    if (txt == "while")
-      return makeToken(TokenKind::Tok_While, idStart, txt.size());
-    if (txt == "debugger")
-      return makeToken(TokenKind::Tok_Debugger, idStart, txt.size());
-    if (txt == "function")
-      return makeToken(TokenKind::Tok_Function, idStart, txt.size());
-    if (txt == "delete")
-      return makeToken(TokenKind::Tok_Delete, idStart, txt.size());
-    if (txt == "in")
-      return makeToken(TokenKind::Tok_In, idStart, txt.size());
-    if (txt == "try")
-      return makeToken(TokenKind::Tok_Try, idStart, txt.size());
-    if (txt == "default")
-      return makeToken(TokenKind::Tok_Default, idStart, txt.size());
-    if (txt == "as")
-      return makeToken(TokenKind::Tok_As, idStart, txt.size());
-    if (txt == "from")
-      return makeToken(TokenKind::Tok_From, idStart, txt.size());
-    if (txt == "of")
-      return makeToken(TokenKind::Tok_Of, idStart, txt.size());
-    if (txt == "yield")
-      return makeToken(TokenKind::Tok_Yield, idStart, txt.size());
-    if (txt == "yield*")
-      return makeToken(TokenKind::Tok_YieldStar, idStart, txt.size());
-    if (txt == "class")
-      return makeToken(TokenKind::Tok_Class, idStart, txt.size());
-    if (txt == "enum")
-      return makeToken(TokenKind::Tok_Enum, idStart, txt.size());
-    if (txt == "extends")
-      return makeToken(TokenKind::Tok_Extends, idStart, txt.size());
-    if (txt == "super")
-      return makeToken(TokenKind::Tok_Super, idStart, txt.size());
-    if (txt == "const")
-      return makeToken(TokenKind::Tok_Const, idStart, txt.size());
-    if (txt == "export")
-      return makeToken(TokenKind::Tok_Export, idStart, txt.size());
-    if (txt == "import")
-      return makeToken(TokenKind::Tok_Import, idStart, txt.size());
-    if (txt == "async")
-      return makeToken(TokenKind::Tok_Async, idStart, txt.size());
-    if (txt == "await")
-      return makeToken(TokenKind::Tok_Await, idStart, txt.size());
-    if (txt == "implements" && IsStrictMode())
-      return makeToken(TokenKind::Tok_Implements, idStart, txt.size());
-    if (txt == "private" && IsStrictMode())
-      return makeToken(TokenKind::Tok_Private, idStart, txt.size());
-    if (txt == "public" && IsStrictMode())
-      return makeToken(TokenKind::Tok_Public, idStart, txt.size());
-    if (txt == "interface" && IsStrictMode())
-      return makeToken(TokenKind::Tok_Interface, idStart, txt.size());
-    if (txt == "package" && IsStrictMode())
-      return makeToken(TokenKind::Tok_Package, idStart, txt.size());
-    if (txt == "protected" && IsStrictMode())
-      return makeToken(TokenKind::Tok_Protected, idStart, txt.size());
-    if (txt == "static" && IsStrictMode())
-      return makeToken(TokenKind::Tok_Static, idStart, txt.size());
-    if (txt == "let")
-    {
-      if (IsStrictMode())
-        return makeToken(TokenKind::Tok_StrictLet, idStart, txt.size());
-      return makeToken(TokenKind::Tok_NonStrictLet, idStart, txt.size());
-    }
-    if (txt == "null")
-      return makeToken(TokenKind::Tok_NullLiteral, idStart, txt.size());
-    if (txt == "true" || txt == "false")
-      return makeToken(TokenKind::Tok_BooleanLiteral, idStart, txt.size());
     return makeToken(TokenKind::Tok_Identifier, idStart, txt.size());
   }
 
@@ -1012,8 +1065,12 @@ Token Lexer::nextToken()
     char quote = c;
     size_t p = Pos; // current position is after opening quote
     bool terminated = false;
+    const ScanSet &stops = quote == '"' ? DoubleQuotedStops : SingleQuotedStops;
     while (p < Src.size())
     {
+      p += scan_to_any(Src.data() + p, Src.size() - p, stops);
+      if (p >= Src.size())
+        break;
       char ch = Src[p++];
       if (ch == quote)
       {
@@ -1294,13 +1351,9 @@ Token Lexer::nextToken()
     }
     if (Pos + 1 < Src.size() && Src[Pos] == '>' && Src[Pos + 1] == '>')
     {
-      // '>>' followed by '>' -> '>>>' (logical)
-      if (Pos + 2 < Src.size() && Src[Pos + 2] == '>')
-      {
-        // consume '>>>'
-        Pos += 3;
-        return makeToken(TokenKind::Tok_RightShiftLogical, start, 3);
-      }
+      // '>' followed by '>>' -> '>>>' (logical)
+      Pos += 2;
+      return makeToken(TokenKind::Tok_RightShiftLogical, start, 3);
     }
     // Check for '>>=' (arithmetic assign)
     if (Pos < Src.size() && Src[Pos] == '>' && Pos + 1 < Src.size() && Src[Pos + 1] == '=')
@@ -1388,6 +1441,9 @@ bool Lexer::skipMultiLineComment()
   int depth = 1;
   while (Pos + 1 < Src.size())
   {
+    Pos += scan_to_any(Src.data() + Pos, Src.size() - Pos, CommentDelimiters);
+    if (Pos + 1 >= Src.size())
+      break;
     // nested comment start
     if (Src[Pos] == '/' && Src[Pos + 1] == '*')
     {
@@ -1,20 +1,38 @@
 
 #pragma once
 #include <string>
+#include <string_view>
+#include <vector>
 #include "token.h"
 
 // Simple lexer for the tiny oong language
 class Lexer {
 public:
-  explicit Lexer(const std::string &src, bool strict = false) : Src(src), Pos(0), StrictMode(strict) {}
+  // `src` is not copied: it must outlive the lexer and every token it returns.
+  explicit Lexer(std::string_view src, bool strict = false) : Src(src), Pos(0), StrictMode(strict) {}
+  // Where lexing stands between two tokens: the offset the next one is looked
+  // for at and whether that is inside a template string. A lexer started at a
+  // resume point in another copy of the source (see StreamLexer) carries on
+  // exactly where this one would.
+  struct Resume {
+    size_t pos = 0;
+    bool inTemplateString = false;
+  };
+  Lexer(std::string_view src, Resume at, bool strict = false)
+    : Src(src), Pos(at.pos), StrictMode(strict), InTemplateString(at.inTemplateString) {}
+  Resume resumePoint() const { return {Pos, InTemplateString}; }
   Token nextToken();
   bool IsStrictMode() const { return StrictMode; }
   // Return true if the source contains a line terminator between [from, to)
   bool ContainsLineTerminatorBetween(size_t from, size_t to) const;
-  const std::string& getSource() const { return Src; }
+  std::string_view getSource() const { return Src; }
+  // Token kind of the identifier `ident`: its keyword kind (honoring strict-
+  // mode-only keywords) or Tok_Identifier. console.xxx forms are not words and
+  // are recognized by nextToken() only.
+  static TokenKind keywordKind(std::string_view ident, bool strict);
 
 private:
-  const std::string Src;
+  const std::string_view Src;
   size_t Pos;
   void skipWhitespace();
   bool skipSingleLineComment();
@@ -38,4 +56,12 @@ private:
   // (public) ContainsLineTerminatorBetween declared above
 };
 
+// Every token of `src`, through Tok_EOF, as nextToken() returns them. Large
+// sources (256 KiB or more per chunk) are split into chunks at likely
+// top-level line starts and lexed on up to `threads` threads (0: one per
+// hardware thread). Where a guessed split turns out to be inside a string,
+// comment or template, the lexer state at the seam tells, and that chunk is
+// lexed again after its predecessor (see lex_parallel.cpp).
+std::vector<Token> lex_tokens(std::string_view src, unsigned threads = 0, bool strict = false);
+
 // internal helpers used by lexer core are defined static in lexer.cpp
@@ -1,36 +1,72 @@
+#include <cstdlib>
 #include <iostream>
-#include <fstream>
-#include <iterator>
 #include <string>
 
 #include "interpreter.h"
 #include "compiler.h"
+#include "repl.h"
+#include "source.h"
+#include "stats.h"
+
+static const char *const Usage =
+    "Usage: oong [-O0|-O1|-O2|-O3] [-c input.oo -o out.exe [-mcpu=cpu|native] [-mattr=+f,-g] [-mcmodel=model] [--incremental] [--keep-objects]] [--no-cache] [--cache-dir=dir] [--eager] [--no-tier] [--jit-threads=N] [--time-phases] [--stats] [--trace=trace.json] [--repl|--serve|input.oo]\n";
 
 // Simple delegating CLI for oong: run interpreter or compiler
 int main(int argc, char **argv) {
     std::string inputPath;
     std::string outPath;
     bool doCompile = false;
+    bool repl = false, serve = false;
+    CompileOptions options;
+    InterpreterOptions jitOptions;
+    StatsOptions stats;
 
     for (int i = 1; i < argc; ++i) {
         std::string a = argv[i];
         if (a == "-c" && i + 1 < argc) { doCompile = true; inputPath = argv[++i]; }
         else if (a == "-o" && i + 1 < argc) { outPath = argv[++i]; }
-        else if (a == "-h" || a == "--help") { std::cout << "Usage: oong [-c input.oo -o out.exe] [input.oo]\n"; return 0; }
+        else if (a.size() == 3 && a[0] == '-' && a[1] == 'O' && a[2] >= '0' && a[2] <= '3') { options.optLevel = jitOptions.optLevel = unsigned(a[2] - '0'); }
+        else if (a.rfind("-mcpu=", 0) == 0) { options.cpu = a.substr(6); }
+        else if (a.rfind("-march=", 0) == 0) { options.cpu = a.substr(7); }
+        else if (a.rfind("-mattr=", 0) == 0) { options.features = a.substr(7); }
+        else if (a.rfind("-mcmodel=", 0) == 0) { options.codeModel = a.substr(9); }
+        else if (a == "--no-cache") { options.cache = jitOptions.cache = false; }
+        else if (a == "--incremental") { options.incremental = true; }
+        else if (a == "--keep-objects") { options.keepObjects = true; }
+        else if (a == "--repl") { repl = true; }
+        else if (a == "--serve") { serve = true; }
+        else if (a == "--eager") { jitOptions.lazy = false; }
+        else if (a == "--no-tier") { jitOptions.tier = false; }
+        else if (a.rfind("--cache-dir=", 0) == 0) { options.cacheDir = jitOptions.cacheDir = a.substr(12); }
+        else if (a.rfind("--jit-threads=", 0) == 0) { options.threads = jitOptions.jitThreads = unsigned(std::strtoul(a.c_str() + 14, nullptr, 10)); }
+        else if (a == "--time-phases") { stats.timePhases = true; }
+        else if (a == "--stats") { stats.counters = true; }
+        else if (a.rfind("--trace=", 0) == 0) { stats.tracePath = a.substr(8); }
+        else if (a == "-h" || a == "--help") {
+            std::cout << Usage;
+            return 0;
+        }
+        // a misspelt or out-of-range option (-O7) is not an input path
+        else if (a.size() > 1 && a[0] == '-') { std::cerr << "Unknown option: " << a << "\n" << Usage; return 2; }
         else if (inputPath.empty()) { inputPath = a; }
     }
 
+    // LLVM and the JIT stay up for a whole session of scripts
+    if (repl) return run_repl(jitOptions.optLevel);
+    if (serve) return run_server(jitOptions.optLevel);
     if (inputPath.empty()) { std::cerr << "No input file provided\n"; return 2; }
+    stats_enable(stats);
+    // the compiler reads the entry module and everything it imports itself
+    if (doCompile) return run_compiler(inputPath, outPath, options);
 
-    std::ifstream in(inputPath);
-    if (!in) { std::cerr << "Could not open file: " << inputPath << "\n"; return 2; }
-    std::string content((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
-
-    if (!doCompile) {
-        int r = run_interpreter(content);
-        if (r == 0) return 0; // interpreter handled it
-        else return r; // interpreter failed, return error code
+    // read once; the interpreter works on the read-only buffer
+    std::string openError;
+    std::unique_ptr<SourceFile> source;
+    {
+        PhaseTimer timer("read");
+        source = SourceFile::open(inputPath, openError);
     }
+    if (!source) { std::cerr << "Could not open file: " << inputPath << " (" << openError << ")\n"; return 2; }
 
-    return run_compiler(inputPath, outPath);
+    return run_interpreter(source->text(), jitOptions);
 }
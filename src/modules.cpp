@@ -0,0 +1,211 @@
+#include "modules.h"
+#include <algorithm>
+#include <atomic>
+#include <filesystem>
+#include <thread>
+#include "stats.h"
+
+#include <llvm/ADT/StringExtras.h>
+#include <llvm/Support/SHA256.h>
+
+void parallel_for(size_t count, unsigned threads, const std::function<void(size_t)> &work)
+{
+    std::atomic<size_t> next{0};
+    auto run = [&]()
+    {
+        for (size_t i = next++; i < count; i = next++)
+            work(i);
+    };
+    std::vector<std::thread> helpers;
+    for (unsigned t = 1; t < threads && t < count; ++t)
+        helpers.emplace_back(run);
+    run();
+    for (std::thread &h : helpers)
+        h.join();
+}
+
+namespace
+{
+
+// Path of the module `spec` names when imported from `importer`, or empty if
+// it is not a relative path.
+std::string resolve(const std::string &importer, std::string_view spec)
+{
+    if (spec.rfind("./", 0) != 0 && spec.rfind("../", 0) != 0)
+        return {};
+    std::filesystem::path p = std::filesystem::path(importer).parent_path() / std::string(spec);
+    if (!p.has_extension())
+        p += ".oo";
+    return p.lexically_normal().string();
+}
+
+// SHA-256 of length-prefixed fields, in hex.
+class Hasher
+{
+public:
+    Hasher &field(std::string_view s)
+    {
+        H.update(std::to_string(s.size()) + ":");
+        H.update(llvm::StringRef(s.data(), s.size()));
+        return *this;
+    }
+    std::string hex() { return llvm::toHex(H.final(), /*LowerCase=*/true); }
+
+private:
+    llvm::SHA256 H;
+};
+
+} // namespace
+
+bool ModuleGraph::load(const std::string &entry, unsigned threads, std::string &error)
+{
+    std::map<std::string, size_t> byPath;
+    auto add = [&](std::string path)
+    {
+        auto it = byPath.emplace(path, Modules.size());
+        if (it.second)
+        {
+            Modules.push_back(std::make_unique<Module>());
+            Modules.back()->path = std::move(path);
+        }
+        return it.first->second;
+    };
+    add(std::filesystem::absolute(entry).lexically_normal().string());
+
+    for (size_t first = 0; first < Modules.size();)
+    {
+        size_t last = Modules.size();
+        std::vector<std::string> errors(last - first);
+        parallel_for(last - first, threads, [&](size_t i)
+                     {
+                         Module &m = *Modules[first + i];
+                         {
+                             PhaseTimer timer("read");
+                             m.file = SourceFile::open(m.path, errors[i]);
+                         }
+                         if (!m.file)
+                         {
+                             errors[i] = "could not open file (" + errors[i] + ")";
+                             return;
+                         }
+                         m.parser = std::make_unique<Parser>(m.file->text());
+                         auto R = m.parser->parse();
+                         if (!R.ok || !R.stmt)
+                             errors[i] = "parse error: " + R.error;
+                         else if (!(m.program = ast_cast<Program>(R.stmt)))
+                             errors[i] = "unsupported statement";
+                     });
+        for (size_t i = first; i < last; ++i)
+        {
+            if (!errors[i - first].empty())
+            {
+                error = Modules[i]->path + ": " + errors[i - first];
+                return false;
+            }
+            for (const Stmt *s : Modules[i]->program->statements)
+                if (auto imp = ast_cast<ImportStmt>(s))
+                {
+                    std::string path = resolve(Modules[i]->path, imp->from);
+                    if (path.empty())
+                    {
+                        error = Modules[i]->path + ": cannot resolve module '" + std::string(imp->from) +
+                                "' (imports must be relative paths)";
+                        return false;
+                    }
+                    size_t target = add(std::move(path));
+                    Modules[i]->imports.push_back(target);
+                }
+        }
+        first = last;
+    }
+    return true;
+}
+
+bool ModuleGraph::link(std::string &error)
+{
+    // Depth-first from the entry: a module is ordered once its imports are.
+    Order.clear();
+    std::vector<int> state(Modules.size(), 0); // 0 new, 1 on the path, 2 ordered
+    std::vector<size_t> path;
+    std::function<bool(size_t)> visit = [&](size_t i)
+    {
+        if (state[i] == 2)
+            return true;
+        path.push_back(i);
+        if (state[i] == 1)
+        {
+            error = "import cycle: ";
+            for (size_t k = std::find(path.begin(), path.end(), i) - path.begin(); k < path.size(); ++k)
+                error += (k + 1 < path.size() ? Modules[path[k]]->path + " -> " : Modules[path[k]]->path);
+            return false;
+        }
+        state[i] = 1;
+        for (size_t dep : Modules[i]->imports)
+            if (!visit(dep))
+                return false;
+        state[i] = 2;
+        path.pop_back();
+        Order.push_back(i);
+        return true;
+    };
+    if (!visit(0))
+        return false;
+
+    for (size_t i : Order)
+    {
+        Module &m = *Modules[i];
+        // Named after the path rather than the module's index, so the symbols
+        // (and the fingerprints) stay put when the graph around it changes.
+        m.linkage.exportPrefix =
+            std::filesystem::path(m.path).stem().string() + "." + Hasher().field(m.path).hex().substr(0, 8) + ".";
+        size_t k = 0;
+        for (const Stmt *s : m.program->statements)
+        {
+            auto imp = ast_cast<ImportStmt>(s);
+            if (!imp)
+                continue;
+            const Module &from = *Modules[m.imports[k++]];
+            for (const ImportBinding &b : imp->bindings)
+            {
+                if (b.imported == "*" || b.imported == "default")
+                {
+                    error = m.path + ": namespace and default imports are not supported yet";
+                    return false;
+                }
+                auto e = from.exports.find(b.imported);
+                if (e == from.exports.end())
+                {
+                    error = m.path + ": module '" + std::string(imp->from) + "' has no exported function '" +
+                            std::string(b.imported) + "'";
+                    return false;
+                }
+                m.linkage.imports[b.local] = e->second;
+            }
+        }
+        // The interface the importers see: the return kinds depend on the
+        // module's own imports, which are bound by now.
+        ProgramInfo info;
+        info.link(m.linkage);
+        if (!info.analyze(*m.program, m.file->text(), error))
+        {
+            error = m.path + ": " + error;
+            return false;
+        }
+        for (const auto &kv : info.functions)
+            if (kv.second.decl->exported)
+                m.exports[std::string(kv.first)] =
+                    ExportedFunction{m.linkage.exportPrefix + std::string(kv.first), kv.second.params, kv.second.ret};
+
+        Hasher h;
+        h.field(m.file->text()).field(m.linkage.exportPrefix);
+        for (const auto &kv : m.linkage.imports)
+        {
+            std::string params;
+            for (ValueKind k : kv.second.params)
+                params += std::to_string(int(k));
+            h.field(kv.first).field(kv.second.symbol).field(params).field(std::to_string(int(kv.second.ret)));
+        }
+        m.fingerprint = h.hex();
+    }
+    return true;
+}
@@ -0,0 +1,64 @@
+#pragma once
+#include <functional>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+#include "parser.h"
+#include "semantics.h"
+#include "source.h"
+
+// The modules of a multi-file program: an entry file and everything it
+// imports, transitively. Specifiers are paths relative to the importing file
+// ("./util" or "./util.oo"; ".oo" is added when there is no extension), and a
+// module may import only the functions another exports (`export function`).
+// Files are read and parsed in parallel, a wave of newly discovered imports
+// at a time; link() then checks the imports against the exports in dependency
+// order, which only needs each module's interface (function arities and
+// return kinds), so the modules can afterwards be lowered independently.
+// It also gives each module a fingerprint of everything its code depends on,
+// which a rebuild uses to reuse what it lowered for unchanged modules.
+class ModuleGraph
+{
+public:
+    struct Module
+    {
+        std::string path; // absolute and normalized
+        std::unique_ptr<SourceFile> file;
+        std::unique_ptr<Parser> parser;
+        const Program *program = nullptr;
+        // Module of each top-level import statement, in source order.
+        std::vector<size_t> imports;
+        // Filled in by link(): what the module imports and how its exports are named.
+        ModuleLinkage linkage;
+        std::map<std::string, ExportedFunction, std::less<>> exports;
+        // Hash of the source, the export prefix and the imported functions'
+        // symbols, arities and return kinds: the module's code changes only
+        // when one of these does. Edits to an imported module that leave what
+        // this one imports alone (bodies, other exports) keep it.
+        std::string fingerprint;
+    };
+
+    // Read and parse `entry` and every module it imports, on up to `threads`
+    // threads. Returns false and sets `error` (prefixed with the file) on
+    // unreadable files, parse errors and unresolvable imports.
+    bool load(const std::string &entry, unsigned threads, std::string &error);
+    // Order the modules, bind every import to an export and fingerprint the
+    // modules. Fails on import cycles and on names a module does not export.
+    bool link(std::string &error);
+
+    size_t size() const { return Modules.size(); }
+    Module &operator[](size_t i) { return *Modules[i]; }
+    // Modules in evaluation order: each after the modules it imports, the
+    // entry (module 0) last.
+    const std::vector<size_t> &order() const { return Order; }
+
+private:
+    std::vector<std::unique_ptr<Module>> Modules;
+    std::vector<size_t> Order;
+};
+
+// Run work(0) .. work(count - 1) on up to `threads` threads, the caller's
+// included. Each thread takes the next index as soon as it is done with its
+// last, so uneven items balance out.
+void parallel_for(size_t count, unsigned threads, const std::function<void(size_t)> &work);
@@ -0,0 +1,211 @@
+#include "object_cache.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+
+#include <llvm/ADT/SmallString.h>
+#include <llvm/ADT/StringExtras.h>
+#include <llvm/Config/llvm-config.h>
+#include <llvm/IR/Module.h>
+#include <llvm/Support/Error.h>
+#include <llvm/Support/FileSystem.h>
+#include <llvm/Support/MemoryBuffer.h>
+#include <llvm/Support/Path.h>
+#include <llvm/Support/Process.h>
+#include <llvm/Support/SHA256.h>
+#include <llvm/Support/raw_ostream.h>
+
+#ifndef OONG_VERSION
+#define OONG_VERSION "dev"
+#endif
+
+namespace
+{
+
+// Size and modification time of the running executable, so a rebuilt oong
+// (say, with a codegen change but the same version number) never picks up
+// objects produced by the old one.
+std::string executableStamp()
+{
+  std::string exe = llvm::sys::fs::getMainExecutable(nullptr, reinterpret_cast<void *>(&executableStamp));
+  llvm::sys::fs::file_status st;
+  if (exe.empty() || llvm::sys::fs::status(exe, st))
+    return "unknown";
+  return std::to_string(st.getSize()) + ":" +
+         std::to_string(st.getLastModificationTime().time_since_epoch().count());
+}
+
+// An entry is a header line "oong-objects <count>", then each object as a
+// line with its size followed by its bytes.
+constexpr llvm::StringLiteral EntryMagic = "oong-objects ";
+
+// Bytes of entries the directory may hold before store() prunes it.
+uint64_t cacheLimit()
+{
+  const char *env = std::getenv("OONG_CACHE_LIMIT");
+  return (env ? std::strtoull(env, nullptr, 10) : 512) * 1024 * 1024;
+}
+
+} // namespace
+
+ObjectFileCache::ObjectFileCache(std::string dir, std::string key) : Dir(std::move(dir))
+{
+  llvm::SmallString<256> p(Dir);
+  llvm::sys::path::append(p, key + ".o");
+  Path = std::string(p.str());
+}
+
+std::string ObjectFileCache::make_key(std::string_view source, const std::string &triple, const std::string &cpu,
+                                      const std::string &features, unsigned optLevel)
+{
+  llvm::SHA256 h;
+  auto field = [&h](llvm::StringRef s) {
+    // length-prefixed so adjacent fields cannot run into each other
+    h.update(std::to_string(s.size()) + ":");
+    h.update(s);
+  };
+  field(OONG_VERSION);
+  field(executableStamp());
+  field(LLVM_VERSION_STRING);
+  field(triple);
+  field(cpu);
+  field(features);
+  field(std::to_string(optLevel));
+  field(llvm::StringRef(source.data(), source.size()));
+  return llvm::toHex(h.final(), /*LowerCase=*/true);
+}
+
+std::string ObjectFileCache::default_dir()
+{
+  if (const char *env = std::getenv("OONG_CACHE_DIR"))
+    return env;
+  llvm::SmallString<256> p;
+  if (!llvm::sys::path::cache_directory(p))
+    return "";
+  llvm::sys::path::append(p, "oong");
+  return std::string(p.str());
+}
+
+std::vector<std::unique_ptr<llvm::MemoryBuffer>> ObjectFileCache::load() const
+{
+  std::vector<std::unique_ptr<llvm::MemoryBuffer>> objects;
+  auto buf = llvm::MemoryBuffer::getFile(Path, /*IsText=*/false, /*RequiresNullTerminator=*/false);
+  if (!buf)
+    return objects;
+  // Anything malformed (say, written by an older oong) is a miss.
+  llvm::StringRef rest = (*buf)->getBuffer();
+  auto number = [&rest](uint64_t &n) {
+    return !rest.consumeInteger(10, n) && rest.consume_front("\n");
+  };
+  uint64_t count;
+  if (!rest.consume_front(EntryMagic) || !number(count) || count == 0)
+    return objects;
+  for (uint64_t i = 0; i < count; ++i)
+  {
+    uint64_t size;
+    if (!number(size) || size > rest.size())
+      return {};
+    objects.push_back(llvm::MemoryBuffer::getMemBufferCopy(rest.take_front(size), Path));
+    rest = rest.drop_front(size);
+  }
+  if (!rest.empty())
+    return {};
+  // Mark the entry used, for prune().
+  int fd;
+  if (!llvm::sys::fs::openFileForReadWrite(Path, fd, llvm::sys::fs::CD_OpenExisting, llvm::sys::fs::OF_None))
+  {
+    (void)llvm::sys::fs::setLastAccessAndModificationTime(
+        fd, std::chrono::time_point_cast<std::chrono::nanoseconds>(std::chrono::system_clock::now()));
+    llvm::sys::Process::SafelyCloseFileDescriptor(fd);
+  }
+  return objects;
+}
+
+void ObjectFileCache::notifyObjectCompiled(const llvm::Module *M, llvm::MemoryBufferRef obj)
+{
+  std::lock_guard<std::mutex> guard(Lock);
+  Objects[M->getModuleIdentifier()] = obj.getBuffer().str();
+}
+
+void ObjectFileCache::store(size_t modules)
+{
+  std::lock_guard<std::mutex> guard(Lock);
+  if (Objects.size() != modules)
+    return;
+  // Write to a temporary file and rename it into place, so concurrent runs of
+  // the same script never see a partially written entry. Failures only cost
+  // the next run a recompile.
+  if (llvm::sys::fs::create_directories(Dir))
+    return;
+  auto tmp = llvm::sys::fs::TempFile::create(Path + ".%%%%%%.tmp");
+  if (!tmp)
+  {
+    llvm::consumeError(tmp.takeError());
+    return;
+  }
+  bool written;
+  {
+    llvm::raw_fd_ostream os(tmp->FD, /*shouldClose=*/false);
+    os << EntryMagic << Objects.size() << "\n";
+    for (const auto &entry : Objects)
+      os << entry.second.size() << "\n" << entry.second;
+    os.flush();
+    written = !os.has_error();
+    os.clear_error();
+  }
+  if (!written)
+  {
+    llvm::consumeError(tmp->discard());
+    return;
+  }
+  if (llvm::Error err = tmp->keep(Path))
+  {
+    llvm::consumeError(std::move(err));
+    llvm::consumeError(tmp->discard());
+    return;
+  }
+  prune();
+}
+
+void ObjectFileCache::prune() const
+{
+  uint64_t limit = cacheLimit();
+  if (limit == 0)
+    return;
+  struct Entry
+  {
+    std::string path;
+    uint64_t size;
+    llvm::sys::TimePoint<> used;
+  };
+  std::vector<Entry> entries;
+  uint64_t total = 0;
+  std::error_code ec;
+  for (llvm::sys::fs::directory_iterator it(Dir, ec), end; it != end && !ec; it.increment(ec))
+  {
+    llvm::sys::fs::file_status st;
+    if (llvm::sys::path::extension(it->path()) != ".o" || llvm::sys::fs::status(it->path(), st) ||
+        st.type() != llvm::sys::fs::file_type::regular_file)
+      continue;
+    entries.push_back(Entry{it->path(), st.getSize(), st.getLastModificationTime()});
+    total += st.getSize();
+  }
+  if (total <= limit)
+    return;
+  // Oldest first; the entry just written is the newest and stays. Another
+  // run pruning at the same time only makes some removals fail.
+  std::sort(entries.begin(), entries.end(), [](const Entry &a, const Entry &b) { return a.used < b.used; });
+  for (const Entry &e : entries)
+  {
+    if (total <= limit / 4 * 3)
+      break;
+    if (e.path != Path && !llvm::sys::fs::remove(e.path))
+      total -= e.size;
+  }
+}
+
+std::unique_ptr<llvm::MemoryBuffer> ObjectFileCache::getObject(const llvm::Module *)
+{
+  // Hits never get as far as compiling (see load()).
+  return nullptr;
+}
@@ -0,0 +1,51 @@
+#pragma once
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <llvm/ExecutionEngine/ObjectCache.h>
+
+// On-disk cache of JIT-compiled objects, one file per key under a cache
+// directory. The interpreter checks it before parsing: on a hit it hands the
+// objects straight to the JIT. On a miss the JIT compiles as usual, in one or
+// more modules (see --jit-threads); notifyObjectCompiled collects their
+// objects, from any compile thread, and store() writes them out together for
+// the next run.
+// The cache is bounded: loading an entry marks it used (its modification
+// time), and once the directory holds more than $OONG_CACHE_LIMIT MiB of
+// entries (default 512; 0 for no limit) store() deletes the least recently
+// used ones until it is back under three quarters of that.
+class ObjectFileCache : public llvm::ObjectCache
+{
+public:
+  ObjectFileCache(std::string dir, std::string key);
+
+  // Key identifying the object compiled from `source` for this oong build,
+  // LLVM version, target (triple, CPU, features) and optimization level.
+  static std::string make_key(std::string_view source, const std::string &triple, const std::string &cpu,
+                              const std::string &features, unsigned optLevel);
+  // $OONG_CACHE_DIR, else an "oong" directory under the user's cache
+  // directory; empty when neither can be determined.
+  static std::string default_dir();
+
+  // The cached objects for this key (one per module the program was compiled
+  // in), or none.
+  std::vector<std::unique_ptr<llvm::MemoryBuffer>> load() const;
+  // Write the entry, if the objects of all `modules` modules have come in,
+  // then prune the directory.
+  void store(size_t modules);
+
+  void notifyObjectCompiled(const llvm::Module *M, llvm::MemoryBufferRef obj) override;
+  std::unique_ptr<llvm::MemoryBuffer> getObject(const llvm::Module *M) override;
+
+private:
+  void prune() const;
+
+  std::string Dir;
+  std::string Path;
+  std::mutex Lock;
+  std::map<std::string, std::string> Objects; // by module identifier
+};
@@ -1,8 +1,10 @@
 #include "parser.h"
+#include <algorithm>
 #include <optional>
 #include <string>
 #include <iostream>
 #include <functional>
+#include "stats.h"
 
 std::optional<ParseResult> Parser::parseSwitchStatement()
 {
@@ -83,7 +85,97 @@ bool Parser::parseDefaultClause()
   return true;
 }
 
+Parser::Parser(std::string_view src) : L(src)
+{
+  // Lexing does not depend on parser state, so the whole token stream is
+  // produced once (on several threads for big sources); backtracking and
+  // lookahead then only move TokIdx.
+  PhaseTimer timer("lex");
+  Tokens = lex_tokens(src);
+  Cur = Tokens[0];
+  stats_count(Counter::TokensLexed, Tokens.size());
+}
+
+const char *Parser::memoRuleName(MemoRule rule)
+{
+  switch (rule)
+  {
+  case MemoRule::SingleExpression:
+    return "singleExpression";
+  case MemoRule::AnonymousFunction:
+    return "anonymousFunction";
+  case MemoRule::Type:
+    return "type";
+  case MemoRule::ArrowAhead:
+    return "arrowFunctionAhead";
+  case MemoRule::Count:
+    break;
+  }
+  return "?";
+}
+
+template <typename F>
+bool Parser::memoized(MemoRule rule, F &&parse)
+{
+  if (!Memoize)
+    return parse();
+  size_t key = TokIdx * size_t(MemoRule::Count) + size_t(rule);
+  auto it = Memo.find(key);
+  if (it != Memo.end())
+  {
+    ++Stats.Hits[size_t(rule)];
+    const MemoEntry &e = it->second;
+    seek(e.end);
+    if (rule == MemoRule::Type)
+      LastTypeParsed = cloneType(e.type.get());
+    else if (rule != MemoRule::ArrowAhead)
+      LastExprParsed = e.expr;
+    return e.ok;
+  }
+  ++Stats.Misses[size_t(rule)];
+  bool ok = parse();
+  // `it` may have been invalidated by nested rules inserting entries
+  MemoEntry &e = Memo[key];
+  e.ok = ok;
+  e.end = checkpoint();
+  e.expr = LastExprParsed;
+  if (rule == MemoRule::Type)
+    e.type = cloneType(LastTypeParsed.get());
+  return ok;
+}
+
+bool Parser::parseSingleExpression()
+{
+  return memoized(MemoRule::SingleExpression, [this] { return parseSingleExpressionImpl(); });
+}
+
+bool Parser::parseAnonymousFunction()
+{
+  return memoized(MemoRule::AnonymousFunction, [this] { return parseAnonymousFunctionImpl(); });
+}
+
+bool Parser::parseType()
+{
+  return memoized(MemoRule::Type, [this] { return parseTypeImpl(); });
+}
+
+bool Parser::arrowFunctionAhead()
+{
+  return memoized(MemoRule::ArrowAhead, [this] { return arrowFunctionAheadImpl(); });
+}
+
 ParseResult Parser::parse()
+{
+  PhaseTimer timer("parse");
+  ParseResult r = parseProgram();
+  stats_count(Counter::AstNodes, Ast.nodeCount());
+  stats_count(Counter::Backtracks, Rewinds);
+  for (size_t hits : Stats.Hits)
+    stats_count(Counter::MemoHits, hits);
+  return r;
+}
+
+ParseResult Parser::parseProgram()
 {
   // Handle optional leading hash-bang; may return an empty-Program result
   if (auto res = handleOptionalHashBang())
@@ -91,6 +183,8 @@ ParseResult Parser::parse()
   // Parse optional sourceElements (sourceElement*) per grammar.
   if (auto se = parseSourceElements())
   {
+    if (!se->ok)
+      return std::move(*se);
     // Ensure we've consumed to EOF
     if (Cur.kind != TokenKind::Tok_EOF)
     {
@@ -122,13 +216,13 @@ ParseResult Parser::parse()
 bool Parser::parseImportDefault()
 {
   // importDefault : aliasName ','
-  auto save = Cur;
+  auto save = checkpoint();
   if (!parseAliasName())
     return false;
   if (Cur.kind != TokenKind::Tok_Comma)
   {
     // restore (parseAliasName may have consumed tokens)
-    Cur = save;
+    rewind(save);
     return false;
   }
   // consume comma
@@ -152,7 +246,7 @@ bool Parser::parseImportFromBlock()
   }
 
   // optional importDefault
-  auto saved = Cur;
+  auto saved = checkpoint();
   if (parseImportDefault())
   {
     // consumed default import + comma
@@ -160,7 +254,7 @@ bool Parser::parseImportFromBlock()
   else
   {
     // ensure we didn't consume tokens
-    Cur = saved;
+    rewind(saved);
   }
 
   // must have importNamespace or importModuleItems (or identifierName as shorthand)
@@ -236,11 +330,43 @@ std::optional<ParseResult> Parser::parseImportStatement()
   // importStatement : Import importFromBlock
   if (Cur.kind != TokenKind::Tok_Import)
     return std::nullopt;
+  size_t pos = Cur.pos;
   advance();
+  size_t first = TokIdx;
   if (!parseImportFromBlock())
     return error("invalid import statement");
   // std::cerr << "DEBUG: exit parseImportStatement Cur.kind=" << (int)Cur.kind << " text='" << Cur.text << "' pos=" << Cur.pos << "\n";
-  return ParseResult{true, std::string(), nullptr};
+  // The recognizers above only validate; read the bindings and the specifier
+  // back from the tokens they accepted:
+  //   "m" | (default ',')? ('*' as ns | '{' name (as local)?, ... '}' | default) from "m"
+  auto unquote = [](std::string_view s) { return s.size() >= 2 ? s.substr(1, s.size() - 2) : s; };
+  std::vector<ImportBinding> bindings;
+  std::string_view from;
+  for (size_t i = first; i < TokIdx; ++i)
+  {
+    const Token &t = Tokens[i];
+    if (t.kind == TokenKind::Tok_StringLiteral && (i == first || Tokens[i - 1].kind == TokenKind::Tok_From))
+      from = unquote(t.text);
+    else if (t.kind == TokenKind::Tok_Multiply && i + 2 < TokIdx && Tokens[i + 1].kind == TokenKind::Tok_As)
+      bindings.push_back({"*", Ast.intern(Tokens[i += 2].text)});
+    else if (t.kind == TokenKind::Tok_LBrace)
+    {
+      for (++i; i < TokIdx && Tokens[i].kind != TokenKind::Tok_RBrace; ++i)
+      {
+        if (Tokens[i].kind == TokenKind::Tok_Comma)
+          continue;
+        std::string_view name = Tokens[i].kind == TokenKind::Tok_StringLiteral ? unquote(Tokens[i].text) : Tokens[i].text;
+        std::string_view local = name;
+        if (i + 2 < TokIdx && Tokens[i + 1].kind == TokenKind::Tok_As)
+          local = Tokens[i += 2].text;
+        bindings.push_back({Ast.intern(name), Ast.intern(local)});
+      }
+    }
+    else if (t.kind != TokenKind::Tok_From && t.kind != TokenKind::Tok_Comma && t.kind != TokenKind::Tok_Semi &&
+             t.kind != TokenKind::Tok_StringLiteral)
+      bindings.push_back({"default", Ast.intern(t.text)});
+  }
+  return ParseResult{true, std::string(), Ast.make<ImportStmt>(from, Ast.list(bindings), pos)};
 }
 
 bool Parser::parseAliasName()
@@ -287,6 +413,8 @@ std::optional<ParseResult> Parser::parseExportStatement()
   {
     // expect eos
     parseEos();
+    if (auto fd = decl->ok ? ast_cast<FunctionDecl>(decl->stmt) : nullptr)
+      fd->exported = true;
     return std::move(*decl);
   }
   return error("invalid export statement");
@@ -299,12 +427,12 @@ bool Parser::parseExportFromBlock()
   // | exportModuleItems importFrom? eos
 
   // Try importNamespace importFrom eos
-  auto saved = Cur;
+  auto saved = checkpoint();
   if (parseImportNamespace())
   {
     if (!parseImportFrom())
     {
-      Cur = saved;
+      rewind(saved);
     }
     else
       return true;
@@ -433,7 +561,7 @@ std::optional<ParseResult> Parser::parsePrintStatement()
   advance();
   // std::cout << "[parsePrintStatement] After advance: Cur.kind=" << (int)Cur.kind << " text=" << Cur.text << std::endl;
   // Parse comma-separated arguments inside print(...)
-  std::vector<std::unique_ptr<Expr>> args;
+  std::vector<Expr *> args;
   bool expectArg = true;
   while (Cur.kind != TokenKind::Tok_EOF) {
     // std::cerr << "[DEBUG] print arg token: kind=" << (int)Cur.kind << " text=" << Cur.text << std::endl;
@@ -451,32 +579,14 @@ std::optional<ParseResult> Parser::parsePrintStatement()
         return error("expected ',' between print arguments");
       }
     }
-    // Parse a single argument (literal or identifier)
-    if (Cur.kind == TokenKind::Tok_StringLiteral) {
-      std::string lit = Cur.text;
-      if (lit.size() >= 2 && ((lit.front() == '"' && lit.back() == '"') || (lit.front() == '\'' && lit.back() == '\''))) {
-        lit = lit.substr(1, lit.size() - 2);
-      }
-      args.push_back(std::make_unique<LiteralExpr>(lit));
-      advance();
-    } else if (Cur.kind == TokenKind::Tok_Number || Cur.kind == TokenKind::Tok_Integer) {
-      args.push_back(std::make_unique<LiteralExpr>(Cur.text));
-      advance();
-    } else if (Cur.kind == TokenKind::Tok_BooleanLiteral) {
-      args.push_back(std::make_unique<LiteralExpr>(Cur.text));
-      advance();
-    } else if (Cur.kind == TokenKind::Tok_Identifier) {
-      args.push_back(std::make_unique<IdentifierExpr>(Cur.text));
-      advance();
-    } else {
-      // std::cerr << "[DEBUG] parsePrintStatement error: unsupported print argument, kind=" << (int)Cur.kind << " text=" << Cur.text << std::endl;
+    // Each argument is a full expression (literal, identifier, call, arithmetic, ...)
+    if (!parseSingleExpression())
       return error("unsupported print argument");
-    }
+    args.push_back(takeParsedExpr());
     expectArg = false;
   }
   // std::cerr << "[DEBUG] parsePrintStatement success: " << args.size() << " args\n";
-  auto stmt = std::make_unique<PrintStmt>(std::move(args), printKind);
-  return ParseResult{true, std::string(), std::move(stmt)};
+  return ParseResult{true, std::string(), Ast.make<PrintStmt>(Ast.list(args), printKind)};
 }
 
 bool Parser::parseImportedBinding()
@@ -497,10 +607,7 @@ bool Parser::parseIdentifierName()
   // First try identifier production.
   // std::cerr << "DEBUG: parseIdentifierName start Cur.kind=" << (int)Cur.kind << " text='" << Cur.text << "' pos=" << Cur.pos << "\n";
   if (parseIdentifier())
-  {
-    advance();
     return true;
-  }
   // std::cerr << "DEBUG: parseIdentifierName after parseIdentifier Cur.kind=" << (int)Cur.kind << " text='" << Cur.text << "' pos=" << Cur.pos << "\n";
   return parseReservedWord();
 }
@@ -616,10 +723,12 @@ std::optional<ParseResult> Parser::parseBlock()
   if (Cur.kind == TokenKind::Tok_RBrace)
   {
     advance();
-    return ParseResult{true, std::string(), nullptr};
+    return ParseResult{true, std::string(), Ast.make<BlockStmt>(AstList<Stmt *>())};
   }
   if (auto sl = parseStatementList())
   {
+    if (!sl->ok)
+      return sl;
     if (Cur.kind != TokenKind::Tok_RBrace)
       return error("expected '}'");
     advance();
@@ -631,27 +740,40 @@ std::optional<ParseResult> Parser::parseBlock()
 std::optional<ParseResult> Parser::parseStatementList()
 {
   // statementList : statement+
+  std::vector<Stmt *> stmts;
   bool any = false;
-  std::optional<ParseResult> last;
   while (true)
   {
     auto stmt = parseStatement();
     if (!stmt)
       break;
-    last = std::move(*stmt);
+    if (!stmt->ok)
+      return stmt;
+    if (stmt->stmt)
+      stmts.push_back(stmt->stmt);
     any = true;
     if (Cur.kind == TokenKind::Tok_RBrace || Cur.kind == TokenKind::Tok_EOF)
       break;
   }
   if (!any)
     return std::nullopt;
-  return last;
+  return ParseResult{true, std::string(), Ast.make<BlockStmt>(Ast.list(stmts))};
+}
+
+// Statements that are recognized but not modeled in the AST are recorded as a
+// RawStmt so the code generator can report them instead of silently dropping them.
+static std::optional<ParseResult> rawStatement(AstContext &ast, std::optional<ParseResult> r, size_t pos)
+{
+  if (r && r->ok && !r->stmt)
+    r->stmt = ast.make<RawStmt>(pos);
+  return r;
 }
 
 std::optional<ParseResult> Parser::parseStatement()
 {
   // std::cout << "[parseStatement] Cur.kind=" << (int)Cur.kind << " text=" << Cur.text << std::endl;
   // std::cerr << "DEBUG: enter parseStatement Cur.kind=" << (int)Cur.kind << " text='" << Cur.text << "' pos=" << Cur.pos << "\n";
+  size_t start = Cur.pos;
   // Try block
   if (auto b = parseBlock())
     return b;
@@ -666,18 +788,13 @@ std::optional<ParseResult> Parser::parseStatement()
     return e;
   // import/export/print
   if (auto imp = parseImportStatement())
-    return imp;
+    return rawStatement(Ast, std::move(imp), start);
   if (auto exp = parseExportStatement())
-    return exp;
+    return rawStatement(Ast, std::move(exp), start);
   if (auto p = parsePrintStatement())
     return p;
-  // expression statement
-  // labelled statement (Identifier ':' statement) should be tried before expression statements
-  if (auto ls = parseLabelledStatement())
-    return ls;
-  // expression statement
-  if (auto es = parseExpressionStatement())
-    return es;
+  // Keyword-led statements are tried before expression statements so that the
+  // keyword is never mistaken for the start of an expression.
   // if statement
   if (auto iff = parseIfStatement())
     return iff;
@@ -692,12 +809,25 @@ std::optional<ParseResult> Parser::parseStatement()
   if (auto r = parseReturnStatement())
     return r;
   if (auto y = parseYieldStatement())
-    return y;
+    return rawStatement(Ast, std::move(y), start);
   // with statement
   if (auto w = parseWithStatement())
-    return w;
+    return rawStatement(Ast, std::move(w), start);
   if (auto sw = parseSwitchStatement())
-    return sw;
+    return rawStatement(Ast, std::move(sw), start);
+  // throw/try/debugger
+  if (auto th = parseThrowStatement())
+    return rawStatement(Ast, std::move(th), start);
+  if (auto tr = parseTryStatement())
+    return rawStatement(Ast, std::move(tr), start);
+  if (auto d = parseDebuggerStatement())
+    return rawStatement(Ast, std::move(d), start);
+  // labelled statement (Identifier ':' statement) should be tried before expression statements
+  if (auto ls = parseLabelledStatement())
+    return ls;
+  // expression statement
+  if (auto es = parseExpressionStatement())
+    return es;
   // std::cerr << "DEBUG: exit parseStatement no match Cur.kind=" << (int)Cur.kind << " text='" << Cur.text << "' pos=" << Cur.pos << "\n";
   return std::nullopt;
 }
@@ -730,12 +860,18 @@ bool Parser::parseExpressionSequence()
   // expressionSequence : singleExpression (',' singleExpression)*
   if (!parseSingleExpression())
     return false;
+  if (Cur.kind != TokenKind::Tok_Comma)
+    return true;
+  std::vector<Expr *> exprs;
+  exprs.push_back(takeParsedExpr());
   while (Cur.kind == TokenKind::Tok_Comma)
   {
     advance();
     if (!parseSingleExpression())
       return false;
+    exprs.push_back(takeParsedExpr());
   }
+  LastExprParsed = Ast.make<SequenceExpr>(Ast.list(exprs));
   return true;
 }
 
@@ -760,14 +896,16 @@ std::optional<ParseResult> Parser::parseExpressionStatement()
   // We'll conservatively assume the guard passes when current token is not '{' and not 'function' keyword
   if (Cur.kind == TokenKind::Tok_LBrace || Cur.kind == TokenKind::Tok_Function)
     return std::nullopt;
-  auto save = Cur;
+  size_t start = Cur.pos;
   if (!parseExpressionSequence())
   {
-    Cur = save;
-    return std::nullopt;
+    // Nothing consumed: the rule does not apply. Otherwise the expression is malformed.
+    if (Cur.pos == start)
+      return std::nullopt;
+    return error("invalid expression");
   }
   parseEos();
-  return ParseResult{true, std::string(), nullptr};
+  return ParseResult{true, std::string(), Ast.make<ExprStmt>(takeParsedExpr())};
 }
 
 std::optional<ParseResult> Parser::parseIfStatement()
@@ -781,34 +919,44 @@ std::optional<ParseResult> Parser::parseIfStatement()
   advance();
   if (!parseExpressionSequence())
     return error("invalid if condition");
+  auto cond = takeParsedExpr();
   if (Cur.kind != TokenKind::Tok_RParen)
     return error("expected ')' after if condition");
   advance();
   // parse the statement after the if
-  if (auto stmt = parseStatement())
+  auto then = parseStatement();
+  if (!then)
+    return error("invalid if body");
+  if (!then->ok)
+    return then;
+  // optional else
+  Stmt *otherwise = nullptr;
+  if (Cur.kind == TokenKind::Tok_Else)
   {
-    // optional else
-    if (Cur.kind == TokenKind::Tok_Else)
-    {
-      advance();
-      if (!parseStatement())
-        return error("expected statement after else");
-    }
-    return std::move(*stmt);
+    advance();
+    auto e = parseStatement();
+    if (!e)
+      return error("expected statement after else");
+    if (!e->ok)
+      return e;
+    otherwise = e->stmt;
   }
-  return error("invalid if body");
+  return ParseResult{true, std::string(), Ast.make<IfStmt>(cond, then->stmt, otherwise)};
 }
 
 std::optional<ParseResult> Parser::parseIterationStatement()
 {
   // iterationStatement covers Do..While, While, For, ForIn, ForOf
-  auto save = Cur;
+  size_t start = Cur.pos;
   if (Cur.kind == TokenKind::Tok_Do)
   {
     advance();
     // body
-    if (!parseStatement())
+    auto body = parseStatement();
+    if (!body)
       return error("expected statement after do");
+    if (!body->ok)
+      return body;
     if (Cur.kind != TokenKind::Tok_While)
       return error("expected 'while' after do statement");
     advance();
@@ -817,12 +965,13 @@ std::optional<ParseResult> Parser::parseIterationStatement()
     advance();
     if (!parseExpressionSequence())
       return error("invalid while condition");
+    auto cond = takeParsedExpr();
     if (Cur.kind != TokenKind::Tok_RParen)
       return error("expected ')' after while condition");
     advance();
     // expect eos
     parseEos();
-    return ParseResult{true, std::string(), nullptr};
+    return ParseResult{true, std::string(), Ast.make<DoWhileStmt>(body->stmt, cond)};
   }
 
   if (Cur.kind == TokenKind::Tok_While)
@@ -833,12 +982,16 @@ std::optional<ParseResult> Parser::parseIterationStatement()
     advance();
     if (!parseExpressionSequence())
       return error("invalid while condition");
+    auto cond = takeParsedExpr();
     if (Cur.kind != TokenKind::Tok_RParen)
       return error("expected ')' after while condition");
     advance();
-    if (auto stmt = parseStatement())
-      return std::move(*stmt);
-    return error("invalid while body");
+    auto body = parseStatement();
+    if (!body)
+      return error("invalid while body");
+    if (!body->ok)
+      return body;
+    return ParseResult{true, std::string(), Ast.make<WhileStmt>(cond, body->stmt)};
   }
 
   if (Cur.kind == TokenKind::Tok_For)
@@ -854,48 +1007,78 @@ std::optional<ParseResult> Parser::parseIterationStatement()
     if (Cur.kind != TokenKind::Tok_LParen)
       return error("expected '(' after for");
     advance();
-    // Try (expressionSequence | variableDeclarationList)?
+    // (variableDeclarationList | expressionSequence)?
+    Stmt *init = nullptr;
     if (Cur.kind != TokenKind::Tok_Semi)
     {
-      auto save2 = Cur;
-      if (!parseExpressionSequence())
+      if (Cur.kind == TokenKind::Tok_Var || Cur.kind == TokenKind::Tok_Const ||
+          Cur.kind == TokenKind::Tok_NonStrictLet || Cur.kind == TokenKind::Tok_StrictLet)
       {
-        Cur = save2;
-        if (!parseVariableDeclarationList())
-        {
-          Cur = save;
+        std::vector<Stmt *> decls;
+        if (!parseVariableDeclarationList(&decls))
           return error("invalid for initializer");
-        }
+        if (decls.size() == 1)
+          init = decls.front();
+        else
+          init = Ast.make<BlockStmt>(Ast.list(decls), true);
+      }
+      else
+      {
+        if (!parseExpressionSequence())
+          return error("invalid for initializer");
+        init = Ast.make<ExprStmt>(takeParsedExpr());
       }
     }
+    // ForIn / ForOf: For '(' (singleExpression | variableDeclarationList) (In | Of) expressionSequence ')' statement
+    if (Cur.kind == TokenKind::Tok_In || Cur.kind == TokenKind::Tok_Of)
+    {
+      advance();
+      if (!parseExpressionSequence())
+        return error("invalid for-in/of expression");
+      if (Cur.kind != TokenKind::Tok_RParen)
+        return error("expected ')' after for");
+      advance();
+      auto body = parseStatement();
+      if (!body)
+        return error("invalid for body");
+      if (!body->ok)
+        return body;
+      return ParseResult{true, std::string(), Ast.make<RawStmt>(start)};
+    }
+    if (isAwait)
+      return error("expected 'of' in for await");
     if (!parseEos())
       return error("expected ';' in for");
     // optional expressionSequence
+    Expr *cond = nullptr;
     if (Cur.kind != TokenKind::Tok_Semi)
     {
       if (!parseExpressionSequence())
         return error("invalid for condition");
+      cond = takeParsedExpr();
     }
     if (!parseEos())
       return error("expected second ';' in for");
     // optional expressionSequence
+    Expr *update = nullptr;
     if (Cur.kind != TokenKind::Tok_RParen)
     {
       if (!parseExpressionSequence())
         return error("invalid for increment");
+      update = takeParsedExpr();
     }
     if (Cur.kind != TokenKind::Tok_RParen)
       return error("expected ')' after for");
     advance();
-    if (auto stmt = parseStatement())
-      return std::move(*stmt);
-    return error("invalid for body");
+    auto body = parseStatement();
+    if (!body)
+      return error("invalid for body");
+    if (!body->ok)
+      return body;
+    return ParseResult{true, std::string(),
+                       Ast.make<ForStmt>(init, cond, update, body->stmt)};
   }
 
-  // ForIn: For '(' (singleExpression | variableDeclarationList) In expressionSequence ')' statement
-  // ForOf is similar with 'Of' and optional Await handled earlier
-  // Attempt to parse ForIn/ForOf by peeking
-  Cur = save;
   return std::nullopt;
 }
 
@@ -904,14 +1087,19 @@ std::optional<ParseResult> Parser::parseContinueStatement()
   // Continue ({this.notLineTerminator()}? identifier)? eos
   if (Cur.kind != TokenKind::Tok_Continue)
     return std::nullopt;
+  size_t start = Cur.pos;
   advance();
   // optional identifier (we allow identifier-like tokens)
+  bool labelled = false;
   if (!parseEos())
   {
-    parseIdentifierName();
+    labelled = parseIdentifierName();
   }
   parseEos();
-  return ParseResult{true, std::string(), nullptr};
+  // labelled continue is not modeled yet
+  if (labelled)
+    return ParseResult{true, std::string(), Ast.make<RawStmt>(start)};
+  return ParseResult{true, std::string(), Ast.make<ContinueStmt>()};
 }
 
 std::optional<ParseResult> Parser::parseBreakStatement()
@@ -924,17 +1112,21 @@ std::optional<ParseResult> Parser::parseBreakStatement()
   advance();
   // Only accept an optional identifier if there is no line terminator between
   // the end of the 'break' token and the start of the following token.
+  bool labelled = false;
   if (!parseEos())
   {
     size_t from = breakTok.pos + breakTok.text.size();
     size_t to = Cur.pos;
     if (!L.ContainsLineTerminatorBetween(from, to))
     {
-      parseIdentifierName();
+      labelled = parseIdentifierName();
     }
   }
   parseEos();
-  return ParseResult{true, std::string(), nullptr};
+  // labelled break is not modeled yet
+  if (labelled)
+    return ParseResult{true, std::string(), Ast.make<RawStmt>(breakTok.pos)};
+  return ParseResult{true, std::string(), Ast.make<BreakStmt>()};
 }
 
 std::optional<ParseResult> Parser::parseReturnStatement()
@@ -947,18 +1139,20 @@ std::optional<ParseResult> Parser::parseReturnStatement()
   advance();
   // Only attempt to parse an expressionSequence if there is no line terminator between
   // the end of the 'return' token and the start of the next token.
+  Expr *value = nullptr;
   if (!parseEos())
   {
     size_t from = returnTok.pos + returnTok.text.size();
     size_t to = Cur.pos;
     if (!L.ContainsLineTerminatorBetween(from, to))
     {
-      // attempt to parse expressionSequence (conservative; ignore failure)
-      parseExpressionSequence();
+      if (!parseExpressionSequence())
+        return error("invalid return value");
+      value = takeParsedExpr();
     }
   }
   parseEos();
-  return ParseResult{true, std::string(), nullptr};
+  return ParseResult{true, std::string(), Ast.make<ReturnStmt>(value)};
 }
 
 std::optional<ParseResult> Parser::parseYieldStatement()
@@ -1007,17 +1201,10 @@ std::optional<ParseResult> Parser::parseLabelledStatement()
 {
   // labelledStatement
   //   : Identifier ':' statement
-  // Conservative implementation using existing helpers: try to consume an identifier-like token
-  auto saved = Cur;
-  if (!parseIdentifierName())
-    return std::nullopt;
-  if (Cur.kind != TokenKind::Tok_Colon)
-  {
-    // restore conservative state (note: lexer state isn't restored; follows repo pattern)
-    Cur = saved;
+  if (Cur.kind != TokenKind::Tok_Identifier || peekToken().kind != TokenKind::Tok_Colon)
     return std::nullopt;
-  }
-  // consume ':'
+  // consume identifier and ':'
+  advance();
   advance();
   auto inner = parseStatement();
   if (!inner)
@@ -1028,89 +1215,17 @@ std::optional<ParseResult> Parser::parseLabelledStatement()
 std::optional<ParseResult> Parser::parseDeclaration()
 {
   // declaration : variableStatement | classDeclaration | functionDeclaration
-  // For now we implement a conservative recognition:
-  // - variableStatement: starts with Var/let_/Const
-  // - classDeclaration: starts with Class
-  // - functionDeclaration: starts with Function_
   switch (Cur.kind)
   {
   case TokenKind::Tok_Var:
   case TokenKind::Tok_NonStrictLet:
   case TokenKind::Tok_StrictLet:
   case TokenKind::Tok_Const:
-  {
-    // variableStatement -> variableDeclarationList eos
-    // Consume the var/let/const token and then accept until eos conservatively.
-    advance();
-    // consume tokens until we hit eos or parser can't progress.
-    while (!parseEos())
-    {
-      // rudimentary consumption: stop on tokens that likely start a new statement/block
-      if (Cur.kind == TokenKind::Tok_LBrace || Cur.kind == TokenKind::Tok_RBrace)
-        break;
-      advance();
-    }
-    parseEos();
-    return ParseResult{true, std::string(), nullptr};
-  }
+    return parseVariableStatement();
   case TokenKind::Tok_Class:
-  {
-    // delegate to parseClassDeclaration
-    if (auto cd = parseClassDeclaration())
-      return cd;
-    return std::nullopt;
-  }
+    return parseClassDeclaration();
   case TokenKind::Tok_Function:
-  {
-    // functionDeclaration : Async? Function identifier '(' params ')' '{' body '}'
-    if (Cur.kind == TokenKind::Tok_Async)
-      advance();
-    if (Cur.kind != TokenKind::Tok_Function)
-      return std::nullopt;
-    advance();
-    // optional identifier
-    // Accept optional identifier, but don't require it
-    if (Cur.kind == TokenKind::Tok_Identifier)
-    {
-      parseIdentifierName();
-    }
-    if (Cur.kind != TokenKind::Tok_LParen)
-      return error("expected '(' after function declaration");
-    advance();
-    // Consume parameters until ')'
-    int parenDepth = 1;
-    while (Cur.kind != TokenKind::Tok_EOF && parenDepth > 0)
-    {
-      if (Cur.kind == TokenKind::Tok_LParen)
-      {
-        parenDepth++;
-        advance();
-        continue;
-      }
-      if (Cur.kind == TokenKind::Tok_RParen)
-      {
-        parenDepth--;
-        advance();
-        continue;
-      }
-      advance();
-    }
-    // Expect '{' for function body
-    if (Cur.kind != TokenKind::Tok_LBrace)
-      return error("expected '{' after function parameter list");
-    // Consume function body until matching '}'
-    int braceDepth = 1;
-    advance();
-    while (Cur.kind != TokenKind::Tok_EOF && braceDepth > 0)
-    {
-      if (Cur.kind == TokenKind::Tok_LBrace)
-        braceDepth++;
-      else if (Cur.kind == TokenKind::Tok_RBrace)
-        braceDepth--;
-      advance();
-    }
-    return ParseResult{true, std::string(), nullptr};
-  }
+    return parseFunctionDeclaration();
   default:
     return std::nullopt;
   }
@@ -1119,26 +1234,15 @@ std::optional<ParseResult> Parser::parseDeclaration()
 std::optional<ParseResult> Parser::parseThrowStatement()
 {
   // throwStatement : Throw {this.notLineTerminator()}? expressionSequence eos
-  if (Cur.kind != TokenKind::Tok_Print && Cur.kind != TokenKind::Tok_ConsoleLog)
+  if (Cur.kind != TokenKind::Tok_Throw)
     return std::nullopt;
+  Token throwTok = Cur;
   advance();
-  if (Cur.kind != TokenKind::Tok_LParen)
-    return error("expected '('");
-  advance();
-  // Accept any tokens until matching ')'
-  int parenDepth = 1;
-  while (Cur.kind != TokenKind::Tok_EOF && parenDepth > 0)
-  {
-    if (Cur.kind == TokenKind::Tok_LParen)
-    {
-      parenDepth++;
-    }
-    else if (Cur.kind == TokenKind::Tok_RParen)
-    {
-      parenDepth--;
-    }
-    advance();
-  }
+  if (L.ContainsLineTerminatorBetween(throwTok.pos + throwTok.text.size(), Cur.pos))
+    return error("illegal newline after throw");
+  if (!parseExpressionSequence())
+    return error("invalid throw expression");
+  parseEos();
   return ParseResult{true, std::string(), nullptr};
 }
 
@@ -1230,20 +1334,28 @@ std::optional<ParseResult> Parser::parseFunctionDeclaration()
 {
   // functionDeclaration
   //   : Async? Function_ '*'? identifier '(' formalParameterList? ')' functionBody
-  auto save = Cur;
+  size_t start = Cur.pos;
   // optional Async
+  bool isAsync = false;
   if (Cur.kind == TokenKind::Tok_Async)
+  {
+    if (peekToken().kind != TokenKind::Tok_Function)
+      return std::nullopt;
+    isAsync = true;
     advance();
+  }
   if (Cur.kind != TokenKind::Tok_Function)
-  {
-    Cur = save;
     return std::nullopt;
-  }
   advance();
   // optional '*' (not tokenized specially here; accept a Multiply token or skip if absent)
+  bool isGenerator = false;
   if (Cur.kind == TokenKind::Tok_Multiply)
+  {
+    isGenerator = true;
     advance();
+  }
   // required identifier (function name)
+  std::string_view name = Cur.text;
   if (!parseIdentifierName())
   {
     return error("expected function name after 'function' keyword");
@@ -1252,70 +1364,76 @@ std::optional<ParseResult> Parser::parseFunctionDeclaration()
   if (Cur.kind != TokenKind::Tok_LParen)
     return error("expected '(' after function declaration");
   advance();
-  // consume parameter list tokens until matching ')'
-  int depth = 1;
-  while (Cur.kind != TokenKind::Tok_EOF && depth > 0)
+  // Plain `name` / `name: type` parameters are collected; anything else
+  // (defaults, patterns, rest) is skipped and the declaration stays raw.
+  std::vector<std::string_view> params, paramTypes;
+  bool simpleParams = true;
+  if (!parseParameterList(params, simpleParams, &paramTypes))
+    return error("expected ')' after function parameter list");
+  // optional return type annotation
+  std::string_view returnType;
+  if (Cur.kind == TokenKind::Tok_Colon)
   {
-    if (Cur.kind == TokenKind::Tok_LParen)
-    {
-      depth++;
-      advance();
-      continue;
-    }
-    if (Cur.kind == TokenKind::Tok_RParen)
-    {
-      depth--;
-      advance();
-      continue;
-    }
     advance();
+    if (!parseType())
+      return error("invalid function return type");
+    returnType = Ast.intern(typeToString(takeParsedType().get()));
   }
-  if (depth != 0)
-    return error("expected ')' after function parameter list");
   // expect '{' for function body
   if (Cur.kind != TokenKind::Tok_LBrace)
     return error("expected '{' after function parameter list");
-  // consume function body until matching '}'
-  int braceDepth = 1;
-  advance();
-  while (Cur.kind != TokenKind::Tok_EOF && braceDepth > 0)
+  auto body = parseBlock();
+  if (!body->ok)
+    return body;
+  if (!simpleParams || isAsync || isGenerator)
+    return ParseResult{true, std::string(), Ast.make<RawStmt>(start)};
+  return ParseResult{true, std::string(), Ast.make<FunctionDecl>(Ast.intern(name), Ast.list(params), static_cast<BlockStmt *>(body->stmt),
+                                                                   Ast.list(paramTypes), returnType)};
+}
+
+bool Parser::parseParameterList(std::vector<std::string_view> &params, bool &simple,
+                                std::vector<std::string_view> *types)
+{
+  while (Cur.kind != TokenKind::Tok_RParen && Cur.kind != TokenKind::Tok_EOF)
   {
-    if (Cur.kind == TokenKind::Tok_LBrace)
-    {
-      braceDepth++;
-      advance();
-      continue;
-    }
-    if (Cur.kind == TokenKind::Tok_RBrace)
+    std::string_view param = Cur.text;
+    if (simple && parseIdentifier())
     {
-      braceDepth--;
-      advance();
-      continue;
+      std::string_view type;
+      if (Cur.kind == TokenKind::Tok_Colon)
+      {
+        advance();
+        if (!parseType())
+          return false;
+        type = Ast.intern(typeToString(takeParsedType().get()));
+      }
+      params.push_back(Ast.intern(param));
+      if (types)
+        types->push_back(type);
+      if (Cur.kind == TokenKind::Tok_Comma)
+      {
+        advance();
+        continue;
+      }
+      if (Cur.kind == TokenKind::Tok_RParen)
+        break;
     }
-    advance();
-  }
-  if (braceDepth != 0)
-    return error("expected '}' after function body");
-  // For now, just return success
-  return ParseResult{true, std::string(), nullptr};
-  while (Cur.kind != TokenKind::Tok_EOF)
-  {
-    if (Cur.kind == TokenKind::Tok_LParen)
-      depth++;
-    else if (Cur.kind == TokenKind::Tok_RParen)
+    // consume the rest of the parameter list tokens until the matching ')'
+    simple = false;
+    int depth = 1;
+    while (Cur.kind != TokenKind::Tok_EOF)
     {
-      depth--;
-      advance();
-      if (depth == 0)
+      if (Cur.kind == TokenKind::Tok_LParen)
+        depth++;
+      else if (Cur.kind == TokenKind::Tok_RParen && --depth == 0)
         break;
-      continue;
+      advance();
     }
-    advance();
   }
-  // now functionBody
-  if (!parseFunctionBody())
-    return error("invalid function body");
-  return ParseResult{true, std::string(), nullptr};
+  if (Cur.kind != TokenKind::Tok_RParen)
+    return false;
+  advance();
+  return true;
 }
 
 std::optional<ParseResult> Parser::parseClassDeclaration()
@@ -1324,16 +1442,16 @@ std::optional<ParseResult> Parser::parseClassDeclaration()
   // classDeclaration : Class identifier classTail
   if (Cur.kind != TokenKind::Tok_Class)
     return std::nullopt;
+  size_t start = Cur.pos;
   advance();
+  std::string_view name = Cur.text;
   // std::cerr << "DEBUG: after Class advance Cur.kind=" << (int)Cur.kind << " text='" << Cur.text << "' pos=" << Cur.pos << "\n";
   // require identifier (class name) if present: use parseIdentifierName
-  if (parseIdentifierName())
-  {
-    // std::cerr << "DEBUG: after class name advance Cur.kind=" << (int)Cur.kind << " text='" << Cur.text << "' pos=" << Cur.pos << "\n";
-  }
+  if (!parseIdentifierName())
+    name = {};
   // std::cerr << "DEBUG: after parseIdentifierName Cur.kind=" << (int)Cur.kind << " text='" << Cur.text << "' pos=" << Cur.pos << "\n";
-  // Robustly advance to '{' after class name
-  if (Cur.kind != TokenKind::Tok_LBrace)
+  // Robustly advance to '{' (or the heritage clause) after class name
+  if (Cur.kind != TokenKind::Tok_LBrace && Cur.kind != TokenKind::Tok_Extends)
   {
     std::cerr << "WARNING: Forcibly advancing to '{' after class name. Cur.kind=" << (int)Cur.kind << " text='" << Cur.text << "' pos=" << Cur.pos << "\n";
     while (Cur.kind != TokenKind::Tok_LBrace && Cur.kind != TokenKind::Tok_EOF)
@@ -1342,9 +1460,10 @@ std::optional<ParseResult> Parser::parseClassDeclaration()
       std::cerr << "TRACE: Advancing to '{'... Cur.kind=" << (int)Cur.kind << " text='" << Cur.text << "' pos=" << Cur.pos << "\n";
     }
   }
-  if (Cur.kind == TokenKind::Tok_LBrace)
+  Expr *superClass = nullptr;
+  if (Cur.kind == TokenKind::Tok_LBrace || Cur.kind == TokenKind::Tok_Extends)
   {
-    if (!parseClassTail())
+    if (!parseClassTail(&superClass))
       return error("invalid class tail");
   }
   else
@@ -1367,10 +1486,10 @@ std::optional<ParseResult> Parser::parseClassDeclaration()
   }
   // Consume trailing semicolon or EOS after class declaration
   parseEos();
-  return ParseResult{true, std::string(), nullptr};
+  return ParseResult{true, std::string(), Ast.make<ClassDecl>(Ast.intern(name), superClass, start)};
 }
 
-bool Parser::parseClassTail()
+bool Parser::parseClassTail(Expr **superClass)
 {
   // std::cerr << "DEBUG: enter parseClassTail Cur.kind=" << (int)Cur.kind << " text='" << Cur.text << "' pos=" << Cur.pos << "\n";
   // classTail : (Extends singleExpression)? '{' classElement* '}'
@@ -1379,6 +1498,8 @@ bool Parser::parseClassTail()
     advance();
     if (!parseSingleExpression())
       return false;
+    if (superClass)
+      *superClass = takeParsedExpr();
   }
   if (Cur.kind != TokenKind::Tok_LBrace)
     return false;
@@ -1524,20 +1645,22 @@ bool Parser::parseClassElement()
 std::optional<ParseResult> Parser::parseSourceElements()
 {
   // sourceElements : sourceElement*
-  std::vector<std::unique_ptr<Stmt>> stmts;
+  std::vector<Stmt *> stmts;
   int iter = 0;
   while (Cur.kind != TokenKind::Tok_EOF)
   {
     Token before = Cur;
     bool advanced = false;
-    std::unique_ptr<Stmt> stmt;
+    Stmt *stmt = nullptr;
     // Top-level class declaration
     if (Cur.kind == TokenKind::Tok_Class)
     {
       auto s = parseClassDeclaration();
       if (!s)
         break;
-      stmt = std::move(s->stmt);
+      if (!s->ok)
+        return s;
+      stmt = s->stmt;
       advanced = true;
     }
     // Top-level function declaration
@@ -1546,66 +1669,21 @@ std::optional<ParseResult> Parser::parseSourceElements()
       auto s = parseFunctionDeclaration();
       if (!s)
         break;
-      stmt = std::move(s->stmt);
+      if (!s->ok)
+        return s;
+      stmt = s->stmt;
       advanced = true;
     }
-    // Top-level variable declaration (const, var)
-    else if (Cur.kind == TokenKind::Tok_Const || Cur.kind == TokenKind::Tok_Var)
+    // Top-level variable declaration (const, var, let)
+    else if (Cur.kind == TokenKind::Tok_Const || Cur.kind == TokenKind::Tok_Var ||
+             Cur.kind == TokenKind::Tok_NonStrictLet || Cur.kind == TokenKind::Tok_StrictLet)
     {
-      // Parse: const <name> = <expr>;
-      advance();
-      if (Cur.kind != TokenKind::Tok_Identifier) break;
-      std::string varName = Cur.text;
-      advance();
-      if (Cur.kind != TokenKind::Tok_Assign) break;
-      advance();
-      // Parse the expression (object literal, number, string, etc.)
-      std::unique_ptr<Expr> valueExpr;
-      if (Cur.kind == TokenKind::Tok_LBrace) {
-        // Parse object literal as a string, capturing all tokens and whitespace until matching closing brace
-        std::string objStr;
-        int depth = 0;
-        bool first = true;
-        int startPos = Cur.pos;
-        int endPos = Cur.pos;
-        // Save the starting position
-        while (Cur.kind != TokenKind::Tok_EOF) {
-          if (Cur.kind == TokenKind::Tok_LBrace) {
-            depth++;
-          } else if (Cur.kind == TokenKind::Tok_RBrace) {
-            depth--;
-          }
-          endPos = Cur.pos + Cur.text.size();
-          // Advance after checking, so we include the last RBrace
-          if (depth == 0) {
-            // Include the last RBrace
-            objStr = L.getSource().substr(startPos, endPos - startPos);
-            advance();
-            break;
-          }
-          advance();
-        }
-        valueExpr = std::make_unique<LiteralExpr>(objStr);
-      } else if (Cur.kind == TokenKind::Tok_Number || Cur.kind == TokenKind::Tok_Integer) {
-        valueExpr = std::make_unique<LiteralExpr>(Cur.text);
-        advance();
-      } else if (Cur.kind == TokenKind::Tok_BooleanLiteral) {
-        valueExpr = std::make_unique<LiteralExpr>(Cur.text);
-        advance();
-      } else if (Cur.kind == TokenKind::Tok_StringLiteral) {
-        std::string lit = Cur.text;
-        if (lit.size() >= 2 && ((lit.front() == '"' && lit.back() == '"') || (lit.front() == '\'' && lit.back() == '\''))) {
-          lit = lit.substr(1, lit.size() - 2);
-        }
-        valueExpr = std::make_unique<LiteralExpr>(lit);
-        advance();
-      } else {
-        // fallback: skip
+      auto s = parseVariableStatement();
+      if (!s)
         break;
-      }
-      stmts.push_back(std::make_unique<VarDeclStmt>(varName, std::move(valueExpr)));
-      // Optional semicolon
-      if (Cur.kind == TokenKind::Tok_Semi) advance();
+      if (!s->ok)
+        return s;
+      stmt = s->stmt;
       advanced = true;
     }
     // Top-level import/export/print
@@ -1614,79 +1692,46 @@ std::optional<ParseResult> Parser::parseSourceElements()
       auto s = parseStatement();
       if (!s)
         break;
-      stmt = std::move(s->stmt);
+      if (!s->ok)
+        return s;
+      stmt = s->stmt;
       advanced = true;
       // If the parsed statement is a PrintStmt, call parseEos()
-      if (stmt && dynamic_cast<PrintStmt*>(stmt.get())) {
+      if (ast_cast<PrintStmt>(stmt)) {
         parseEos();
       }
     }
-    else if (Cur.kind == TokenKind::Tok_ConsoleLog)
-    {
-      auto s = parsePrintStatement();
-      if (!s)
-        break;
-      stmt = std::move(s->stmt);
-      advanced = true;
-      parseEos();
-    }
-    else if (Cur.kind == TokenKind::Tok_ConsoleError)
+    else if (Cur.kind == TokenKind::Tok_ConsoleLog || Cur.kind == TokenKind::Tok_ConsoleError ||
+             Cur.kind == TokenKind::Tok_ConsoleWarn || Cur.kind == TokenKind::Tok_ConsoleInfo ||
+             Cur.kind == TokenKind::Tok_ConsoleSuccess)
     {
       auto s = parsePrintStatement();
       if (!s)
         break;
-      stmt = std::move(s->stmt);
+      if (!s->ok)
+        return s;
+      stmt = s->stmt;
       advanced = true;
       parseEos();
     }
-    else if (Cur.kind == TokenKind::Tok_ConsoleWarn)
+    // Any other statement (expressions, control flow, blocks, ...)
+    else
     {
-      auto s = parsePrintStatement();
-      if (!s)
-        break;
-      stmt = std::move(s->stmt);
-      advanced = true;
-      parseEos();
-    }
-    else if (Cur.kind == TokenKind::Tok_ConsoleInfo)
-    {
-      auto s = parsePrintStatement();
-      if (!s)
-        break;
-      stmt = std::move(s->stmt);
-      advanced = true;
-      parseEos();
-    }
-    else if (Cur.kind == TokenKind::Tok_ConsoleSuccess) {
-      auto s = parsePrintStatement();
-      if (!s)
-        break;
-      stmt = std::move(s->stmt);
-      advanced = true;
-      parseEos();
-    }
-    // Top-level expression statement (e.g., assignments, calls)
-    else if (Cur.kind == TokenKind::Tok_Identifier || Cur.kind == TokenKind::Tok_LParen || Cur.kind == TokenKind::Tok_Number || Cur.kind == TokenKind::Tok_StringLiteral)
-    {
-      auto s = parseExpressionStatement();
+      auto s = parseStatement();
       if (s)
       {
-        stmt = std::move(s->stmt);
-        advanced = true;
+        if (!s->ok)
+          return s;
+        stmt = s->stmt;
       }
       else
       {
         advance();
-        advanced = true;
       }
-    }
-    else
-    {
-      advance();
       advanced = true;
     }
     if (stmt)
-      stmts.push_back(std::move(stmt));
+      stmts.push_back(stmt);
     if (!advanced || (Cur.pos == before.pos && Cur.kind == before.kind))
     {
       advance();
@@ -1696,15 +1741,14 @@ std::optional<ParseResult> Parser::parseSourceElements()
   }
   if (stmts.empty())
     return std::nullopt;
-  auto prog = std::make_unique<Program>(std::move(stmts));
-  return ParseResult{true, std::string(), std::move(prog)};
+  return ParseResult{true, std::string(), Ast.make<Program>(Ast.list(stmts))};
 }
 
 bool Parser::parseMethodDefinition()
 {
   // methodDefinition: conservative approach
   // try to find '(' followed by ')' then a function body '{'
-  auto save = Cur;
+  auto save = checkpoint();
   // optional Async with optional notLineTerminator predicate (conservative)
   if (Cur.kind == TokenKind::Tok_Async)
   {
@@ -1722,7 +1766,7 @@ bool Parser::parseMethodDefinition()
     advance();
   if (Cur.kind != TokenKind::Tok_LParen)
   {
-    Cur = save;
+    rewind(save);
     return false;
   }
   // consume parameters quickly until matching ')'
@@ -1744,7 +1788,7 @@ bool Parser::parseMethodDefinition()
   // expect function body
   if (!parseFunctionBody())
   {
-    Cur = save;
+    rewind(save);
     return false;
   }
   return true;
@@ -1754,10 +1798,10 @@ bool Parser::parseFunctionBody()
 {
   // functionBody : '{' sourceElements? '}'
   // Reuse parseBlock which returns an optional ParseResult; convert to bool.
-  auto save = Cur;
+  auto save = checkpoint();
   if (!parseBlock())
   {
-    Cur = save;
+    rewind(save);
     return false;
   }
   return true;
@@ -1766,11 +1810,11 @@ bool Parser::parseFunctionBody()
 bool Parser::parseFieldDefinition()
 {
   // fieldDefinition : classElementName initializer?
-  auto save = Cur;
+  auto save = checkpoint();
   // accept a classElementName
   if (!parseClassElementName())
   {
-    Cur = save;
+    rewind(save);
     return false;
   }
   // optional initializer
@@ -1779,7 +1823,7 @@ bool Parser::parseFieldDefinition()
     advance();
     if (!parseSingleExpression())
     {
-      Cur = save;
+      rewind(save);
       return false;
     }
   }
@@ -1846,13 +1890,13 @@ bool Parser::parseFormalParameterList()
   //   | lastFormalParameterArg
   // Conservative implementation: parse formalParameterArg (assignable ('=' singleExpression)?)
   // or lastFormalParameterArg (Ellipsis singleExpression)
-  auto save = Cur;
+  auto save = checkpoint();
   if (parseLastFormalParameterArg())
     return true;
   // otherwise must start with a formalParameterArg
   if (!parseFormalParameterArg())
   {
-    Cur = save;
+    rewind(save);
     return false;
   }
   while (Cur.kind == TokenKind::Tok_Comma)
@@ -1863,7 +1907,7 @@ bool Parser::parseFormalParameterList()
       return true;
     if (!parseFormalParameterArg())
     {
-      Cur = save;
+      rewind(save);
       return false;
     }
   }
@@ -1898,23 +1942,17 @@ bool Parser::parseLastFormalParameterArg()
 std::optional<ParseResult> Parser::parseVariableStatement()
 {
   // variableStatement : variableDeclarationList eos
-  auto save = Cur;
-  if (!parseVariableDeclarationList())
-  {
-    Cur = save;
+  if (Cur.kind != TokenKind::Tok_Var && Cur.kind != TokenKind::Tok_Const &&
+      Cur.kind != TokenKind::Tok_NonStrictLet && Cur.kind != TokenKind::Tok_StrictLet)
     return std::nullopt;
-  }
+  std::vector<Stmt *> decls;
+  if (!parseVariableDeclarationList(&decls))
+    return error("invalid variable declaration");
   // accept semicolon or EOF as eos
   parseEos();
-  // If the last variable declaration included a type annotation, print it
-  if (LastTypeParsed)
-  {
-    // std::cerr << "DEBUG: parsed type annotation: " << typeToString(LastTypeParsed.get()) << "\n";
-    // clear it; variable declaration handling is currently per-declaration so
-    // we don't attach types to AST nodes yet.
-    LastTypeParsed.reset();
-  }
-  return ParseResult{true, std::string(), nullptr};
+  if (decls.size() == 1)
+    return ParseResult{true, std::string(), decls.front()};
+  return ParseResult{true, std::string(), Ast.make<BlockStmt>(Ast.list(decls), true)};
 }
 
 std::unique_ptr<Type> Parser::takeParsedType()
@@ -1922,17 +1960,22 @@ std::unique_ptr<Type> Parser::takeParsedType()
   return std::move(LastTypeParsed);
 }
 
-bool Parser::parseVariableDeclarationList()
+Expr *Parser::takeParsedExpr()
+{
+  return std::exchange(LastExprParsed, nullptr);
+}
+
+bool Parser::parseVariableDeclarationList(std::vector<Stmt *> *decls)
 {
   // variableDeclarationList : varModifier variableDeclaration (',' variableDeclaration)*
   if (!parseVarModifier())
     return false;
-  if (!parseVariableDeclaration())
+  if (!parseVariableDeclaration(decls))
     return false;
   while (Cur.kind == TokenKind::Tok_Comma)
   {
     advance();
-    if (!parseVariableDeclaration())
+    if (!parseVariableDeclaration(decls))
       return false;
   }
   return true;
@@ -1970,28 +2013,42 @@ bool Parser::parseLet_()
   }
 }
 
-bool Parser::parseVariableDeclaration()
+bool Parser::parseVariableDeclaration(std::vector<Stmt *> *decls)
 {
   // variableDeclaration : assignable ('=' singleExpression)?
+  size_t start = Cur.pos;
+  bool pattern = Cur.kind == TokenKind::Tok_LBrace || Cur.kind == TokenKind::Tok_LBracket;
+  std::string_view name = Cur.text;
   if (!parseAssignable())
     return false;
   // optional TypeScript type annotation
+  std::string_view type;
   if (Cur.kind == TokenKind::Tok_Colon)
   {
     advance();
     if (!parseType())
       return false;
+    type = Ast.intern(typeToString(takeParsedType().get()));
   }
+  Expr *init = nullptr;
   if (Cur.kind == TokenKind::Tok_Assign)
   {
     advance();
     if (!parseSingleExpression())
       return false;
+    init = takeParsedExpr();
+  }
+  if (decls)
+  {
+    if (pattern)
+      decls->push_back(Ast.make<RawStmt>(start));
+    else
+      decls->push_back(Ast.make<VarDeclStmt>(Ast.intern(name), init, type));
   }
   return true;
 }
 
-bool Parser::parseType()
+bool Parser::parseTypeImpl()
 {
   // Conservative Type parser supporting:
   //  - primary types: identifier or builtin type tokens
@@ -2082,7 +2139,7 @@ bool Parser::parseType()
     case TokenKind::Tok_Object:
     {
       // capture the name text
-      std::string name = Cur.text;
+      std::string name = Cur.str();
       advance();
       std::unique_ptr<Type> base = std::make_unique<NamedType>(name);
       // generics: '<' ... '>' -- parse comma-separated types inside balancing '<' '>'
@@ -2204,126 +2261,147 @@ bool Parser::parseAssignable()
 bool Parser::parseObjectLiteral()
 {
   // objectLiteral : '{' (propertyAssignment (',' propertyAssignment)* ','?)? '}'
+  // `key: value` and shorthand properties are recognized directly from their
+  // leading tokens and build an ObjectExpr; any other property form goes
+  // through parsePropertyAssignment and leaves the literal a RawExpr.
   if (Cur.kind != TokenKind::Tok_LBrace)
     return false;
+  size_t start = Cur.pos;
   advance();
-  // empty object
-  if (Cur.kind == TokenKind::Tok_RBrace)
-  {
-    advance();
-    return true;
-  }
-  // try propertyAssignment optionally separated by commas, allow trailing comma
-  if (!parsePropertyAssignment())
-  {
-    // allow malformed but consume until '}' conservatively
-    while (Cur.kind != TokenKind::Tok_RBrace && Cur.kind != TokenKind::Tok_EOF)
-      advance();
-    if (Cur.kind == TokenKind::Tok_RBrace)
+  std::vector<ObjectProperty> props;
+  bool modeled = true;
+  while (Cur.kind != TokenKind::Tok_RBrace)
+  {
+    const Token &next = peekToken();
+    if (next.kind == TokenKind::Tok_Colon && Cur.kind != TokenKind::Tok_LBracket)
+    {
+      std::string_view key = Cur.text;
+      if (Cur.kind == TokenKind::Tok_StringLiteral && key.size() >= 2)
+        key = key.substr(1, key.size() - 2);
+      if (Cur.kind == TokenKind::Tok_StringLiteral || Cur.kind == TokenKind::Tok_Integer ||
+          Cur.kind == TokenKind::Tok_DecimalLiteral)
+        advance();
+      else if (!parseIdentifierName())
+        return false;
+      advance(); // ':'
+      if (!parseSingleExpression())
+        return false;
+      props.push_back({Ast.intern(key), takeParsedExpr()});
+    }
+    else if (Cur.kind == TokenKind::Tok_Identifier &&
+             (next.kind == TokenKind::Tok_Comma || next.kind == TokenKind::Tok_RBrace))
     {
+      std::string_view name = Ast.intern(Cur.text);
       advance();
-      return true;
+      props.push_back({name, Ast.make<IdentifierExpr>(name)});
     }
-    return false;
-  }
-  while (Cur.kind == TokenKind::Tok_Comma)
-  {
-    advance();
-    if (Cur.kind == TokenKind::Tok_RBrace)
-      break; // trailing comma
-    if (!parsePropertyAssignment())
+    else
     {
-      // consume until '}' conservatively
-      while (Cur.kind != TokenKind::Tok_RBrace && Cur.kind != TokenKind::Tok_EOF)
-        advance();
-      break;
+      modeled = false;
+      if (!parsePropertyAssignment())
+        return false;
     }
+    if (Cur.kind != TokenKind::Tok_Comma)
+      break;
+    advance(); // a trailing comma is allowed
   }
   if (Cur.kind != TokenKind::Tok_RBrace)
     return false;
   advance();
+  if (modeled)
+    LastExprParsed = Ast.make<ObjectExpr>(Ast.list(props), start);
+  else
+    LastExprParsed = Ast.make<RawExpr>(start);
   return true;
 }
 
-bool Parser::parseAnonymousFunction()
+bool Parser::parseAnonymousFunctionImpl()
 {
   // anonymousFunction
   //   : functionDeclaration
   //   | Async? Function_ '*'? '(' formalParameterList? ')' functionBody
   //   | Async? arrowFunctionParameters '=>' arrowFunctionBody
-  // Conservative recognizer: try functionDeclaration first, then anonymous function syntax, then arrow functions.
-  auto save = Cur;
-  // try a full functionDeclaration (may be named)
-  if (auto fd = parseFunctionDeclaration())
-    return true;
-  Cur = save;
-
-  // Async? Function_ '*'? '(' formalParameterList? ')' functionBody
+  // parseSingleExpression only calls this when one of the forms is ahead, so the
+  // alternative is chosen from the leading tokens without backtracking. Builds a
+  // FunctionExpr, or a RawExpr for async/generator functions and parameter
+  // lists with defaults, patterns or rest elements.
+  size_t start = Cur.pos;
+  bool modeled = true;
   if (Cur.kind == TokenKind::Tok_Async)
   {
+    modeled = false;
     advance();
   }
+  std::vector<std::string_view> params;
   if (Cur.kind == TokenKind::Tok_Function)
   {
     advance();
     if (Cur.kind == TokenKind::Tok_Multiply)
+    {
+      modeled = false;
       advance();
+    }
+    // optional function name
+    std::string_view name;
     if (Cur.kind != TokenKind::Tok_LParen)
     {
-      Cur = save;
-      return false;
+      name = Cur.text;
+      if (!parseIdentifierName())
+        return false;
     }
-    // consume parameter list quickly
-    if (!parseArguments())
-    {
-      Cur = save;
+    if (Cur.kind != TokenKind::Tok_LParen)
       return false;
-    }
-    if (!parseFunctionBody())
-    {
-      Cur = save;
+    advance();
+    if (!parseParameterList(params, modeled))
       return false;
-    }
+    auto body = parseBlock();
+    if (!body || !body->ok)
+      return false;
+    if (modeled)
+      LastExprParsed = Ast.make<FunctionExpr>(Ast.intern(name), Ast.list(params), static_cast<BlockStmt *>(body->stmt), false, start);
+    else
+      LastExprParsed = Ast.make<RawExpr>(start);
     return true;
   }
-  Cur = save;
-
-  // Async? arrowFunctionParameters '=>' arrowFunctionBody
-  if (Cur.kind == TokenKind::Tok_Async)
+  // arrowFunctionParameters : propertyName | '(' formalParameterList? ')'
+  if (Cur.kind == TokenKind::Tok_LParen)
   {
     advance();
+    if (!parseParameterList(params, modeled))
+      return false;
   }
-  if (parseArrowFunctionParameters())
+  else
   {
-    // expect '=>' (lexer uses Tok_Arrow)
-    if (Cur.kind != TokenKind::Tok_Arrow)
-    {
-      Cur = save;
+    std::string_view param = Cur.text;
+    if (!parsePropertyName())
       return false;
-    }
-    advance();
-    // arrowFunctionBody: singleExpression | functionBody
-    if (Cur.kind == TokenKind::Tok_LBrace)
-    {
-      if (!parseFunctionBody())
-      {
-        Cur = save;
-        return false;
-      }
-    }
-    else
-    {
-      if (!parseSingleExpression())
-      {
-        Cur = save;
-        return false;
-      }
-    }
-    return true;
+    params.push_back(Ast.intern(param));
   }
-
-  Cur = save;
-  return false;
+  // expect '=>' (lexer uses Tok_Arrow)
+  if (Cur.kind != TokenKind::Tok_Arrow)
+    return false;
+  advance();
+  // arrowFunctionBody : singleExpression | functionBody
+  BlockStmt *body = nullptr;
+  if (Cur.kind == TokenKind::Tok_LBrace)
+  {
+    auto block = parseBlock();
+    if (!block || !block->ok)
+      return false;
+    body = static_cast<BlockStmt *>(block->stmt);
+  }
+  else
+  {
+    if (!parseSingleExpression())
+      return false;
+    std::vector<Stmt *> ret{Ast.make<ReturnStmt>(takeParsedExpr())};
+    body = Ast.make<BlockStmt>(Ast.list(ret));
+  }
+  if (modeled)
+    LastExprParsed = Ast.make<FunctionExpr>(std::string_view(), Ast.list(params), body, true, start);
+  else
+    LastExprParsed = Ast.make<RawExpr>(start);
+  return true;
 }
 
 bool Parser::parseArrayLiteral()
@@ -2389,86 +2467,6 @@ bool Parser::parseArrayElement()
   return false;
 }
 
-bool Parser::parseArrowFunctionParameters()
-{
-  // arrowFunctionParameters : propertyName | '(' formalParameterList? ')'
-  auto save = Cur;
-  // parenthesized form
-  if (Cur.kind == TokenKind::Tok_LParen)
-  {
-    // consume '(' and optional parameter list, reusing formal parameter parsing
-    advance();
-    if (Cur.kind != TokenKind::Tok_RParen)
-    {
-      if (!parseFormalParameterList())
-      {
-        Cur = save;
-        return false;
-      }
-    }
-    if (Cur.kind != TokenKind::Tok_RParen)
-    {
-      Cur = save;
-      return false;
-    }
-    advance();
-    return true;
-  }
-
-  // propertyName form - accept identifierName | StringLiteral | numericLiteral | '[' singleExpression ']'
-  if (parsePropertyName())
-    return true;
-
-  Cur = save;
-  return false;
-}
-
-bool Parser::parseArrowFunctionBody()
-{
-  // arrowFunctionBody : singleExpression | functionBody
-  auto save = Cur;
-  if (Cur.kind == TokenKind::Tok_LBrace)
-  {
-    if (!parseFunctionBody())
-    {
-      Cur = save;
-      return false;
-    }
-    return true;
-  }
-  // otherwise try singleExpression
-  if (parseSingleExpression())
-    return true;
-  Cur = save;
-  return false;
-}
-
-bool Parser::parseAssignmentOperator()
-{
-  // assignmentOperator
-  // : '*=' | '/=' | '%=' | '+=' | '-=' | '<<=' | '>>=' | '>>>=' | '&=' | '^=' | '|=' | '**=' | '??='
-  switch (Cur.kind)
-  {
-  case TokenKind::Tok_MultiplyAssign:             // '*='
-  case TokenKind::Tok_DivideAssign:               // '/='
-  case TokenKind::Tok_ModulusAssign:              // '%='
-  case TokenKind::Tok_PlusAssign:                 // '+='
-  case TokenKind::Tok_MinusAssign:                // '-='
-  case TokenKind::Tok_LeftShiftArithmeticAssign:  // '<<='
-  case TokenKind::Tok_RightShiftArithmeticAssign: // '>>='
-  case TokenKind::Tok_RightShiftLogicalAssign:    // '>>>='
-  case TokenKind::Tok_BitAndAssign:               // '&='
-  case TokenKind::Tok_BitXorAssign:               // '^='
-  case TokenKind::Tok_BitOrAssign:                // '|='
-  case TokenKind::Tok_PowerAssign:                // '**='
-  case TokenKind::Tok_NullishCoalescingAssign:    // '??='
-    advance();
-    return true;
-  default:
-    return false;
-  }
-}
-
 bool Parser::parseLiteral()
 {
   // literal
@@ -2628,7 +2626,7 @@ bool Parser::parsePropertyName()
 bool Parser::parsePropertyAssignment()
 {
   // propertyAssignment alternatives (conservative)
-  auto save = Cur;
+  auto save = checkpoint();
   // 1) propertyName ':' singleExpression
   if (parsePropertyName())
   {
@@ -2637,13 +2635,13 @@ bool Parser::parsePropertyAssignment()
       advance();
       if (!parseSingleExpression())
       {
-        Cur = save;
+        rewind(save);
         return false;
       }
       return true;
     }
     // if not colon, restore and try other forms
-    Cur = save;
+    rewind(save);
   }
 
   // 2) '[' singleExpression ']' ':' singleExpression (ComputedPropertyExpressionAssignment)
@@ -2652,31 +2650,31 @@ bool Parser::parsePropertyAssignment()
     advance();
     if (!parseSingleExpression())
     {
-      Cur = save;
+      rewind(save);
       return false;
     }
     if (Cur.kind != TokenKind::Tok_RBracket)
     {
-      Cur = save;
+      rewind(save);
       return false;
     }
     advance();
     if (Cur.kind != TokenKind::Tok_Colon)
     {
-      Cur = save;
+      rewind(save);
       return false;
     }
     advance();
     if (!parseSingleExpression())
     {
-      Cur = save;
+      rewind(save);
       return false;
     }
     return true;
   }
 
   // 3) Async? '*'? propertyName '(' formalParameterList? ')' functionBody  (FunctionProperty)
-  Cur = save;
+  rewind(save);
   if (Cur.kind == TokenKind::Tok_Async)
     advance();
   if (Cur.kind == TokenKind::Tok_Multiply)
@@ -2691,78 +2689,78 @@ bool Parser::parsePropertyAssignment()
       {
         if (!parseFormalParameterList())
         {
-          Cur = save;
+          rewind(save);
           return false;
         }
       }
       if (Cur.kind != TokenKind::Tok_RParen)
       {
-        Cur = save;
+        rewind(save);
         return false;
       }
       advance();
       if (!parseFunctionBody())
       {
-        Cur = save;
+        rewind(save);
         return false;
       }
       return true;
     }
   }
-  Cur = save;
+  rewind(save);
 
   // 4) getter '(' ')' functionBody
   if (parseGetter())
   {
     if (Cur.kind != TokenKind::Tok_LParen)
     {
-      Cur = save;
+      rewind(save);
       return false;
     }
     advance();
     if (Cur.kind != TokenKind::Tok_RParen)
     {
-      Cur = save;
+      rewind(save);
       return false;
     }
     advance();
     if (!parseFunctionBody())
     {
-      Cur = save;
+      rewind(save);
       return false;
     }
     return true;
   }
-  Cur = save;
+  rewind(save);
 
   // 5) setter '(' formalParameterArg ')' functionBody
   if (parseSetter())
   {
     if (Cur.kind != TokenKind::Tok_LParen)
     {
-      Cur = save;
+      rewind(save);
       return false;
     }
     advance();
     if (!parseFormalParameterArg())
     {
-      Cur = save;
+      rewind(save);
       return false;
     }
     if (Cur.kind != TokenKind::Tok_RParen)
     {
-      Cur = save;
+      rewind(save);
       return false;
     }
     advance();
     if (!parseFunctionBody())
     {
-      Cur = save;
+      rewind(save);
       return false;
     }
     return true;
   }
-  Cur = save;
+  rewind(save);
 
   // 6) Ellipsis? singleExpression  (PropertyShorthand)
   if (Cur.kind == TokenKind::Tok_Ellipsis)
@@ -2770,7 +2768,7 @@ bool Parser::parsePropertyAssignment()
     advance();
     if (!parseSingleExpression())
     {
-      Cur = save;
+      rewind(save);
       return false;
     }
     return true;
@@ -2787,33 +2785,33 @@ bool Parser::parseGetter()
   // Enforce the grammar predicate {this.n("get")}?: only accept when current
   // token text equals "get" and there is no line terminator between the
   // previous token and this one. Otherwise fall back to conservative behavior.
-  auto save = Cur;
+  auto save = checkpoint();
   if (n("get"))
   {
     // consume the 'get' contextual keyword
     advance();
     if (!parseIdentifierName())
     {
-      Cur = save;
+      rewind(save);
       return false;
     }
     if (!parseClassElementName())
     {
-      Cur = save;
+      rewind(save);
       return false;
     }
     return true;
   }
   // Fallback: accept identifier-like name followed by classElementName
-  Cur = save;
+  rewind(save);
   if (!parseIdentifierName())
   {
-    Cur = save;
+    rewind(save);
     return false;
   }
   if (!parseClassElementName())
   {
-    Cur = save;
+    rewind(save);
     return false;
   }
   return true;
@@ -2822,31 +2820,31 @@ bool Parser::parseGetter()
 bool Parser::parseSetter()
 {
   // setter : {this.n("set")}? identifier classElementName
-  auto save = Cur;
+  auto save = checkpoint();
   if (n("set"))
   {
     advance();
     if (!parseIdentifierName())
     {
-      Cur = save;
+      rewind(save);
       return false;
     }
     if (!parseClassElementName())
     {
-      Cur = save;
+      rewind(save);
       return false;
     }
     return true;
   }
-  Cur = save;
+  rewind(save);
   if (!parseIdentifierName())
   {
-    Cur = save;
+    rewind(save);
     return false;
   }
   if (!parseClassElementName())
   {
-    Cur = save;
+    rewind(save);
     return false;
   }
   return true;
@@ -2869,169 +2867,279 @@ bool Parser::n(const std::string &s)
   return !L.ContainsLineTerminatorBetween(from, to);
 }
 
-bool Parser::parseSingleExpression()
+bool Parser::arrowFunctionAheadImpl()
 {
-  // Structured, conservative recognizer for singleExpression per grammar.
-  // Try anonymousFunction first (grammar alternative order)
+  // `ident =>`, `async ident =>`, or a balanced `( ... )` (optionally after
+  // async) followed by `=>`.
+  size_t i = TokIdx;
+  auto at = [&](size_t k) -> const Token & { return Tokens[std::min(k, Tokens.size() - 1)]; };
+  if (at(i).kind == TokenKind::Tok_Async)
+    ++i;
+  const Token &t = at(i);
+  if (t.kind == TokenKind::Tok_LParen)
   {
-    auto save = Cur;
-    if (parseAnonymousFunction())
-      return true;
-    Cur = save;
+    int depth = 1;
+    while (depth > 0)
+    {
+      const Token &u = at(++i);
+      if (u.kind == TokenKind::Tok_EOF)
+        return false;
+      if (u.kind == TokenKind::Tok_LParen)
+        depth++;
+      else if (u.kind == TokenKind::Tok_RParen)
+        depth--;
+    }
+    return at(i + 1).kind == TokenKind::Tok_Arrow;
   }
-  // This recognizes primary expressions, `new` forms, parenthesized expressionSequence,
-  // and common postfix forms (call, member, index, optional chaining) conservatively.
+  if (t.kind == TokenKind::Tok_Identifier || t.kind == TokenKind::Tok_Async ||
+      t.kind == TokenKind::Tok_Yield || t.kind == TokenKind::Tok_Of ||
+      t.kind == TokenKind::Tok_As || t.kind == TokenKind::Tok_From)
+    return at(i + 1).kind == TokenKind::Tok_Arrow;
+  return false;
+}
 
-  // Helper: parse a primary expression
-  auto parsePrimary = [&]() -> bool
+namespace
+{
+// How an infix token combines the operand on its left with what follows.
+enum class InfixKind : uint8_t
+{
+  None,
+  Binary,
+  Assign,
+  Conditional
+};
+
+struct BindingPower
+{
+  uint8_t left = 0;  // how tightly the operator binds its left operand
+  uint8_t right = 0; // minimum binding power accepted for the right operand
+  InfixKind kind = InfixKind::None;
+};
+
+constexpr uint8_t AssignBp = 1;
+constexpr uint8_t ConditionalBp = 2;
+constexpr size_t TokenKindCount = size_t(TokenKind::Tok_Invalid) + 1;
+
+struct InfixTable
+{
+  BindingPower ops[TokenKindCount] = {};
+};
+
+constexpr void setInfix(InfixTable &t, TokenKind k, uint8_t left, uint8_t right, InfixKind kind)
+{
+  t.ops[size_t(k)] = BindingPower{left, right, kind};
+}
+
+// One entry per infix token, loosest first. Left-associative operators take
+// their right operand one level tighter; assignment, '?:' and '**' are
+// right-associative.
+constexpr InfixTable buildInfixTable()
+{
+  InfixTable t;
+  const TokenKind assign[] = {
+      TokenKind::Tok_Assign, TokenKind::Tok_MultiplyAssign, TokenKind::Tok_DivideAssign,
+      TokenKind::Tok_ModulusAssign, TokenKind::Tok_PlusAssign, TokenKind::Tok_MinusAssign,
+      TokenKind::Tok_LeftShiftArithmeticAssign, TokenKind::Tok_RightShiftArithmeticAssign,
+      TokenKind::Tok_RightShiftLogicalAssign, TokenKind::Tok_BitAndAssign, TokenKind::Tok_BitXorAssign,
+      TokenKind::Tok_BitOrAssign, TokenKind::Tok_PowerAssign, TokenKind::Tok_NullishCoalescingAssign};
+  for (TokenKind k : assign)
+    setInfix(t, k, AssignBp, AssignBp, InfixKind::Assign);
+  setInfix(t, TokenKind::Tok_Question, ConditionalBp, AssignBp, InfixKind::Conditional);
+
+  struct Level
   {
-    switch (Cur.kind)
-    {
-    case TokenKind::Tok_Integer:
-    case TokenKind::Tok_DecimalLiteral:
-    case TokenKind::Tok_HexIntegerLiteral:
-    case TokenKind::Tok_OctalIntegerLiteral:
-    case TokenKind::Tok_OctalIntegerLiteral2:
-    case TokenKind::Tok_BinaryIntegerLiteral:
-    case TokenKind::Tok_StringLiteral:
-    case TokenKind::Tok_NullLiteral:
-    case TokenKind::Tok_BooleanLiteral:
-    case TokenKind::Tok_This:
-    case TokenKind::Tok_Super:
-      advance();
+    TokenKind kind;
+    uint8_t bp;
+  };
+  const Level binary[] = {
+      {TokenKind::Tok_NullCoalesce, 3}, {TokenKind::Tok_LogicalOr, 3},
+      {TokenKind::Tok_LogicalAnd, 4},
+      {TokenKind::Tok_BitOr, 5},
+      {TokenKind::Tok_BitXor, 6},
+      {TokenKind::Tok_BitAnd, 7},
+      {TokenKind::Tok_Equals, 8}, {TokenKind::Tok_NotEquals, 8},
+      {TokenKind::Tok_IdentityEquals, 8}, {TokenKind::Tok_IdentityNotEquals, 8},
+      {TokenKind::Tok_LessThan, 9}, {TokenKind::Tok_MoreThan, 9},
+      {TokenKind::Tok_LessThanEquals, 9}, {TokenKind::Tok_GreaterThanEquals, 9},
+      {TokenKind::Tok_Instanceof, 9}, {TokenKind::Tok_In, 9},
+      {TokenKind::Tok_LeftShiftArithmetic, 10}, {TokenKind::Tok_RightShiftArithmetic, 10},
+      {TokenKind::Tok_RightShiftLogical, 10},
+      {TokenKind::Tok_Plus, 11}, {TokenKind::Tok_Minus, 11},
+      {TokenKind::Tok_Multiply, 12}, {TokenKind::Tok_Divide, 12}, {TokenKind::Tok_Modulus, 12}};
+  for (const Level &l : binary)
+    setInfix(t, l.kind, l.bp, l.bp + 1, InfixKind::Binary);
+  setInfix(t, TokenKind::Tok_Power, 13, 13, InfixKind::Binary);
+  return t;
+}
+
+constexpr InfixTable Infix = buildInfixTable();
+} // namespace
+
+bool Parser::parseSingleExpressionImpl()
+{
+  return parseExpression(AssignBp);
+}
+
+bool Parser::parseExpression(int minBp)
+{
+  // Pratt loop: parse a prefix operand, then fold in infix operators from the
+  // Infix table for as long as they bind at least as tightly as minBp. Each
+  // token is looked at once; nothing is retried.
+  //   singleExpression : anonymousFunction | assignment | conditional | binary | unary
+  // Function and arrow forms are only attempted where an assignment could
+  // start and when the upcoming tokens begin one.
+  if (minBp <= AssignBp &&
+      (Cur.kind == TokenKind::Tok_Function ||
+       (Cur.kind == TokenKind::Tok_Async && peekToken().kind == TokenKind::Tok_Function) ||
+       arrowFunctionAhead()))
+  {
+    return parseAnonymousFunction();
+  }
+  // `-a ** b` is a SyntaxError: the base of '**' may be an update
+  // expression but not a unary one, which needs parentheses.
+  bool unaryOperand = Cur.kind == TokenKind::Tok_Plus || Cur.kind == TokenKind::Tok_Minus ||
+                      Cur.kind == TokenKind::Tok_BitNot || Cur.kind == TokenKind::Tok_Not ||
+                      Cur.kind == TokenKind::Tok_Delete || Cur.kind == TokenKind::Tok_Void ||
+                      Cur.kind == TokenKind::Tok_Typeof || Cur.kind == TokenKind::Tok_Await;
+  if (!parseUnaryExpression())
+    return false;
+  while (true)
+  {
+    const BindingPower &bp = Infix.ops[size_t(Cur.kind)];
+    if (bp.kind == InfixKind::None || bp.left < minBp)
       return true;
-    case TokenKind::Tok_LBracket:
-      return parseArrayLiteral();
-    case TokenKind::Tok_LBrace:
+    TokenKind op = Cur.kind;
+    if (op == TokenKind::Tok_Power && unaryOperand)
     {
-      // conservative object literal: consume until matching '}'
-      int depth = 0;
-      while (Cur.kind != TokenKind::Tok_EOF)
-      {
-        if (Cur.kind == TokenKind::Tok_LBrace)
-          depth++;
-        else if (Cur.kind == TokenKind::Tok_RBrace)
-        {
-          depth--;
-          advance();
-          if (depth == 0)
-            return true;
-          continue;
-        }
-        advance();
-      }
+      if (SyntaxError.empty())
+        SyntaxError = "unary operator used immediately before exponentiation expression; use parentheses";
       return false;
     }
-    case TokenKind::Tok_LParen:
+    unaryOperand = false;
+    Expr *lhs = takeParsedExpr();
+    advance();
+    if (bp.kind == InfixKind::Conditional)
     {
-      // parenthesized expressionSequence
-      advance();
-      if (Cur.kind == TokenKind::Tok_RParen)
-      {
-        advance();
-        return true;
-      }
-      if (!parseExpressionSequence())
+      if (!parseExpression(AssignBp))
         return false;
-      if (Cur.kind != TokenKind::Tok_RParen)
+      Expr *consequent = takeParsedExpr();
+      if (Cur.kind != TokenKind::Tok_Colon)
         return false;
       advance();
-      return true;
+      if (!parseExpression(bp.right))
+        return false;
+      LastExprParsed = Ast.make<ConditionalExpr>(lhs, consequent, takeParsedExpr());
+      continue;
     }
-    case TokenKind::Tok_Function:
-    case TokenKind::Tok_Class:
-      // accept token conservatively
-      advance();
-      return true;
-    default:
-      // identifier-like or reserved words allowed as primary
-      if (parseIdentifierName())
-        return true;
+    if (!parseExpression(bp.right))
       return false;
-    }
-  };
+    if (bp.kind == InfixKind::Assign)
+      LastExprParsed = Ast.make<AssignExpr>(op, lhs, takeParsedExpr());
+    else
+      LastExprParsed = Ast.make<BinaryExpr>(op, lhs, takeParsedExpr());
+  }
+}
 
-  // Handle prefix unary operators
-  if (Cur.kind == TokenKind::Tok_PlusPlus || Cur.kind == TokenKind::Tok_MinusMinus)
+bool Parser::parseUnaryExpression()
+{
+  // Prefix operators: ++ -- + - ~ ! delete void typeof await
+  switch (Cur.kind)
   {
-    advance();
-    return parseSingleExpression();
-  }
-  if (Cur.kind == TokenKind::Tok_Plus || Cur.kind == TokenKind::Tok_Minus || Cur.kind == TokenKind::Tok_BitNot || Cur.kind == TokenKind::Tok_Not)
+  case TokenKind::Tok_PlusPlus:
+  case TokenKind::Tok_MinusMinus:
+  case TokenKind::Tok_Plus:
+  case TokenKind::Tok_Minus:
+  case TokenKind::Tok_BitNot:
+  case TokenKind::Tok_Not:
+  case TokenKind::Tok_Delete:
+  case TokenKind::Tok_Void:
+  case TokenKind::Tok_Typeof:
+  case TokenKind::Tok_Await:
   {
+    TokenKind op = Cur.kind;
     advance();
-    return parseSingleExpression();
+    if (!parseUnaryExpression())
+      return false;
+    LastExprParsed = Ast.make<UnaryExpr>(op, takeParsedExpr(), true);
+    return true;
   }
-  if (Cur.kind == TokenKind::Tok_Delete || Cur.kind == TokenKind::Tok_Void || Cur.kind == TokenKind::Tok_Typeof || Cur.kind == TokenKind::Tok_Await)
-  {
-    advance();
-    return parseSingleExpression();
+  default:
+    return parsePostfixExpression();
   }
+}
 
-  // New-expression forms
+bool Parser::parsePostfixExpression()
+{
+  // New-expression forms, primary expressions, and the postfix chain: call,
+  // index, member access, optional chaining, postfix ++/--.
+  size_t start = Cur.pos;
   if (Cur.kind == TokenKind::Tok_New)
   {
     advance();
     // New identifier arguments | New singleExpression arguments | New singleExpression
-    if (parseIdentifierName())
-    {
-      // optional arguments
-      if (Cur.kind == TokenKind::Tok_LParen)
-      {
-        if (!parseArguments())
-          return false;
-      }
-      return true;
-    }
-    if (!parseSingleExpression())
+    if (!parseIdentifierName() && !parsePostfixExpression())
       return false;
     if (Cur.kind == TokenKind::Tok_LParen)
     {
       if (!parseArguments())
         return false;
     }
-    return true;
+    LastExprParsed = Ast.make<RawExpr>(start);
   }
-
-  // Parse primary expression
-  if (!parsePrimary())
+  else if (!parsePrimaryExpression())
     return false;
 
-  // Handle postfix and member operations conservatively: call, index, member access, optional chaining, postfix ++/--
   while (true)
   {
     if (Cur.kind == TokenKind::Tok_Dot || Cur.kind == TokenKind::Tok_QuestionDot)
     {
+      bool optional = Cur.kind == TokenKind::Tok_QuestionDot;
       // consume '.' or '?.'
       advance();
+      // `?.(` and `?.[` continue with a call or index on the same object
+      if (optional && (Cur.kind == TokenKind::Tok_LParen || Cur.kind == TokenKind::Tok_LBracket))
+      {
+        LastExprParsed = Ast.make<RawExpr>(start);
+        continue;
+      }
       // optional private/mangled forms: '#' handled elsewhere, accept identifierName
+      std::string_view property = Cur.text;
       if (!parseIdentifierName())
         return false;
+      LastExprParsed = Ast.make<MemberExpr>(takeParsedExpr(), Ast.intern(property), optional);
       continue;
     }
     if (Cur.kind == TokenKind::Tok_LBracket)
     {
       // index expression
+      auto object = takeParsedExpr();
       advance();
       if (!parseExpressionSequence())
         return false;
       if (Cur.kind != TokenKind::Tok_RBracket)
         return false;
       advance();
+      LastExprParsed = Ast.make<IndexExpr>(object, takeParsedExpr(), start);
       continue;
     }
     if (Cur.kind == TokenKind::Tok_LParen)
     {
       // call arguments
-      if (!parseArguments())
+      auto callee = takeParsedExpr();
+      std::vector<Expr *> args;
+      if (!parseArguments(&args))
         return false;
+      LastExprParsed = Ast.make<CallExpr>(callee, Ast.list(args));
       continue;
     }
-    if (Cur.kind == TokenKind::Tok_PlusPlus || Cur.kind == TokenKind::Tok_MinusMinus)
+    if ((Cur.kind == TokenKind::Tok_PlusPlus || Cur.kind == TokenKind::Tok_MinusMinus) &&
+        !L.ContainsLineTerminatorBetween(PrevTokenEnd, Cur.pos))
     {
-      // postfix inc/dec (grammar checks line terminator; we are conservative)
+      // postfix inc/dec; after a line terminator the operator starts the next statement
+      TokenKind op = Cur.kind;
       advance();
-      continue;
+      LastExprParsed = Ast.make<UnaryExpr>(op, takeParsedExpr(), false);
+      break;
     }
     // template string continuation or other postfix tokens can be conservatively skipped
     break;
@@ -3040,7 +3148,110 @@ bool Parser::parseSingleExpression()
   return true;
 }
 
-bool Parser::parseArguments()
+bool Parser::parsePrimaryExpression()
+{
+  size_t start = Cur.pos;
+  switch (Cur.kind)
+  {
+  case TokenKind::Tok_Integer:
+  case TokenKind::Tok_DecimalLiteral:
+  case TokenKind::Tok_HexIntegerLiteral:
+  case TokenKind::Tok_OctalIntegerLiteral:
+  case TokenKind::Tok_OctalIntegerLiteral2:
+  case TokenKind::Tok_BinaryIntegerLiteral:
+    LastExprParsed = Ast.make<LiteralExpr>(Cur.text, LiteralExpr::NUMBER);
+    advance();
+    return true;
+  case TokenKind::Tok_StringLiteral:
+  {
+    std::string_view lit = Cur.text;
+    if (lit.size() >= 2 && ((lit.front() == '"' && lit.back() == '"') || (lit.front() == '\'' && lit.back() == '\''))) {
+      lit = lit.substr(1, lit.size() - 2);
+    }
+    LastExprParsed = Ast.make<LiteralExpr>(lit, LiteralExpr::STRING);
+    advance();
+    return true;
+  }
+  case TokenKind::Tok_BooleanLiteral:
+    LastExprParsed = Ast.make<LiteralExpr>(Cur.text, LiteralExpr::BOOL);
+    advance();
+    return true;
+  case TokenKind::Tok_NullLiteral:
+    LastExprParsed = Ast.make<LiteralExpr>(Cur.text, LiteralExpr::NUL);
+    advance();
+    return true;
+  case TokenKind::Tok_Undefined:
+    LastExprParsed = Ast.make<LiteralExpr>(Cur.text, LiteralExpr::UNDEFINED);
+    advance();
+    return true;
+  case TokenKind::Tok_This:
+  case TokenKind::Tok_Super:
+  case TokenKind::Tok_BigDecimalIntegerLiteral:
+  case TokenKind::Tok_BigHexIntegerLiteral:
+  case TokenKind::Tok_BigOctalIntegerLiteral:
+  case TokenKind::Tok_BigBinaryIntegerLiteral:
+  case TokenKind::Tok_RegularExpressionLiteral:
+    advance();
+    LastExprParsed = Ast.make<RawExpr>(start);
+    return true;
+  case TokenKind::Tok_BackTick:
+    if (!parseTemplateStringLiteral())
+      return false;
+    LastExprParsed = Ast.make<RawExpr>(start);
+    return true;
+  case TokenKind::Tok_LBracket:
+    if (!parseArrayLiteral())
+      return false;
+    LastExprParsed = Ast.make<RawExpr>(start);
+    return true;
+  case TokenKind::Tok_LBrace:
+    return parseObjectLiteral();
+  case TokenKind::Tok_LParen:
+  {
+    // parenthesized expressionSequence
+    advance();
+    if (Cur.kind == TokenKind::Tok_RParen)
+    {
+      advance();
+      LastExprParsed = Ast.make<RawExpr>(start);
+      return true;
+    }
+    if (!parseExpressionSequence())
+      return false;
+    if (Cur.kind != TokenKind::Tok_RParen)
+      return false;
+    advance();
+    return true;
+  }
+  case TokenKind::Tok_Class:
+    // accept token conservatively
+    advance();
+    LastExprParsed = Ast.make<RawExpr>(start);
+    return true;
+  case TokenKind::Tok_Any:
+  case TokenKind::Tok_Number:
+  case TokenKind::Tok_Never:
+  case TokenKind::Tok_Boolean:
+  case TokenKind::Tok_String:
+  case TokenKind::Tok_Unique:
+  case TokenKind::Tok_Symbol:
+  case TokenKind::Tok_Object:
+    // type names are ordinary identifiers in expression position
+    LastExprParsed = Ast.make<IdentifierExpr>(Ast.intern(Cur.text));
+    advance();
+    return true;
+  default:
+  {
+    std::string_view name = Cur.text;
+    if (!parseIdentifier())
+      return false;
+    LastExprParsed = Ast.make<IdentifierExpr>(Ast.intern(name));
+    return true;
+  }
+  }
+}
+
+bool Parser::parseArguments(std::vector<Expr *> *args)
 {
   // arguments : '(' (argument (',' argument)* ','?)? ')'
   if (Cur.kind != TokenKind::Tok_LParen)
@@ -3052,6 +3263,8 @@ bool Parser::parseArguments()
     // at least one argument
     if (!parseArgument())
       return false;
+    if (args)
+      args->push_back(takeParsedExpr());
     // zero or more ',' argument
     while (Cur.kind == TokenKind::Tok_Comma)
     {
@@ -3061,6 +3274,8 @@ bool Parser::parseArguments()
         break;
       if (!parseArgument())
         return false;
+      if (args)
+        args->push_back(takeParsedExpr());
     }
   }
   if (Cur.kind != TokenKind::Tok_RParen)
@@ -3074,9 +3289,11 @@ bool Parser::parseArgument()
   // argument : Ellipsis? (singleExpression | identifier)
   if (Cur.kind == TokenKind::Tok_Ellipsis)
   {
+    size_t start = Cur.pos;
     advance();
     if (!parseSingleExpression())
       return false;
+    LastExprParsed = Ast.make<RawExpr>(start);
     return true;
   }
   // either a singleExpression or an identifier-like token
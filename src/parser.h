@@ -1,9 +1,12 @@
 
 #pragma once
 #include "lexer.h"
+#include <algorithm>
 #include <memory>
 #include <optional>
 #include <string>
+#include <unordered_map>
+#include <vector>
 #include <iostream>
 #include "ast.h"
 
@@ -11,18 +14,37 @@
 struct ParseResult {
   bool ok;
   std::string error;
-  std::unique_ptr<Stmt> stmt;
+  Stmt *stmt; // owned by the Parser's AstContext
 };
 
 class Parser {
 public:
-  explicit Parser(const std::string &src) : L(src) { Cur = L.nextToken(); }
+  // `src` must outlive the parser; tokens and AST text point into it.
+  explicit Parser(std::string_view src);
   ParseResult parse();
+  // Arena holding every node built by this parser; the tree stays valid for
+  // the lifetime of the Parser.
+  AstContext &context() { return Ast; }
+
+  // Packrat memoization for the rules that sibling alternatives retry from the
+  // same position. When enabled, each rule's outcome (success, end position
+  // and built node) is cached per (rule, token index) and replayed on the next
+  // attempt instead of being re-parsed. Off by default.
+  enum class MemoRule { SingleExpression, AnonymousFunction, Type, ArrowAhead, Count };
+  static const char *memoRuleName(MemoRule rule);
+  struct MemoStats {
+    size_t Hits[size_t(MemoRule::Count)] = {};
+    size_t Misses[size_t(MemoRule::Count)] = {};
+  };
+  void setMemoize(bool on) { Memoize = on; }
+  const MemoStats &memoStats() const { return Stats; }
 
 private:
   // Handle optional leading HashBangLine per grammar: consume a leading Tok_Hashtag
   // and return an optional ParseResult when the file contains only a hash-bang line.
   std::optional<ParseResult> handleOptionalHashBang();
+  // parse() minus the instrumentation.
+  ParseResult parseProgram();
   // Try to parse a top-level print statement: 'print' '(' INTEGER ')' EOF
   // Returns an optional ParseResult: present if this rule matched (success or error),
   // or std::nullopt to indicate the rule does not apply.
@@ -56,7 +78,8 @@ private:
   std::optional<ParseResult> parseDeclaration();
   std::optional<ParseResult> parseFunctionDeclaration();
   std::optional<ParseResult> parseClassDeclaration();
-  bool parseClassTail();
+  // When `superClass` is non-null it receives the `extends` expression, if any.
+  bool parseClassTail(Expr **superClass = nullptr);
   bool parseClassElement();
   bool parseMethodDefinition();
   bool parseFieldDefinition();
@@ -65,9 +88,12 @@ private:
   bool parseObjectLiteral();
   bool parsePrivateIdentifier();
   bool parseAnonymousFunction();
-  bool parseArrowFunctionParameters();
-  bool parseArrowFunctionBody();
-  bool parseAssignmentOperator();
+  // Parse the parameters after '(' up to and including the closing ')'. Plain
+  // `name` / `name: type` parameters are appended to `params`, and their
+  // annotations (empty if none) to `types` when it is non-null; `simple` is
+  // cleared (and the rest of the list skipped) on defaults, patterns or rest.
+  bool parseParameterList(std::vector<std::string_view> &params, bool &simple,
+                          std::vector<std::string_view> *types = nullptr);
   bool parseLiteral();
   bool parseTemplateStringLiteral();
   bool parseTemplateStringAtom();
@@ -83,18 +109,33 @@ private:
   bool parsePropertyName();
   bool parseGetter();
   bool parseSetter();
-  bool parseArguments();
+  // When `args` is non-null the parsed argument expressions are appended to it.
+  bool parseArguments(std::vector<Expr *> *args = nullptr);
   bool parseArgument();
   // Variable statement parsing: variableStatement, variableDeclarationList, variableDeclaration
   std::optional<ParseResult> parseVariableStatement();
-  bool parseVariableDeclarationList();
-  bool parseVariableDeclaration();
+  // When `decls` is non-null one VarDeclStmt (or RawStmt for destructuring
+  // patterns) is appended per declarator.
+  bool parseVariableDeclarationList(std::vector<Stmt *> *decls = nullptr);
+  bool parseVariableDeclaration(std::vector<Stmt *> *decls = nullptr);
   bool parseType();
   // Ownership: parser will build a Type and store it in LastTypeParsed; call
   // takeParsedType() to retrieve ownership.
   std::unique_ptr<Type> takeParsedType();
   bool parseAssignable();
+  // Expression recognizers build an Expr and store it in LastExprParsed; call
+  // takeParsedExpr() to retrieve it.
+  Expr *takeParsedExpr();
   bool parseSingleExpression();
+  // Table-driven precedence climbing over the assignment, conditional and
+  // binary operators; parses operators that bind at least as tightly as minBp.
+  bool parseExpression(int minBp);
+  bool parseUnaryExpression();
+  bool parsePostfixExpression();
+  bool parsePrimaryExpression();
+  // True when the upcoming tokens start an arrow function (`x =>`, `(...) =>`,
+  // `async x =>`). Scans the token buffer, so nothing is consumed.
+  bool arrowFunctionAhead();
   bool parseVarModifier();
   bool parseLet_();
   bool parseEos();
@@ -126,32 +167,84 @@ private:
   // Parse one-or-more statements
   std::optional<ParseResult> parseStatementList();
   Lexer L;
+  // The whole source, lexed once up front; always ends with Tok_EOF. Cur is a
+  // copy of Tokens[TokIdx].
+  std::vector<Token> Tokens;
+  size_t TokIdx{0};
   Token Cur;
   // position (byte index) immediately after the previous token in the source.
   // Used to implement grammar predicates that need to check for line terminators
   // between tokens (e.g. this.n("get"), lineTerminatorAhead, etc.).
   size_t PrevTokenEnd{0};
+  size_t Rewinds{0}; // backtracks, for --stats
   // Grammar predicate helper: return true when the current token's text equals
   // `s` and there is no line terminator between the previous token and the
   // current token (approximates ANTLR's this.n("...") predicate).
   bool n(const std::string &s);
-  void advance() { PrevTokenEnd = Cur.pos + Cur.text.size(); Cur = L.nextToken(); }
+  void advance()
+  {
+    PrevTokenEnd = Cur.pos + Cur.text.size();
+    if (TokIdx + 1 < Tokens.size())
+      ++TokIdx;
+    Cur = Tokens[TokIdx];
+  }
+  // Return the token `n` positions after Cur without consuming anything
+  // (Tok_EOF past the end).
+  const Token &peekToken(size_t n = 1) const
+  {
+    return Tokens[std::min(TokIdx + n, Tokens.size() - 1)];
+  }
+  // Parser position for backtracking: take a checkpoint before trying an
+  // alternative and rewind() to it when the alternative fails. Both are O(1)
+  // and restore the exact token stream position. seek() moves the same way
+  // without counting a backtrack (a memo hit skipping ahead).
+  struct Checkpoint {
+    size_t TokIdx;
+    size_t PrevTokenEnd;
+  };
+  Checkpoint checkpoint() const { return {TokIdx, PrevTokenEnd}; }
+  void rewind(const Checkpoint &cp)
+  {
+    ++Rewinds;
+    seek(cp);
+  }
+  void seek(const Checkpoint &cp)
+  {
+    TokIdx = cp.TokIdx;
+    PrevTokenEnd = cp.PrevTokenEnd;
+    Cur = Tokens[TokIdx];
+  }
+  struct MemoEntry {
+    bool ok;
+    Checkpoint end;
+    Expr *expr;
+    std::unique_ptr<Type> type;
+  };
+  bool Memoize{false};
+  MemoStats Stats;
+  std::unordered_map<size_t, MemoEntry> Memo; // key: TokIdx * MemoRule::Count + rule
+  // Run `parse` for `rule` at the current position, or replay its cached result.
+  template <typename F>
+  bool memoized(MemoRule rule, F &&parse);
+  bool parseSingleExpressionImpl();
+  bool parseAnonymousFunctionImpl();
+  bool parseTypeImpl();
+  bool arrowFunctionAheadImpl();
   // Last parsed type (populated by parseType when it succeeds)
   std::unique_ptr<Type> LastTypeParsed;
+  // Last parsed expression (populated by the expression recognizers)
+  Expr *LastExprParsed = nullptr;
+  AstContext Ast;
+  // First definite syntax error met inside a bool recognizer; error() reports
+  // it instead of the caller's generic message.
+  std::string SyntaxError;
   ParseResult error(const std::string &msg) {
     // std::cerr << "Parse error: " << msg << std::endl;
     // std::cerr << "Remaining tokens:" << std::endl;
-    int count = 0;
-    Token t = Cur;
-    Lexer lex = L;
-    while (t.kind != TokenKind::Tok_EOF && count < 20) {
-      // std::cerr << "  kind=" << (int)t.kind << " text='" << t.text << "' pos=" << t.pos << std::endl;
-      t = lex.nextToken();
-      ++count;
-    }
-    // if (t.kind == TokenKind::Tok_EOF) {
-    //   std::cerr << "  kind=EOF" << std::endl;
+    // for (size_t i = TokIdx; i < Tokens.size() && i < TokIdx + 20; ++i) {
+    //   const Token &t = Tokens[i];
+    //   std::cerr << "  kind=" << (int)t.kind << " text='" << t.text << "' pos=" << t.pos << std::endl;
     // }
-    return {false, msg, nullptr};
+    return {false, SyntaxError.empty() ? msg : SyntaxError, nullptr};
   }
 };
@@ -0,0 +1,207 @@
+#include "repl.h"
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <string>
+#include "engine.h"
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+namespace
+{
+
+bool stdin_is_terminal()
+{
+#ifdef _WIN32
+    return _isatty(0) != 0;
+#else
+    return isatty(0) != 0;
+#endif
+}
+
+// Read one entry: a line, and more lines while brackets (or a template
+// literal) are open. False at the end of input with nothing read.
+bool read_entry(std::string &entry, bool interactive)
+{
+    entry.clear();
+    int depth = 0;
+    char quote = 0;
+    for (std::string line;;)
+    {
+        if (interactive)
+            std::cout << (entry.empty() ? "> " : "... ") << std::flush;
+        if (!std::getline(std::cin, line))
+        {
+            if (interactive)
+                std::cout << "\n";
+            return !entry.empty();
+        }
+        entry += line;
+        entry += '\n';
+        for (size_t i = 0; i < line.size(); ++i)
+        {
+            char c = line[i];
+            if (quote)
+            {
+                if (c == '\\')
+                    ++i;
+                else if (c == quote)
+                    quote = 0;
+            }
+            else if (c == '"' || c == '\'' || c == '`')
+                quote = c;
+            else if (c == '/' && i + 1 < line.size() && line[i + 1] == '/')
+                break;
+            else if (c == '{' || c == '(' || c == '[')
+                ++depth;
+            else if (c == '}' || c == ')' || c == ']')
+                --depth;
+        }
+        if (quote != '`')
+            quote = 0;
+        if (depth <= 0 && !quote)
+            return true;
+    }
+}
+
+// Point file descriptor `fd` at `file`; returns a duplicate of what it was.
+int redirect(int fd, std::FILE *file)
+{
+#ifdef _WIN32
+    int saved = _dup(fd);
+    _dup2(_fileno(file), fd);
+#else
+    int saved = dup(fd);
+    dup2(fileno(file), fd);
+#endif
+    return saved;
+}
+
+void restore(int fd, int saved)
+{
+#ifdef _WIN32
+    _dup2(saved, fd);
+    _close(saved);
+#else
+    dup2(saved, fd);
+    close(saved);
+#endif
+}
+
+// Read all of `file` into `text` and close it.
+void drain(std::FILE *file, std::string &text)
+{
+    std::rewind(file);
+    text.clear();
+    char buf[4096];
+    for (size_t n; (n = std::fread(buf, 1, sizeof buf, file)) > 0;)
+        text.append(buf, n);
+    std::fclose(file);
+}
+
+// Run `script` with what it writes to stdout and stderr going to `output`
+// and `errors` instead. False if they could not be redirected.
+bool run_captured(Script &script, int &rc, std::string &output, std::string &errors)
+{
+    std::FILE *out = std::tmpfile();
+    std::FILE *err = out ? std::tmpfile() : nullptr;
+    if (!err)
+    {
+        if (out)
+            std::fclose(out);
+        return false;
+    }
+    std::cout.flush();
+    std::cerr.flush();
+    int savedOut = redirect(1, out);
+    int savedErr = redirect(2, err);
+    rc = script.run(); // flushes the runtime's buffer
+    std::cerr.flush();
+    std::fflush(stderr);
+    restore(2, savedErr);
+    restore(1, savedOut);
+    drain(out, output);
+    drain(err, errors);
+    return true;
+}
+
+void respond_error(const std::string &message)
+{
+    std::cout << "error " << message.size() << "\n" << message << std::flush;
+}
+
+} // namespace
+
+int run_repl(unsigned optLevel)
+{
+    std::string error;
+    std::unique_ptr<Engine> engine = Engine::create(EngineOptions{optLevel}, error);
+    if (!engine)
+    {
+        std::cerr << error << "\n";
+        return 2;
+    }
+    bool interactive = stdin_is_terminal();
+    Session session;
+    for (std::string entry; read_entry(entry, interactive);)
+    {
+        if (entry.find_first_not_of(" \t\r\n") == std::string::npos)
+            continue;
+        Script *script = engine->compile(entry, error, session);
+        if (!script)
+        {
+            std::cerr << error << "\n";
+            continue;
+        }
+        std::cout.flush();
+        script->run(); // flushes the runtime's buffer
+    }
+    return 0;
+}
+
+int run_server(unsigned optLevel)
+{
+    std::string error;
+    std::unique_ptr<Engine> engine = Engine::create(EngineOptions{optLevel}, error);
+    if (!engine)
+    {
+        std::cerr << error << "\n";
+        return 2;
+    }
+    for (std::string header; std::getline(std::cin, header);)
+    {
+        char *end;
+        unsigned long long size = std::strtoull(header.c_str(), &end, 10);
+        if (header.empty() || *end)
+        {
+            respond_error("malformed request: expected the script's size in bytes");
+            return 2;
+        }
+        std::string source(size, '\0');
+        if (!std::cin.read(source.data(), std::streamsize(size)))
+        {
+            respond_error("truncated request: expected " + header + " bytes");
+            return 2;
+        }
+        std::unique_ptr<Script> script = engine->compile(source, error);
+        if (!script)
+        {
+            respond_error(error);
+            continue;
+        }
+        int rc;
+        std::string output, errors;
+        if (!run_captured(*script, rc, output, errors))
+        {
+            respond_error("could not capture the script's output");
+            continue;
+        }
+        std::cout << "ok " << rc << " " << output.size() << " " << errors.size() << "\n"
+                  << output << errors << std::flush;
+    }
+    return 0;
+}
@@ -0,0 +1,19 @@
+#pragma once
+
+// Long-lived front ends on top of Engine (see engine.h): LLVM and the JIT are
+// set up once, and every entry or request is compiled into a JITDylib of its
+// own. Both return the process exit code.
+
+// Interactive loop on stdin (oong --repl). An entry is a line, or several
+// while brackets are open. Entries are the entries of one Session: only the
+// new one is compiled and run, against the functions, variables and
+// constants the earlier ones declared, whose code stays loaded.
+int run_repl(unsigned optLevel);
+
+// Request loop on stdin for job runners (oong --serve). A request is a line
+// with the size of a script in bytes, followed by the script. Each gets one
+// response on stdout, a line and then that many bytes:
+//   ok <exit code> <stdout size> <stderr size>\n<the script's stdout><its stderr>
+//   error <size>\n<parse or codegen error>
+// Returns at the end of stdin, or on a malformed request.
+int run_server(unsigned optLevel);
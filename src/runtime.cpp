@@ -0,0 +1,376 @@
+#include "runtime.h"
+#include "value.h"
+#include <cerrno>
+#include <charconv>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <sys/uio.h>
+#include <unistd.h>
+#endif
+
+// Replay state (see oong_rt_replay): calls are counted, and replayed calls
+// are not counted again. Date.now() results are kept for replays until there
+// are too many of them. Each thread that runs code has its own.
+static thread_local uint64_t Writes = 0;
+static thread_local uint64_t SkipWrites = 0;
+static thread_local uint64_t ClockReads = 0;
+static thread_local bool Keeping = false;
+static thread_local std::vector<double> ClockLog; // every result while Keeping
+static thread_local uint64_t ClockReplay = 0, ClockReplayEnd = 0;
+constexpr size_t ClockLogLimit = size_t(1) << 20;
+
+// Counts a write; false when it is being replayed.
+static bool count_write()
+{
+    if (SkipWrites)
+    {
+        --SkipWrites;
+        return false;
+    }
+    ++Writes;
+    return true;
+}
+
+static void write_fd(int fd, const char *data, size_t size)
+{
+    while (size)
+    {
+#ifdef _WIN32
+        int n = _write(fd, data, static_cast<unsigned>(size < 0x40000000 ? size : 0x40000000));
+#else
+        ssize_t n = ::write(fd, data, size);
+        if (n < 0 && errno == EINTR)
+            continue;
+#endif
+        if (n <= 0)
+            return; // nowhere to report it; the output is lost either way
+        data += n;
+        size -= static_cast<size_t>(n);
+    }
+}
+
+// Output buffer (see oong_rt_flush), one per thread that prints, so an
+// embedder's threads or a compile thread never share one. A thread's buffer
+// is written out when the thread ends, or at exit for the main thread.
+constexpr size_t OutCapacity = 64 * 1024;
+struct OutBuffer
+{
+    std::unique_ptr<char[]> data{new char[OutCapacity]}; // not in every thread's TLS block
+    size_t len = 0;
+    bool terminal;
+
+    OutBuffer()
+    {
+#ifdef _WIN32
+        terminal = _isatty(1) != 0;
+#else
+        terminal = isatty(1) != 0;
+#endif
+        // whatever went through stdio first comes first
+        std::fflush(stdout);
+    }
+    ~OutBuffer() { write_fd(1, data.get(), len); }
+};
+static thread_local OutBuffer Out;
+
+// The buffer followed by `data`, in one system call where there is writev.
+static void write_out(const char *data, size_t size)
+{
+#ifdef _WIN32
+    write_fd(1, Out.data.get(), Out.len);
+    write_fd(1, data, size);
+#else
+    iovec parts[2] = {{Out.data.get(), Out.len}, {const_cast<char *>(data), size}};
+    ssize_t n;
+    do
+        n = ::writev(1, parts, 2);
+    while (n < 0 && errno == EINTR);
+    // finish whatever a short write left
+    size_t done = n < 0 ? 0 : static_cast<size_t>(n);
+    if (done < Out.len)
+    {
+        write_fd(1, Out.data.get() + done, Out.len - done);
+        done = Out.len;
+    }
+    write_fd(1, data + (done - Out.len), size - (done - Out.len));
+#endif
+    Out.len = 0;
+}
+
+static void append(const char *data, size_t size)
+{
+    if (Out.len + size <= OutCapacity)
+    {
+        std::memcpy(Out.data.get() + Out.len, data, size);
+        Out.len += size;
+    }
+    else
+        write_out(data, size);
+    if (Out.terminal && std::memchr(data, '\n', size))
+        oong_rt_flush();
+}
+
+extern "C" void oong_rt_write(const char *s)
+{
+    if (count_write())
+        append(s, std::strlen(s));
+}
+
+extern "C" void oong_rt_write_number(double v)
+{
+    if (!count_write())
+        return;
+    char buf[32];
+    append(buf, oong_rt_format_number(v, buf, sizeof(buf)));
+}
+
+extern "C" void oong_rt_write_line(const char *s)
+{
+    if (!count_write())
+        return;
+    size_t size = std::strlen(s);
+    if (Out.len + size + 1 <= OutCapacity && !Out.terminal)
+    {
+        std::memcpy(Out.data.get() + Out.len, s, size);
+        Out.data[Out.len + size] = '\n';
+        Out.len += size + 1;
+        return;
+    }
+    append(s, size);
+    append("\n", 1);
+}
+
+extern "C" void oong_rt_flush()
+{
+    write_fd(1, Out.data.get(), Out.len);
+    Out.len = 0;
+}
+
+// A console.error/warn line is collected until its newline, then written to
+// stderr in one piece, after the stdout output printed before it.
+static thread_local std::string ErrLine;
+
+static void append_err(const char *data, size_t size)
+{
+    ErrLine.append(data, size);
+    if (!std::memchr(data, '\n', size))
+        return;
+    oong_rt_flush();
+    write_fd(2, ErrLine.data(), ErrLine.size());
+    ErrLine.clear();
+}
+
+extern "C" void oong_rt_write_err(const char *s)
+{
+    if (count_write())
+        append_err(s, std::strlen(s));
+}
+
+extern "C" void oong_rt_write_number_err(double v)
+{
+    if (!count_write())
+        return;
+    char buf[32];
+    append_err(buf, oong_rt_format_number(v, buf, sizeof(buf)));
+}
+
+extern "C" void oong_rt_write_line_err(const char *s)
+{
+    if (!count_write())
+        return;
+    ErrLine += s;
+    append_err("\n", 1);
+}
+
+namespace
+{
+
+// snprintf-style output into a fixed buffer: what does not fit is dropped,
+// and finish() returns the full length.
+struct Text
+{
+    char *buf;
+    size_t size;
+    size_t len = 0;
+
+    void put(char c)
+    {
+        if (len + 1 < size)
+            buf[len] = c;
+        ++len;
+    }
+    void put(const char *s, size_t n)
+    {
+        for (size_t i = 0; i < n; ++i)
+            put(s[i]);
+    }
+    void zeros(int n)
+    {
+        for (int i = 0; i < n; ++i)
+            put('0');
+    }
+    size_t finish()
+    {
+        if (size)
+            buf[len < size ? len : size - 1] = '\0';
+        return len;
+    }
+};
+
+} // namespace
+
+extern "C" size_t oong_rt_format_number(double v, char *buf, size_t size)
+{
+    Text out{buf, size};
+    uint64_t bits;
+    std::memcpy(&bits, &v, sizeof bits);
+    if (bits == Value::UndefinedTag)
+    {
+        out.put("undefined", 9);
+        return out.finish();
+    }
+    if (bits == Value::NullTag)
+    {
+        out.put("null", 4);
+        return out.finish();
+    }
+    if (std::isnan(v))
+    {
+        out.put("NaN", 3);
+        return out.finish();
+    }
+    if (std::isinf(v))
+    {
+        if (v < 0)
+            out.put('-');
+        out.put("Infinity", 8);
+        return out.finish();
+    }
+    if (v < 0)
+    {
+        out.put('-');
+        v = -v;
+    }
+    // Fast path: integers that are exactly representable (0 also covers -0,
+    // which prints without a sign, as in JS)
+    if (v < 9007199254740992.0 && v == std::trunc(v))
+    {
+        char digits[20];
+        int k = 0;
+        for (uint64_t i = static_cast<uint64_t>(v); k == 0 || i; i /= 10)
+            digits[k++] = static_cast<char>('0' + i % 10);
+        while (k)
+            out.put(digits[--k]);
+        return out.finish();
+    }
+
+    // Shortest digit string that round-trips, as d.ddde[+-]x
+    char sci[32];
+    char *end = std::to_chars(sci, sci + sizeof(sci) - 1, v, std::chars_format::scientific).ptr;
+    *end = '\0';
+    char digits[20];
+    int k = 0;
+    const char *p = sci;
+    for (; *p && *p != 'e'; ++p)
+        if (*p != '.')
+            digits[k++] = *p;
+    int exp10 = std::atoi(p + 1);
+    while (k > 1 && digits[k - 1] == '0')
+        --k;
+
+    // Number#toString layout (ECMA-262 Number::toString): value = 0.digits * 10^n
+    int n = exp10 + 1;
+    if (k <= n && n <= 21)
+    {
+        out.put(digits, k);
+        out.zeros(n - k);
+    }
+    else if (0 < n && n <= 21)
+    {
+        out.put(digits, n);
+        out.put('.');
+        out.put(digits + n, k - n);
+    }
+    else if (-6 < n && n <= 0)
+    {
+        out.put("0.", 2);
+        out.zeros(-n);
+        out.put(digits, k);
+    }
+    else
+    {
+        out.put(digits[0]);
+        if (k > 1)
+        {
+            out.put('.');
+            out.put(digits + 1, k - 1);
+        }
+        char e[8];
+        int len = std::snprintf(e, sizeof(e), "e%c%d", n - 1 < 0 ? '-' : '+', std::abs(n - 1));
+        out.put(e, len);
+    }
+    return out.finish();
+}
+
+static void drop_clock_log()
+{
+    if (!Keeping && ClockReplay == ClockReplayEnd)
+        std::vector<double>().swap(ClockLog);
+}
+
+extern "C" double oong_rt_date_now()
+{
+    if (ClockReplay < ClockReplayEnd)
+    {
+        double then = ClockLog[ClockReplay++];
+        drop_clock_log();
+        return then;
+    }
+    using namespace std::chrono;
+    double now = static_cast<double>(duration_cast<milliseconds>(system_clock::now().time_since_epoch()).count());
+    ++ClockReads;
+    if (Keeping && ClockLog.size() < ClockLogLimit)
+        ClockLog.push_back(now);
+    else if (Keeping)
+    {
+        // replays from before this point can never succeed now
+        Keeping = false;
+        drop_clock_log();
+    }
+    return now;
+}
+
+extern "C" OongRtPosition oong_rt_position() { return {Writes, ClockReads}; }
+
+extern "C" bool oong_rt_replay(OongRtPosition from)
+{
+    if (!Keeping || ClockLog.size() != ClockReads)
+        return false;
+    SkipWrites = Writes - from.writes;
+    ClockReplay = from.clockReads;
+    ClockReplayEnd = ClockReads;
+    return true;
+}
+
+extern "C" void oong_rt_replay_enable(bool on)
+{
+    // times read while off were not kept, so replays cannot reach back past here
+    Keeping = on && ClockLog.size() == ClockReads;
+    drop_clock_log();
+}
+
+extern "C" void oong_rt_fatal(const char *msg)
+{
+    oong_rt_flush();
+    std::fprintf(stderr, "oong runtime error: %s\n", msg);
+    std::exit(70);
+}
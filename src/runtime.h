@@ -0,0 +1,52 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+// Native helpers called from JIT-compiled oong code. They use C linkage so the
+// generated IR can declare them by name; the interpreter registers their
+// addresses with the JIT before running a program.
+extern "C" {
+// Output goes through a buffer per thread: it is written out in 64 KiB
+// blocks, at each newline when stdout is a terminal, when the thread ends (at
+// exit for the main thread) and before runtime errors.
+// Write a NUL-terminated string to stdout (no trailing newline).
+void oong_rt_write(const char *s);
+// Write a number to stdout formatted like JavaScript's Number#toString; the
+// bits of undefined and null (see value.h) print as those words.
+void oong_rt_write_number(double v);
+// Write a NUL-terminated string and a newline to stdout.
+void oong_rt_write_line(const char *s);
+// Write out whatever output this thread has buffered.
+void oong_rt_flush();
+// The same three for console.error and console.warn, which go to stderr: a
+// line is written out once its newline arrives, after flushing stdout.
+void oong_rt_write_err(const char *s);
+void oong_rt_write_number_err(double v);
+void oong_rt_write_line_err(const char *s);
+// Format `v` like JavaScript's Number#toString into buf (NUL-terminated).
+// Returns the number of characters written; 32 bytes is always enough.
+size_t oong_rt_format_number(double v, char *buf, size_t size);
+// Milliseconds since the Unix epoch (Date.now()).
+double oong_rt_date_now();
+// Report an unrecoverable runtime error and exit.
+[[noreturn]] void oong_rt_fatal(const char *msg);
+
+// Replay support for the AST tier, which can rerun a function natively from
+// its start. A position counts the write and Date.now() calls the thread has
+// made so far; after oong_rt_replay(from), the calls made since `from` are
+// repeated without effect (writes are dropped, Date.now() returns the same
+// times).
+// Returns false, changing nothing, if those times were not all kept.
+struct OongRtPosition
+{
+    uint64_t writes;
+    uint64_t clockReads;
+};
+OongRtPosition oong_rt_position();
+bool oong_rt_replay(OongRtPosition from);
+// Times are only kept while replay is enabled (it is off by default, so
+// compiled programs keep none), and at most about a million of them;
+// disabling it, or running past the limit, frees them once a replay in
+// progress has used them.
+void oong_rt_replay_enable(bool on);
+}
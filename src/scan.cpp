@@ -0,0 +1,236 @@
+#include "scan.h"
+#include <cstdint>
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define OONG_SCAN_X86 1
+#include <immintrin.h>
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#define OONG_TARGET_AVX2
+#else
+#define OONG_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+#elif defined(__aarch64__) || defined(_M_ARM64)
+#define OONG_SCAN_NEON 1
+#include <arm_neon.h>
+#endif
+
+namespace
+{
+
+inline unsigned lowestBit(uint32_t m)
+{
+#if defined(_MSC_VER) && !defined(__clang__)
+  unsigned long i;
+  _BitScanForward(&i, m);
+  return static_cast<unsigned>(i);
+#else
+  return static_cast<unsigned>(__builtin_ctz(m));
+#endif
+}
+
+size_t toAnyScalar(const char *p, size_t n, const ScanSet &set)
+{
+  for (size_t i = 0; i < n; ++i)
+    if (set.contains(static_cast<unsigned char>(p[i])))
+      return i;
+  return n;
+}
+
+size_t blanksScalar(const char *p, size_t n)
+{
+  size_t i = 0;
+  while (i < n && (p[i] == ' ' || p[i] == '\t'))
+    ++i;
+  return i;
+}
+
+#if OONG_SCAN_X86
+size_t toAnySse2(const char *p, size_t n, const ScanSet &set)
+{
+  const __m128i b0 = _mm_set1_epi8(static_cast<char>(set.bytes[0]));
+  const __m128i b1 = _mm_set1_epi8(static_cast<char>(set.bytes[1]));
+  const __m128i b2 = _mm_set1_epi8(static_cast<char>(set.bytes[2]));
+  const __m128i b3 = _mm_set1_epi8(static_cast<char>(set.bytes[3]));
+  const uint32_t high = set.high ? 0xFFFFu : 0;
+  size_t i = 0;
+  for (; i + 16 <= n; i += 16)
+  {
+    __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p + i));
+    __m128i eq = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(v, b0), _mm_cmpeq_epi8(v, b1)),
+                              _mm_or_si128(_mm_cmpeq_epi8(v, b2), _mm_cmpeq_epi8(v, b3)));
+    // movemask of the raw bytes is their top bit, i.e. "byte >= 0x80"
+    uint32_t m = static_cast<uint32_t>(_mm_movemask_epi8(eq)) | (static_cast<uint32_t>(_mm_movemask_epi8(v)) & high);
+    if (m)
+      return i + lowestBit(m);
+  }
+  return i + toAnyScalar(p + i, n - i, set);
+}
+
+size_t blanksSse2(const char *p, size_t n)
+{
+  const __m128i sp = _mm_set1_epi8(' ');
+  const __m128i tab = _mm_set1_epi8('\t');
+  size_t i = 0;
+  for (; i + 16 <= n; i += 16)
+  {
+    __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p + i));
+    uint32_t blank = static_cast<uint32_t>(_mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi8(v, sp), _mm_cmpeq_epi8(v, tab))));
+    if (blank != 0xFFFFu)
+      return i + lowestBit(~blank);
+  }
+  return i + blanksScalar(p + i, n - i);
+}
+
+OONG_TARGET_AVX2 size_t toAnyAvx2(const char *p, size_t n, const ScanSet &set)
+{
+  const __m256i b0 = _mm256_set1_epi8(static_cast<char>(set.bytes[0]));
+  const __m256i b1 = _mm256_set1_epi8(static_cast<char>(set.bytes[1]));
+  const __m256i b2 = _mm256_set1_epi8(static_cast<char>(set.bytes[2]));
+  const __m256i b3 = _mm256_set1_epi8(static_cast<char>(set.bytes[3]));
+  const uint32_t high = set.high ? 0xFFFFFFFFu : 0;
+  size_t i = 0;
+  for (; i + 32 <= n; i += 32)
+  {
+    __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p + i));
+    __m256i eq = _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(v, b0), _mm256_cmpeq_epi8(v, b1)),
+                                 _mm256_or_si256(_mm256_cmpeq_epi8(v, b2), _mm256_cmpeq_epi8(v, b3)));
+    uint32_t m = static_cast<uint32_t>(_mm256_movemask_epi8(eq)) | (static_cast<uint32_t>(_mm256_movemask_epi8(v)) & high);
+    if (m)
+      return i + lowestBit(m);
+  }
+  return i + toAnySse2(p + i, n - i, set);
+}
+
+OONG_TARGET_AVX2 size_t blanksAvx2(const char *p, size_t n)
+{
+  const __m256i sp = _mm256_set1_epi8(' ');
+  const __m256i tab = _mm256_set1_epi8('\t');
+  size_t i = 0;
+  for (; i + 32 <= n; i += 32)
+  {
+    __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p + i));
+    uint32_t blank = static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_or_si256(_mm256_cmpeq_epi8(v, sp), _mm256_cmpeq_epi8(v, tab))));
+    if (blank != 0xFFFFFFFFu)
+      return i + lowestBit(~blank);
+  }
+  return i + blanksSse2(p + i, n - i);
+}
+
+bool cpuHasAvx2()
+{
+#if defined(_MSC_VER) && !defined(__clang__)
+  int info[4];
+  __cpuid(info, 0);
+  if (info[0] < 7)
+    return false;
+  __cpuid(info, 1);
+  bool osxsave = (info[2] & (1 << 27)) != 0;
+  bool avx = (info[2] & (1 << 28)) != 0;
+  // the OS must save the upper halves of the ymm registers
+  if (!osxsave || !avx || (_xgetbv(0) & 6) != 6)
+    return false;
+  __cpuidex(info, 7, 0);
+  return (info[1] & (1 << 5)) != 0;
+#else
+  return __builtin_cpu_supports("avx2");
+#endif
+}
+#endif
+
+#if OONG_SCAN_NEON
+// One bit per byte is enough to find the first match: narrow each 16-bit lane
+// by 4 so every byte of the comparison contributes a nibble.
+inline uint64_t neonMask(uint8x16_t eq)
+{
+  uint8x8_t nibbles = vshrn_n_u16(vreinterpretq_u16_u8(eq), 4);
+  return vget_lane_u64(vreinterpret_u64_u8(nibbles), 0);
+}
+
+inline unsigned lowestNibble(uint64_t m)
+{
+  return static_cast<unsigned>(__builtin_ctzll(m)) / 4;
+}
+
+size_t toAnyNeon(const char *p, size_t n, const ScanSet &set)
+{
+  const uint8x16_t b0 = vdupq_n_u8(set.bytes[0]);
+  const uint8x16_t b1 = vdupq_n_u8(set.bytes[1]);
+  const uint8x16_t b2 = vdupq_n_u8(set.bytes[2]);
+  const uint8x16_t b3 = vdupq_n_u8(set.bytes[3]);
+  const uint8x16_t high = vdupq_n_u8(0x80);
+  size_t i = 0;
+  for (; i + 16 <= n; i += 16)
+  {
+    uint8x16_t v = vld1q_u8(reinterpret_cast<const uint8_t *>(p + i));
+    uint8x16_t eq = vorrq_u8(vorrq_u8(vceqq_u8(v, b0), vceqq_u8(v, b1)), vorrq_u8(vceqq_u8(v, b2), vceqq_u8(v, b3)));
+    if (set.high)
+      eq = vorrq_u8(eq, vcgeq_u8(v, high));
+    if (uint64_t m = neonMask(eq))
+      return i + lowestNibble(m);
+  }
+  return i + toAnyScalar(p + i, n - i, set);
+}
+
+size_t blanksNeon(const char *p, size_t n)
+{
+  const uint8x16_t sp = vdupq_n_u8(' ');
+  const uint8x16_t tab = vdupq_n_u8('\t');
+  size_t i = 0;
+  for (; i + 16 <= n; i += 16)
+  {
+    uint8x16_t v = vld1q_u8(reinterpret_cast<const uint8_t *>(p + i));
+    uint8x16_t other = vmvnq_u8(vorrq_u8(vceqq_u8(v, sp), vceqq_u8(v, tab)));
+    if (uint64_t m = neonMask(other))
+      return i + lowestNibble(m);
+  }
+  return i + blanksScalar(p + i, n - i);
+}
+#endif
+
+struct Kernel
+{
+  const char *name;
+  size_t (*toAny)(const char *, size_t, const ScanSet &);
+  size_t (*blanks)(const char *, size_t);
+};
+
+constexpr Kernel Scalar{"scalar", toAnyScalar, blanksScalar};
+
+Kernel detect()
+{
+#if OONG_SCAN_X86
+  if (cpuHasAvx2())
+    return {"avx2", toAnyAvx2, blanksAvx2};
+  return {"sse2", toAnySse2, blanksSse2};
+#elif OONG_SCAN_NEON
+  return {"neon", toAnyNeon, blanksNeon};
+#else
+  return Scalar;
+#endif
+}
+
+const Kernel Detected = detect();
+Kernel Active = Detected;
+
+} // namespace
+
+size_t scan_to_any_kernel(const char *p, size_t n, const ScanSet &set)
+{
+  return Active.toAny(p, n, set);
+}
+
+size_t scan_blanks_kernel(const char *p, size_t n)
+{
+  return Active.blanks(p, n);
+}
+
+const char *scan_kernel_name()
+{
+  return Active.name;
+}
+
+void scan_force_scalar(bool on)
+{
+  Active = on ? Scalar : Detected;
+}
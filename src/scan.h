@@ -0,0 +1,60 @@
+#pragma once
+#include <cstddef>
+
+// Byte-scanning kernels for the lexer's inner loops (comments, string and
+// template bodies, runs of blanks). Each call jumps over bytes the caller does
+// not care about 16 or 32 at a time and returns the offset of the first one it
+// does. The kernel (AVX2, SSE2, NEON or scalar) is picked once at startup from
+// what the CPU supports.
+
+// Up to four byte values to stop at, optionally also stopping at every byte
+// >= 0x80 (the lead byte of any non-ASCII UTF-8 sequence, e.g. the E2 that
+// starts U+2028/U+2029).
+struct ScanSet
+{
+  unsigned char bytes[4];
+  bool high;
+  constexpr ScanSet(char a, char b, char c, char d, bool h = false)
+      : bytes{(unsigned char)a, (unsigned char)b, (unsigned char)c, (unsigned char)d}, high(h) {}
+  constexpr ScanSet(char a, char b, char c, bool h = false) : ScanSet(a, b, c, c, h) {}
+  constexpr ScanSet(char a, char b, bool h = false) : ScanSet(a, b, b, b, h) {}
+
+  constexpr bool contains(unsigned char c) const
+  {
+    return c == bytes[0] || c == bytes[1] || c == bytes[2] || c == bytes[3] || (high && c >= 0x80);
+  }
+};
+
+// The vector kernels behind scan_to_any() / scan_blanks().
+size_t scan_to_any_kernel(const char *p, size_t n, const ScanSet &set);
+size_t scan_blanks_kernel(const char *p, size_t n);
+
+// Most runs are short (one space, a short string), so the first bytes are
+// checked inline and the kernel is only entered for longer runs.
+constexpr size_t ScanInlineBytes = 8;
+
+// Offset of the first byte in p[0, n) that is in `set`, or n.
+inline size_t scan_to_any(const char *p, size_t n, const ScanSet &set)
+{
+  size_t i = 0;
+  for (; i < n && i < ScanInlineBytes; ++i)
+    if (set.contains(static_cast<unsigned char>(p[i])))
+      return i;
+  return i == n ? n : i + scan_to_any_kernel(p + i, n - i, set);
+}
+
+// Offset of the first byte in p[0, n) that is neither ' ' nor '\t', or n.
+inline size_t scan_blanks(const char *p, size_t n)
+{
+  size_t i = 0;
+  for (; i < n && i < ScanInlineBytes; ++i)
+    if (p[i] != ' ' && p[i] != '\t')
+      return i;
+  return i == n ? n : i + scan_blanks_kernel(p + i, n - i);
+}
+
+// Name of the kernel in use: "avx2", "sse2", "neon" or "scalar".
+const char *scan_kernel_name();
+// Force the scalar kernel (true) or return to the detected one (false); used
+// by tools/bench_lexer to compare the two.
+void scan_force_scalar(bool on);
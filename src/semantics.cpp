@@ -0,0 +1,796 @@
+#include "semantics.h"
+#include "runtime.h"
+#include <algorithm>
+#include <cstdlib>
+#include <vector>
+
+std::string unescape_string(std::string_view s)
+{
+    std::string out;
+    for (size_t i = 0; i < s.size(); ++i)
+    {
+        if (s[i] == '\\' && i + 1 < s.size())
+            ++i;
+        out += s[i];
+    }
+    return out;
+}
+
+std::string format_number(double v)
+{
+    char buf[32];
+    oong_rt_format_number(v, buf, sizeof(buf));
+    return buf;
+}
+
+void serialize(const Value &v, const std::string &objColor, std::string &out)
+{
+    switch (v.type())
+    {
+    case Value::Type::Number:
+    {
+        char buf[32];
+        oong_rt_format_number(v.number(), buf, sizeof(buf));
+        out.append(yellow).append(buf).append(reset);
+        return;
+    }
+    case Value::Type::Bool:
+        out.append(yellow).append(v.boolean() ? "true" : "false").append(reset);
+        return;
+    case Value::Type::String:
+    case Value::Type::Undefined:
+    case Value::Type::Null:
+    {
+        std::string_view text = v.type() == Value::Type::String ? std::string_view(v.string())
+                                : v.type() == Value::Type::Null ? "null"
+                                                                : "undefined";
+        if (!objColor.empty())
+            out.append(objColor).append(text).append(reset);
+        else
+            out.append(text);
+        return;
+    }
+    case Value::Type::Object:
+        out.append(objColor).append("{ ");
+        for (size_t i = 0; i < v.slots().size(); ++i)
+        {
+            if (i > 0)
+                out.append(objColor).append(", ");
+            out.append(objColor).append(v.keys()[i]).append(reset).append(objColor).append(": ");
+            serialize(v.slots()[i], objColor, out);
+        }
+        out.append(objColor).append(" }").append(reset);
+        return;
+    }
+}
+
+std::string serialize(const Value &v, const std::string &objColor)
+{
+    std::string out;
+    serialize(v, objColor, out);
+    return out;
+}
+
+std::string print_constant(const Value &v, const std::string &color, bool isConsole)
+{
+    switch (v.type())
+    {
+    case Value::Type::Number:
+        return yellow + format_number(v.number()) + reset;
+    case Value::Type::Bool:
+        return yellow + (v.boolean() ? "true" : "false") + reset;
+    case Value::Type::Undefined:
+        return color + "undefined";
+    case Value::Type::Null:
+        return color + "null";
+    default:
+    {
+        std::string out = color;
+        serialize(v, isConsole ? color : "", out);
+        return out;
+    }
+    }
+}
+
+double parse_number_literal(std::string text)
+{
+    text.erase(std::remove(text.begin(), text.end(), '_'), text.end());
+    if (text.size() > 2 && text[0] == '0')
+    {
+        char p = static_cast<char>(tolower(text[1]));
+        if (p == 'x')
+            return static_cast<double>(std::strtoull(text.c_str() + 2, nullptr, 16));
+        if (p == 'o')
+            return static_cast<double>(std::strtoull(text.c_str() + 2, nullptr, 8));
+        if (p == 'b')
+            return static_cast<double>(std::strtoull(text.c_str() + 2, nullptr, 2));
+    }
+    if (text.size() > 1 && text[0] == '0' && std::all_of(text.begin(), text.end(), [](char c)
+                                                         { return c >= '0' && c <= '7'; }))
+        return static_cast<double>(std::strtoull(text.c_str(), nullptr, 8));
+    return std::strtod(text.c_str(), nullptr);
+}
+
+std::string print_color(TokenKind origin)
+{
+    switch (origin)
+    {
+    case TokenKind::Tok_ConsoleError:
+        return "\033[31m"; // red
+    case TokenKind::Tok_ConsoleWarn:
+        return "\033[38;2;255;165;0m"; // orange-yellow
+    case TokenKind::Tok_ConsoleInfo:
+        return "\033[34m"; // blue
+    case TokenKind::Tok_ConsoleSuccess:
+        return "\033[32m"; // green
+    default:
+        return "";
+    }
+}
+
+bool prints_to_stderr(TokenKind origin)
+{
+    return origin == TokenKind::Tok_ConsoleError || origin == TokenKind::Tok_ConsoleWarn;
+}
+
+void walk(const Expr *e, const std::function<void(const Stmt *)> &onStmt,
+          const std::function<void(const Expr *)> &onExpr)
+{
+    if (!e)
+        return;
+    onExpr(e);
+    if (auto m = ast_cast<MemberExpr>(e))
+        walk(m->object, onStmt, onExpr);
+    else if (auto ix = ast_cast<IndexExpr>(e))
+    {
+        walk(ix->object, onStmt, onExpr);
+        walk(ix->index, onStmt, onExpr);
+    }
+    else if (auto c = ast_cast<CallExpr>(e))
+    {
+        walk(c->callee, onStmt, onExpr);
+        for (const auto &a : c->args)
+            walk(a, onStmt, onExpr);
+    }
+    else if (auto u = ast_cast<UnaryExpr>(e))
+        walk(u->operand, onStmt, onExpr);
+    else if (auto b = ast_cast<BinaryExpr>(e))
+    {
+        walk(b->lhs, onStmt, onExpr);
+        walk(b->rhs, onStmt, onExpr);
+    }
+    else if (auto a = ast_cast<AssignExpr>(e))
+    {
+        walk(a->target, onStmt, onExpr);
+        walk(a->value, onStmt, onExpr);
+    }
+    else if (auto c = ast_cast<ConditionalExpr>(e))
+    {
+        walk(c->cond, onStmt, onExpr);
+        walk(c->consequent, onStmt, onExpr);
+        walk(c->alternate, onStmt, onExpr);
+    }
+    else if (auto q = ast_cast<SequenceExpr>(e))
+    {
+        for (const auto &x : q->exprs)
+            walk(x, onStmt, onExpr);
+    }
+    else if (auto o = ast_cast<ObjectExpr>(e))
+    {
+        for (const auto &p : o->properties)
+            walk(p.value, onStmt, onExpr);
+    }
+}
+
+void walk(const Stmt *s, const std::function<void(const Stmt *)> &onStmt,
+          const std::function<void(const Expr *)> &onExpr)
+{
+    if (!s)
+        return;
+    onStmt(s);
+    if (auto v = ast_cast<VarDeclStmt>(s))
+        walk(v->value, onStmt, onExpr);
+    else if (auto p = ast_cast<PrintStmt>(s))
+    {
+        for (const auto &a : p->args)
+            walk(a, onStmt, onExpr);
+    }
+    else if (auto x = ast_cast<ExprStmt>(s))
+        walk(x->expr, onStmt, onExpr);
+    else if (auto b = ast_cast<BlockStmt>(s))
+    {
+        for (const auto &c : b->statements)
+            walk(c, onStmt, onExpr);
+    }
+    else if (auto r = ast_cast<ReturnStmt>(s))
+        walk(r->value, onStmt, onExpr);
+    else if (auto i = ast_cast<IfStmt>(s))
+    {
+        walk(i->cond, onStmt, onExpr);
+        walk(i->then, onStmt, onExpr);
+        walk(i->otherwise, onStmt, onExpr);
+    }
+    else if (auto w = ast_cast<WhileStmt>(s))
+    {
+        walk(w->cond, onStmt, onExpr);
+        walk(w->body, onStmt, onExpr);
+    }
+    else if (auto d = ast_cast<DoWhileStmt>(s))
+    {
+        walk(d->body, onStmt, onExpr);
+        walk(d->cond, onStmt, onExpr);
+    }
+    else if (auto f = ast_cast<ForStmt>(s))
+    {
+        walk(f->init, onStmt, onExpr);
+        walk(f->cond, onStmt, onExpr);
+        walk(f->update, onStmt, onExpr);
+        walk(f->body, onStmt, onExpr);
+    }
+    else if (auto fn = ast_cast<FunctionDecl>(s))
+        walk(fn->body, onStmt, onExpr);
+    else if (auto cd = ast_cast<ClassDecl>(s))
+        walk(cd->superClass, onStmt, onExpr);
+}
+
+std::optional<ValueKind> annotated_kind(std::string_view type)
+{
+    if (type == "number")
+        return ValueKind::Number;
+    if (type == "boolean")
+        return ValueKind::Bool;
+    return std::nullopt;
+}
+
+std::optional<ValueKind> param_kind(const FunctionDecl *fd, size_t i)
+{
+    if (i >= fd->paramTypes.size())
+        return std::nullopt;
+    return annotated_kind(fd->paramTypes[i]);
+}
+
+bool is_comparison(TokenKind op)
+{
+    switch (op)
+    {
+    case TokenKind::Tok_Equals:
+    case TokenKind::Tok_NotEquals:
+    case TokenKind::Tok_IdentityEquals:
+    case TokenKind::Tok_IdentityNotEquals:
+    case TokenKind::Tok_LessThan:
+    case TokenKind::Tok_MoreThan:
+    case TokenKind::Tok_LessThanEquals:
+    case TokenKind::Tok_GreaterThanEquals:
+        return true;
+    default:
+        return false;
+    }
+}
+
+TokenKind compound_operator(TokenKind op)
+{
+    switch (op)
+    {
+    case TokenKind::Tok_PlusAssign:
+        return TokenKind::Tok_Plus;
+    case TokenKind::Tok_MinusAssign:
+        return TokenKind::Tok_Minus;
+    case TokenKind::Tok_MultiplyAssign:
+        return TokenKind::Tok_Multiply;
+    case TokenKind::Tok_DivideAssign:
+        return TokenKind::Tok_Divide;
+    case TokenKind::Tok_ModulusAssign:
+        return TokenKind::Tok_Modulus;
+    case TokenKind::Tok_PowerAssign:
+        return TokenKind::Tok_Power;
+    case TokenKind::Tok_LeftShiftArithmeticAssign:
+        return TokenKind::Tok_LeftShiftArithmetic;
+    case TokenKind::Tok_RightShiftArithmeticAssign:
+        return TokenKind::Tok_RightShiftArithmetic;
+    case TokenKind::Tok_RightShiftLogicalAssign:
+        return TokenKind::Tok_RightShiftLogical;
+    case TokenKind::Tok_BitAndAssign:
+        return TokenKind::Tok_BitAnd;
+    case TokenKind::Tok_BitOrAssign:
+        return TokenKind::Tok_BitOr;
+    case TokenKind::Tok_BitXorAssign:
+        return TokenKind::Tok_BitXor;
+    case TokenKind::Tok_NullishCoalescingAssign:
+        return TokenKind::Tok_NullCoalesce;
+    default:
+        return TokenKind::Tok_Invalid;
+    }
+}
+
+bool ProgramInfo::foldObject(const ObjectExpr *o, Value &out, std::string &error) const
+{
+    std::vector<Value::Member> members;
+    members.reserve(o->properties.size());
+    for (const ObjectProperty &p : o->properties)
+    {
+        Value slot;
+        const Expr *v = p.value;
+        double sign = 1;
+        if (auto u = ast_cast<UnaryExpr>(v); u && u->op == TokenKind::Tok_Minus)
+        {
+            sign = -1;
+            v = u->operand;
+        }
+        auto lit = ast_cast<LiteralExpr>(v);
+        if (lit && lit->kind == LiteralExpr::NUMBER)
+            slot = Value(sign * parse_number_literal(std::string(lit->value)));
+        else if (sign < 0)
+        {
+            error = "object literal values must be constants (" + where(o->pos) + ")";
+            return false;
+        }
+        else if (auto nested = ast_cast<ObjectExpr>(v))
+        {
+            if (!foldObject(nested, slot, error))
+                return false;
+        }
+        else if (lit && lit->kind == LiteralExpr::STRING)
+            slot = Value(unescape_string(lit->value));
+        else if (lit && lit->kind == LiteralExpr::BOOL)
+            slot = Value(lit->value == "true");
+        else if (lit)
+            slot = lit->kind == LiteralExpr::NUL ? Value::null() : Value();
+        else if (auto id = ast_cast<IdentifierExpr>(v))
+        {
+            // a top-level constant folds in (sharing its cells); other names
+            // print as written
+            auto it = consts.find(id->name);
+            slot = it != consts.end() ? it->second : Value(std::string(id->name));
+        }
+        else
+        {
+            error = "object literal values must be constants (" + where(o->pos) + ")";
+            return false;
+        }
+        members.emplace_back(unescape_string(p.key), std::move(slot));
+    }
+    out = Value::object(std::move(members));
+    return true;
+}
+
+const IdentifierExpr *member_root(const MemberExpr *m)
+{
+    const Expr *e = m->object;
+    while (auto inner = ast_cast<MemberExpr>(e))
+        e = inner->object;
+    return ast_cast<IdentifierExpr>(e);
+}
+
+bool ProgramInfo::constMember(const MemberExpr *m, Value &out, std::string &error) const
+{
+    std::vector<const MemberExpr *> chain{m};
+    while (auto inner = ast_cast<MemberExpr>(chain.back()->object))
+        chain.push_back(inner);
+    const IdentifierExpr *id = member_root(m);
+    auto root = id ? consts.find(id->name) : consts.end();
+    if (root == consts.end())
+    {
+        error = "unsupported property access '." + std::string(m->property) + "'";
+        return false;
+    }
+    const Value *v = &root->second;
+    bool missing = false;
+    for (auto it = chain.rbegin(); it != chain.rend(); ++it)
+    {
+        const MemberExpr *access = *it;
+        if (missing)
+        {
+            if (access->optional)
+                break;
+            error = "cannot read '." + std::string(access->property) + "' of undefined";
+            return false;
+        }
+        if (v->type() != Value::Type::Object)
+        {
+            error = "unsupported property access '." + std::string(access->property) + "'";
+            return false;
+        }
+        v = v->find(access->property);
+        missing = !v;
+    }
+    out = missing ? Value() : *v;
+    return true;
+}
+
+bool ProgramInfo::isBoolExpr(const Expr *e, const std::map<std::string_view, ValueKind> &locals) const
+{
+    if (auto lit = ast_cast<LiteralExpr>(e))
+        return lit->kind == LiteralExpr::BOOL;
+    if (auto u = ast_cast<UnaryExpr>(e))
+        return u->op == TokenKind::Tok_Not;
+    if (auto b = ast_cast<BinaryExpr>(e))
+    {
+        if (is_comparison(b->op))
+            return true;
+        if (b->op == TokenKind::Tok_LogicalAnd || b->op == TokenKind::Tok_LogicalOr)
+            return isBoolExpr(b->lhs, locals) && isBoolExpr(b->rhs, locals);
+        if (b->op == TokenKind::Tok_NullCoalesce)
+            return isBoolExpr(b->lhs, locals);
+        return false;
+    }
+    if (auto c = ast_cast<ConditionalExpr>(e))
+        return isBoolExpr(c->consequent, locals) && isBoolExpr(c->alternate, locals);
+    if (auto a = ast_cast<AssignExpr>(e))
+        return a->op == TokenKind::Tok_Assign && isBoolExpr(a->value, locals);
+    if (auto q = ast_cast<SequenceExpr>(e))
+        return !q->exprs.empty() && isBoolExpr(q->exprs.back(), locals);
+    if (auto id = ast_cast<IdentifierExpr>(e))
+    {
+        auto it = locals.find(id->name);
+        if (it != locals.end())
+            return it->second == ValueKind::Bool;
+        auto g = globals.find(id->name);
+        return g != globals.end() && g->second == ValueKind::Bool;
+    }
+    if (auto call = ast_cast<CallExpr>(e))
+    {
+        if (auto id = ast_cast<IdentifierExpr>(call->callee))
+        {
+            auto f = functions.find(id->name);
+            if (f != functions.end())
+                return f->second.ret == ValueKind::Bool;
+            auto i = imports.find(id->name);
+            return i != imports.end() && i->second.ret == ValueKind::Bool;
+        }
+    }
+    if (auto m = ast_cast<MemberExpr>(e))
+    {
+        const IdentifierExpr *root = member_root(m);
+        Value v;
+        std::string ignored;
+        return root && !locals.count(root->name) && consts.count(root->name) && constMember(m, v, ignored) &&
+               v.type() == Value::Type::Bool;
+    }
+    return false;
+}
+
+void ProgramInfo::forEachReturn(
+    const Function &fn,
+    const std::function<void(const ReturnStmt *, const std::map<std::string_view, ValueKind> &)> &onReturn) const
+{
+    std::map<std::string_view, ValueKind> locals;
+    for (size_t i = 0; i < fn.params.size(); ++i)
+        locals[fn.decl->params[i]] = fn.params[i];
+    walk(fn.decl->body, [&](const Stmt *s)
+         {
+             if (auto v = ast_cast<VarDeclStmt>(s))
+                 locals[v->name] = annotated_kind(v->type).value_or(
+                     v->value && isBoolExpr(v->value, locals) ? ValueKind::Bool : ValueKind::Number);
+             else if (auto r = ast_cast<ReturnStmt>(s))
+                 onReturn(r, locals); },
+         [](const Expr *) {});
+}
+
+void ProgramInfo::inferReturnKinds()
+{
+    // Optimistically assume every function that returns a value returns a
+    // boolean, then demote to Number until no function changes.
+    for (auto &kv : functions)
+    {
+        bool returnsValue = false;
+        walk(kv.second.decl->body, [&](const Stmt *s)
+             { if (auto r = ast_cast<ReturnStmt>(s)) returnsValue |= r->value != nullptr; },
+             [](const Expr *) {});
+        // a `number` return annotation settles it; a `boolean` one is
+        // checked once inference is done
+        kv.second.ret = returnsValue && annotated_kind(kv.second.decl->returnType) != ValueKind::Number
+                            ? ValueKind::Bool
+                            : ValueKind::Number;
+    }
+    bool changed = true;
+    while (changed)
+    {
+        changed = false;
+        for (auto &kv : functions)
+        {
+            if (kv.second.ret != ValueKind::Bool)
+                continue;
+            bool allBool = true;
+            forEachReturn(kv.second, [&](const ReturnStmt *r, const std::map<std::string_view, ValueKind> &locals)
+                          { allBool &= r->value && isBoolExpr(r->value, locals); });
+            if (!allBool)
+            {
+                kv.second.ret = ValueKind::Number;
+                changed = true;
+            }
+        }
+    }
+}
+
+// Whether running `s` to its end always executes a return statement.
+static bool ends_in_return(const Stmt *s)
+{
+    if (ast_cast<ReturnStmt>(s))
+        return true;
+    if (auto b = ast_cast<BlockStmt>(s))
+        return !b->statements.empty() && ends_in_return(b->statements.back());
+    if (auto i = ast_cast<IfStmt>(s))
+        return i->otherwise && ends_in_return(i->then) && ends_in_return(i->otherwise);
+    return false;
+}
+
+void ProgramInfo::walkProgram(const Program &prog,
+                              const std::function<void(const Stmt *, const FunctionDecl *)> &onStmt,
+                              const std::function<void(const Expr *, const FunctionDecl *)> &onExpr) const
+{
+    for (const auto &kv : functions)
+    {
+        const FunctionDecl *fd = kv.second.decl;
+        walk(fd->body, [&](const Stmt *s) { onStmt(s, fd); }, [&](const Expr *e) { onExpr(e, fd); });
+    }
+    for (const auto &s : prog.statements)
+    {
+        if (!ast_cast<FunctionDecl>(s))
+            walk(s, [&](const Stmt *c) { onStmt(c, nullptr); }, [&](const Expr *e) { onExpr(e, nullptr); });
+    }
+}
+
+bool ProgramInfo::varMayBeNullish(const FunctionDecl *fn, std::string_view name) const
+{
+    if (fn && Locals.at(fn).count(name))
+        return NullishVars.count({fn, name}) > 0;
+    // later REPL entries may store anything in a shared variable
+    return ShareTopLevel || NullishVars.count({nullptr, name}) > 0;
+}
+
+bool ProgramInfo::mayBeNullish(const Expr *e, const FunctionDecl *fn) const
+{
+    if (auto lit = ast_cast<LiteralExpr>(e))
+        return lit->kind == LiteralExpr::NUL || lit->kind == LiteralExpr::UNDEFINED;
+    if (auto id = ast_cast<IdentifierExpr>(e))
+        return id->name == "undefined" || varMayBeNullish(fn, id->name);
+    if (auto u = ast_cast<UnaryExpr>(e))
+        return u->op == TokenKind::Tok_Void;
+    if (auto b = ast_cast<BinaryExpr>(e))
+    {
+        // `a || b` and `a ?? b` only keep a when it is not nullish
+        if (b->op == TokenKind::Tok_LogicalAnd)
+            return mayBeNullish(b->lhs, fn) || mayBeNullish(b->rhs, fn);
+        if (b->op == TokenKind::Tok_LogicalOr || b->op == TokenKind::Tok_NullCoalesce)
+            return mayBeNullish(b->rhs, fn);
+        return false;
+    }
+    if (auto c = ast_cast<ConditionalExpr>(e))
+        return mayBeNullish(c->consequent, fn) || mayBeNullish(c->alternate, fn);
+    if (auto a = ast_cast<AssignExpr>(e))
+        return (a->op == TokenKind::Tok_Assign || a->op == TokenKind::Tok_NullishCoalescingAssign) &&
+               mayBeNullish(a->value, fn);
+    if (auto q = ast_cast<SequenceExpr>(e))
+        return !q->exprs.empty() && mayBeNullish(q->exprs.back(), fn);
+    if (auto call = ast_cast<CallExpr>(e))
+    {
+        auto id = ast_cast<IdentifierExpr>(call->callee);
+        if (!id)
+            return false;
+        if (functions.count(id->name))
+            return NullishReturns.count(id->name) > 0;
+        return imports.count(id->name) > 0; // nothing is known about their returns
+    }
+    if (auto m = ast_cast<MemberExpr>(e))
+    {
+        const IdentifierExpr *root = member_root(m);
+        Value v;
+        std::string ignored;
+        return root && !(fn && Locals.at(fn).count(root->name)) && consts.count(root->name) &&
+               constMember(m, v, ignored) && (v.type() == Value::Type::Undefined || v.type() == Value::Type::Null);
+    }
+    return false;
+}
+
+void ProgramInfo::inferNullish(const Program &prog)
+{
+    for (const auto &kv : functions)
+    {
+        const FunctionDecl *fd = kv.second.decl;
+        std::set<std::string_view> &names = Locals[fd];
+        names.insert(fd->params.begin(), fd->params.end());
+        walk(fd->body, [&](const Stmt *s)
+             { if (auto v = ast_cast<VarDeclStmt>(s)) names.insert(v->name); },
+             [](const Expr *) {});
+        // other modules and later REPL entries may pass anything, or nothing
+        if (fd->exported || ShareTopLevel)
+            for (std::string_view p : fd->params)
+                NullishVars.emplace(fd, p);
+        if (!ends_in_return(fd->body))
+            NullishReturns.insert(kv.first);
+    }
+    // Whatever may receive a nullish value may pass it on: repeat until no
+    // variable or function is added.
+    auto owner = [&](const FunctionDecl *fn, std::string_view name)
+    { return fn && Locals.at(fn).count(name) ? fn : nullptr; };
+    size_t known;
+    do
+    {
+        known = NullishVars.size() + NullishReturns.size();
+        walkProgram(
+            prog,
+            [&](const Stmt *s, const FunctionDecl *fn)
+            {
+                if (auto v = ast_cast<VarDeclStmt>(s))
+                {
+                    if (!v->value || mayBeNullish(v->value, fn))
+                        NullishVars.emplace(owner(fn, v->name), v->name);
+                }
+                else if (auto r = ast_cast<ReturnStmt>(s); r && fn && (!r->value || mayBeNullish(r->value, fn)))
+                    NullishReturns.insert(fn->name);
+            },
+            [&](const Expr *e, const FunctionDecl *fn)
+            {
+                if (auto a = ast_cast<AssignExpr>(e))
+                {
+                    auto id = ast_cast<IdentifierExpr>(a->target);
+                    if (id && mayBeNullish(a, fn))
+                        NullishVars.emplace(owner(fn, id->name), id->name);
+                }
+                else if (auto c = ast_cast<CallExpr>(e))
+                {
+                    auto id = ast_cast<IdentifierExpr>(c->callee);
+                    auto callee = id ? functions.find(id->name) : functions.end();
+                    if (callee == functions.end())
+                        return;
+                    const FunctionDecl *fd = callee->second.decl;
+                    for (size_t i = 0; i < fd->params.size(); ++i)
+                        if (i >= c->args.size() || mayBeNullish(c->args[i], fn))
+                            NullishVars.emplace(fd, fd->params[i]);
+                }
+            });
+    } while (NullishVars.size() + NullishReturns.size() != known);
+}
+
+std::string ProgramInfo::where(size_t pos) const
+{
+    size_t line = 1 + std::count(Src.begin(), Src.begin() + std::min(pos, Src.size()), '\n');
+    return "line " + std::to_string(line);
+}
+
+void ProgramInfo::link(const ModuleLinkage &linkage)
+{
+    imports = linkage.imports;
+    for (const auto &kv : linkage.variables)
+        globals[kv.first] = kv.second.kind;
+    consts.insert(linkage.consts.begin(), linkage.consts.end());
+    ShareTopLevel = linkage.exportAll;
+}
+
+bool ProgramInfo::analyze(const Program &prog, std::string_view source, std::string &error)
+{
+    Src = source;
+    // Hoist function declarations so calls may precede definitions.
+    for (const auto &s : prog.statements)
+    {
+        if (auto fd = ast_cast<FunctionDecl>(s))
+        {
+            if (functions.count(fd->name) || imports.count(fd->name))
+            {
+                error = "duplicate function '" + std::string(fd->name) + "'";
+                return false;
+            }
+            Function &fn = functions[fd->name];
+            fn.decl = fd;
+            for (size_t i = 0; i < fd->params.size(); ++i)
+                fn.params.push_back(param_kind(fd, i) == ValueKind::Bool ? ValueKind::Bool : ValueKind::Number);
+            walk(fd->body, [](const Stmt *) {}, [&](const Expr *e)
+                 { if (auto id = ast_cast<IdentifierExpr>(e)) UsedInFunctions.insert(id->name); });
+        }
+    }
+    inferReturnKinds();
+    for (const auto &kv : functions)
+    {
+        if (annotated_kind(kv.second.decl->returnType) == ValueKind::Bool && kv.second.ret != ValueKind::Bool)
+        {
+            error = "function '" + std::string(kv.first) + "' is declared to return boolean but may return a number";
+            return false;
+        }
+        // a number function does not turn the booleans it returns into 0/1
+        if (kv.second.ret == ValueKind::Number)
+        {
+            bool anyBool = false;
+            forEachReturn(kv.second, [&](const ReturnStmt *r, const std::map<std::string_view, ValueKind> &locals)
+                          { anyBool |= r->value && isBoolExpr(r->value, locals); });
+            if (anyBool)
+            {
+                error = "function '" + std::string(kv.first) +
+                        (annotated_kind(kv.second.decl->returnType) == ValueKind::Number
+                             ? "' is declared to return number but may return a boolean"
+                             : "' returns both booleans and numbers");
+                return false;
+            }
+        }
+    }
+
+    // Top-level declarations: string/object literals are folded at compile
+    // time, variables used inside functions (or by later REPL entries) are
+    // shared with them.
+    std::vector<const VarDeclStmt *> topDecls;
+    for (const auto &s : prog.statements)
+    {
+        if (auto v = ast_cast<VarDeclStmt>(s))
+            topDecls.push_back(v);
+        // `let a = 1, b = 2;` arrives as a block of declarations; any other
+        // block is a scope of its own
+        else if (auto b = ast_cast<BlockStmt>(s); b && b->declList)
+        {
+            for (const auto &c : b->statements)
+                if (auto v = ast_cast<VarDeclStmt>(c))
+                    topDecls.push_back(v);
+        }
+    }
+    for (const auto *v : topDecls)
+    {
+        auto lit = ast_cast<LiteralExpr>(v->value);
+        if (auto o = ast_cast<ObjectExpr>(v->value))
+        {
+            if (!foldObject(o, consts[v->name], error))
+                return false;
+        }
+        else if (lit && lit->kind == LiteralExpr::STRING)
+            consts[v->name] = Value(std::string(lit->value));
+        else if ((ShareTopLevel || UsedInFunctions.count(v->name)) && !globals.count(v->name))
+            globals[v->name] = annotated_kind(v->type).value_or(
+                v->value && isBoolExpr(v->value, {}) ? ValueKind::Bool : ValueKind::Number);
+    }
+
+    // A boolean has no room for undefined: a `boolean` variable that is read
+    // needs an initial value, a boolean parameter an argument, and a function
+    // that returns booleans must return one on every path.
+    for (const auto &kv : functions)
+    {
+        if (kv.second.ret == ValueKind::Bool && !ends_in_return(kv.second.decl->body))
+        {
+            error = "function '" + std::string(kv.first) + "' returns booleans but may end without returning one";
+            return false;
+        }
+    }
+    std::set<std::string_view> unset;
+    std::set<const Expr *> stores;
+    walkProgram(
+        prog,
+        [&](const Stmt *s, const FunctionDecl *)
+        {
+            if (auto v = ast_cast<VarDeclStmt>(s); v && !v->value && annotated_kind(v->type) == ValueKind::Bool)
+                unset.insert(v->name);
+        },
+        [&](const Expr *e, const FunctionDecl *)
+        {
+            if (auto a = ast_cast<AssignExpr>(e); a && a->op == TokenKind::Tok_Assign)
+                stores.insert(a->target);
+        });
+    std::string problem;
+    walkProgram(
+        prog, [](const Stmt *, const FunctionDecl *) {},
+        [&](const Expr *e, const FunctionDecl *)
+        {
+            if (auto id = ast_cast<IdentifierExpr>(e); id && unset.count(id->name) && !stores.count(e) && problem.empty())
+                problem = "boolean variable '" + std::string(id->name) + "' needs an initial value";
+            auto c = ast_cast<CallExpr>(e);
+            auto id = c ? ast_cast<IdentifierExpr>(c->callee) : nullptr;
+            if (!id || !problem.empty())
+                return;
+            const std::vector<ValueKind> *params = nullptr;
+            if (auto f = functions.find(id->name); f != functions.end())
+                params = &f->second.params;
+            else if (auto i = imports.find(id->name); i != imports.end())
+                params = &i->second.params;
+            for (size_t i = c->args.size(); params && i < params->size(); ++i)
+            {
+                if ((*params)[i] == ValueKind::Bool)
+                {
+                    problem = "missing argument " + std::to_string(i + 1) + " of '" + std::string(id->name) +
+                              "', a boolean";
+                    break;
+                }
+            }
+        });
+    if (!problem.empty())
+    {
+        error = problem;
+        return false;
+    }
+    inferNullish(prog);
+    return true;
+}
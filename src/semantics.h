@@ -0,0 +1,167 @@
+#pragma once
+#include <functional>
+#include <map>
+#include <optional>
+#include <set>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "ast.h"
+#include "value.h"
+
+// Language rules shared by the backends (LLVM codegen and the AST tier), so
+// that both agree on how values are typed, folded and printed.
+
+// Static kind of a runtime value. Everything that is not a boolean is a
+// double; undefined and null are the doubles with their Value bits (see
+// value.h), which ProgramInfo::mayBeNullish says where to expect.
+enum class ValueKind
+{
+    Number,
+    Bool
+};
+
+// Kind a `number` or `boolean` annotation (as typeToString prints it)
+// declares. Other annotations, and none, declare nothing: those values get
+// the kind the code gives them.
+std::optional<ValueKind> annotated_kind(std::string_view type);
+// The kind the annotation of parameter `i` of `fd` declares, if any.
+std::optional<ValueKind> param_kind(const FunctionDecl *fd, size_t i);
+
+// Printed values are wrapped in these escapes.
+inline const std::string yellow = "\033[33m";
+inline const std::string reset = "\033[0m";
+
+// String literal contents as the printer shows them: a backslash keeps only
+// the character after it.
+std::string unescape_string(std::string_view s);
+std::string format_number(double v);
+// Serialize a Value to JS-like string, with optional color for the whole object
+std::string serialize(const Value &v, const std::string &objColor);
+// The same, appended to `out`: one buffer for the whole object, however deep.
+void serialize(const Value &v, const std::string &objColor, std::string &out);
+// A constant as a print argument shows it: numbers and booleans exactly as
+// the same value computed at run time would print.
+std::string print_constant(const Value &v, const std::string &color, bool isConsole);
+// Numeric literal text as produced by the lexer: decimal, 0x/0o/0b, legacy
+// octal, with optional '_' separators.
+double parse_number_literal(std::string text);
+// Escape that starts a console.error/warn/info/success line ("" for print).
+std::string print_color(TokenKind origin);
+// console.error and console.warn lines go to stderr, everything else to stdout.
+bool prints_to_stderr(TokenKind origin);
+bool is_comparison(TokenKind op);
+// Binary operator behind a compound assignment ('+=' -> '+'), or Tok_Invalid.
+TokenKind compound_operator(TokenKind op);
+// The identifier a chain of member accesses starts from (`a` in `a.b?.c`), or
+// null when it starts from anything else.
+const IdentifierExpr *member_root(const MemberExpr *m);
+
+// Visit every statement and expression below `s` (not into nested functions'
+// siblings, but including their bodies when they are the root).
+void walk(const Stmt *s, const std::function<void(const Stmt *)> &onStmt,
+          const std::function<void(const Expr *)> &onExpr);
+void walk(const Expr *e, const std::function<void(const Stmt *)> &onStmt,
+          const std::function<void(const Expr *)> &onExpr);
+
+// A function a module of a multi-file program exports: what its importers
+// need to call it without seeing its body.
+struct ExportedFunction
+{
+    std::string symbol; // its name in the linked program
+    std::vector<ValueKind> params;
+    ValueKind ret;
+};
+
+// A top-level variable a REPL entry shares with the entries after it.
+struct ExportedVariable
+{
+    std::string symbol;
+    ValueKind kind;
+};
+
+// How one module of a multi-file program links with the others (see
+// modules.h): the functions it imports, by local name, and the prefix that
+// makes its exported functions' symbols unique. Everything else it defines
+// stays internal to it. An entry of a REPL session (see Session in engine.h)
+// also imports the variables and constants of the entries before it, and
+// exports all of its functions and top-level variables (`exportAll`).
+struct ModuleLinkage
+{
+    std::map<std::string_view, ExportedFunction> imports;
+    std::string exportPrefix;
+    std::map<std::string_view, ExportedVariable> variables;
+    std::map<std::string_view, Value> consts;
+    bool exportAll = false;
+};
+
+// Program-wide facts a backend needs before lowering any code: the hoisted
+// top-level functions and their parameter and return kinds, the folded string/object
+// constants, and the top-level variables that functions share (and their
+// kinds).
+class ProgramInfo
+{
+public:
+    struct Function
+    {
+        const FunctionDecl *decl;
+        ValueKind ret = ValueKind::Number;
+        // A `boolean` parameter is passed as one; every other one is a number.
+        std::vector<ValueKind> params;
+    };
+    std::map<std::string_view, Function> functions;
+    // Folded values of top-level bindings whose initializer is a string or
+    // object literal; they are printed as text.
+    std::map<std::string_view, Value> consts;
+    std::map<std::string_view, ValueKind> globals;
+    // Functions imported from other modules, by local name. Filled in by the
+    // caller before analyze(); calls to them are typed like local calls.
+    std::map<std::string_view, ExportedFunction> imports;
+
+    // Take the imports (and imported variables and constants) of `linkage`;
+    // call before analyze().
+    void link(const ModuleLinkage &linkage);
+    // Returns false and sets `error` for programs no backend can lower.
+    bool analyze(const Program &prog, std::string_view source, std::string &error);
+
+    // Kind inference that needs no lowered code: true when `e` is known to
+    // produce a boolean, with `locals` holding the kinds of visible locals.
+    bool isBoolExpr(const Expr *e, const std::map<std::string_view, ValueKind> &locals) const;
+    // Fold an object literal into a Value; fails on non-constant values.
+    bool foldObject(const ObjectExpr *o, Value &out, std::string &error) const;
+    // Whether `e`, evaluated in function `fn` (null at the top level), may
+    // yield undefined or null. Backends turn only those values into numbers
+    // before arithmetic, and fold `??` on anything else to its left side.
+    bool mayBeNullish(const Expr *e, const FunctionDecl *fn) const;
+    // Member access into a constant (`config.server.port`, where the root is
+    // in `consts` and no local shadows it). The object is immutable, so the
+    // access site is bound once, through the object's shape, to the value in
+    // its slot. A missing member is undefined; reading past one fails unless
+    // the access is optional (`?.`).
+    bool constMember(const MemberExpr *m, Value &out, std::string &error) const;
+    // "line N" for a source offset, for diagnostics.
+    std::string where(size_t pos) const;
+
+private:
+    std::string_view Src;
+    std::set<std::string_view> UsedInFunctions;
+    bool ShareTopLevel = false; // every top-level variable is a global
+    void inferReturnKinds();
+    // Names each function declares (parameters and locals).
+    std::map<const FunctionDecl *, std::set<std::string_view>> Locals;
+    // Variables (by the function that declares them, null for the top
+    // level) and functions that may hold or return undefined or null.
+    std::set<std::pair<const FunctionDecl *, std::string_view>> NullishVars;
+    std::set<std::string_view> NullishReturns;
+    void inferNullish(const Program &prog);
+    bool varMayBeNullish(const FunctionDecl *fn, std::string_view name) const;
+    // Calls `onStmt` and `onExpr` for everything in the program, with the
+    // function it belongs to (null at the top level).
+    void walkProgram(const Program &prog, const std::function<void(const Stmt *, const FunctionDecl *)> &onStmt,
+                     const std::function<void(const Expr *, const FunctionDecl *)> &onExpr) const;
+    // Calls `onReturn` for each return statement of `fn`, with the kinds of
+    // its parameters and the locals declared before the statement.
+    void forEachReturn(const Function &fn,
+                       const std::function<void(const ReturnStmt *, const std::map<std::string_view, ValueKind> &)>
+                           &onReturn) const;
+};
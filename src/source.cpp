@@ -0,0 +1,25 @@
+#include "source.h"
+
+#include <llvm/Support/MemoryBuffer.h>
+
+std::unique_ptr<SourceFile> SourceFile::open(const std::string &path, std::string &error)
+{
+    // No terminating NUL is needed (the lexer is bounds-checked), which lets
+    // MemoryBuffer map files whose size is a multiple of the page size.
+    auto buf = llvm::MemoryBuffer::getFile(path, /*IsText=*/false, /*RequiresNullTerminator=*/false);
+    if (!buf)
+    {
+        error = buf.getError().message();
+        return nullptr;
+    }
+    return std::unique_ptr<SourceFile>(new SourceFile(std::move(*buf)));
+}
+
+SourceFile::SourceFile(std::unique_ptr<llvm::MemoryBuffer> buf) : Buf(std::move(buf)) {}
+
+SourceFile::~SourceFile() = default;
+
+std::string_view SourceFile::text() const
+{
+    return std::string_view(Buf->getBufferStart(), Buf->getBufferSize());
+}
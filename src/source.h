@@ -0,0 +1,26 @@
+#pragma once
+#include <memory>
+#include <string>
+#include <string_view>
+
+namespace llvm
+{
+class MemoryBuffer;
+}
+
+// Read-only contents of an input file. llvm::MemoryBuffer memory-maps large
+// files and reads small ones in one call; either way the file is read once
+// and its bytes are handed to the lexer without further copies. The text is
+// the raw file bytes (no CRLF translation).
+class SourceFile {
+public:
+  // Returns null and sets `error` when the file cannot be read.
+  static std::unique_ptr<SourceFile> open(const std::string &path, std::string &error);
+  ~SourceFile();
+
+  std::string_view text() const;
+
+private:
+  explicit SourceFile(std::unique_ptr<llvm::MemoryBuffer> buf);
+  std::unique_ptr<llvm::MemoryBuffer> Buf;
+};
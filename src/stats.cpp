@@ -0,0 +1,149 @@
+#include "stats.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <tuple>
+#include <vector>
+
+namespace
+{
+
+struct Event
+{
+    const char *name;
+    uint64_t start, duration; // microseconds since stats_enable
+    unsigned depth;
+    unsigned thread;
+};
+
+std::atomic<bool> Enabled{false};
+StatsOptions Options;
+std::chrono::steady_clock::time_point Epoch;
+std::atomic<uint64_t> Counters[size_t(Counter::Count)];
+std::mutex EventsLock;
+std::vector<Event> Events;
+std::atomic<unsigned> Threads{0};
+thread_local unsigned ThreadDepth = 0; // phases open on this thread
+
+const char *const CounterNames[] = {"tokens lexed", "ast nodes", "parser backtracks", "parser memo hits", "ir instructions", "modules compiled", "modules reused"};
+static_assert(sizeof CounterNames / sizeof *CounterNames == size_t(Counter::Count), "one name per counter");
+
+uint64_t now_us()
+{
+    return uint64_t(std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - Epoch).count());
+}
+
+// Small per-process thread numbers, in order of each thread's first phase.
+unsigned thread_number()
+{
+    thread_local unsigned number = Threads.fetch_add(1) + 1;
+    return number;
+}
+
+// Phase totals by thread, name and depth, in the order they first started;
+// background threads (the tier's compile) come after the main thread. A
+// parent starts no later than its children, so it is listed first.
+void print_phases(uint64_t wall)
+{
+    struct Row
+    {
+        const char *name;
+        unsigned depth;
+        unsigned thread;
+        uint64_t total;
+        unsigned calls;
+    };
+    std::vector<const Event *> order;
+    for (const Event &e : Events)
+        order.push_back(&e);
+    std::sort(order.begin(), order.end(), [](const Event *a, const Event *b)
+              { return std::tie(a->thread, a->start, a->depth) < std::tie(b->thread, b->start, b->depth); });
+    std::vector<Row> rows;
+    for (const Event *e : order)
+    {
+        auto it = std::find_if(rows.begin(), rows.end(), [&](const Row &r)
+                               { return r.thread == e->thread && r.depth == e->depth && std::strcmp(r.name, e->name) == 0; });
+        if (it == rows.end())
+            it = rows.insert(rows.end(), Row{e->name, e->depth, e->thread, 0, 0});
+        it->total += e->duration;
+        ++it->calls;
+    }
+    std::fprintf(stderr, "%-24s %12s %8s\n", "phase", "ms", "calls");
+    for (size_t i = 0; i < rows.size(); ++i)
+    {
+        const Row &r = rows[i];
+        if (i && r.thread != rows[i - 1].thread)
+            std::fprintf(stderr, "(thread %u)\n", r.thread);
+        std::fprintf(stderr, "%*s%-*s %12.3f %8u\n", int(2 * r.depth), "", std::max(0, 24 - int(2 * r.depth)), r.name,
+                     r.total / 1000.0, r.calls);
+    }
+    std::fprintf(stderr, "%-24s %12.3f\n", "total", wall / 1000.0);
+}
+
+void write_trace(uint64_t wall)
+{
+    std::FILE *f = std::fopen(Options.tracePath.c_str(), "w");
+    if (!f)
+    {
+        std::fprintf(stderr, "oong: could not write trace %s\n", Options.tracePath.c_str());
+        return;
+    }
+    std::fprintf(f, "{\"traceEvents\": [\n");
+    for (const Event &e : Events)
+        std::fprintf(f, "  {\"name\": \"%s\", \"ph\": \"X\", \"ts\": %llu, \"dur\": %llu, \"pid\": 1, \"tid\": %u},\n",
+                     e.name, (unsigned long long)e.start, (unsigned long long)e.duration, e.thread);
+    std::fprintf(f, "  {\"name\": \"counters\", \"ph\": \"C\", \"ts\": %llu, \"pid\": 1, \"args\": {", (unsigned long long)wall);
+    for (size_t i = 0; i < size_t(Counter::Count); ++i)
+        std::fprintf(f, "%s\"%s\": %llu", i ? ", " : "", CounterNames[i], (unsigned long long)Counters[i].load());
+    std::fprintf(f, "}}\n]}\n");
+    std::fclose(f);
+}
+
+void report()
+{
+    uint64_t wall = now_us();
+    std::lock_guard<std::mutex> guard(EventsLock);
+    if (Options.timePhases)
+        print_phases(wall);
+    if (Options.counters)
+        for (size_t i = 0; i < size_t(Counter::Count); ++i)
+            std::fprintf(stderr, "%-24s %12llu\n", CounterNames[i], (unsigned long long)Counters[i].load());
+    if (!Options.tracePath.empty())
+        write_trace(wall);
+}
+
+} // namespace
+
+void stats_enable(const StatsOptions &options)
+{
+    if (Enabled || !(options.timePhases || options.counters || !options.tracePath.empty()))
+        return;
+    Options = options;
+    Epoch = std::chrono::steady_clock::now();
+    Enabled = true;
+    std::atexit(report);
+}
+
+void stats_count(Counter counter, uint64_t n)
+{
+    Counters[size_t(counter)].fetch_add(n, std::memory_order_relaxed);
+}
+
+PhaseTimer::PhaseTimer(const char *name)
+    : Name(Enabled.load(std::memory_order_relaxed) ? name : nullptr), Start(Name ? now_us() : 0), Depth(Name ? ThreadDepth++ : 0)
+{
+}
+
+PhaseTimer::~PhaseTimer()
+{
+    if (!Name)
+        return;
+    uint64_t end = now_us();
+    --ThreadDepth;
+    std::lock_guard<std::mutex> guard(EventsLock);
+    Events.push_back({Name, Start, end - Start, Depth, thread_number()});
+}
@@ -0,0 +1,52 @@
+#pragma once
+#include <cstdint>
+#include <string>
+
+// Where a run spends its time, for --time-phases, --stats and --trace. A
+// PhaseTimer around each phase (reading the file, lexing, parsing, building
+// IR, compiling, executing, ...) records how long it took, and counters add
+// up the work done: tokens, AST nodes, parser backtracks (and the memo hits
+// that replaced them), IR instructions, and the modules `oong -c` lowered or
+// reused.
+// Collection is off until stats_enable, and then costs a clock read per phase;
+// the report is printed to stderr, and the trace written, when the process
+// exits.
+enum class Counter
+{
+    TokensLexed,
+    AstNodes,
+    Backtracks,
+    MemoHits,
+    IrInstructions,
+    ModulesCompiled,
+    ModulesReused,
+    Count
+};
+
+struct StatsOptions
+{
+    bool timePhases = false; // per-phase times
+    bool counters = false;   // counter totals
+    // Chrome trace (JSON trace event format) of every phase, for
+    // chrome://tracing or Perfetto; empty for none.
+    std::string tracePath;
+};
+
+void stats_enable(const StatsOptions &options);
+void stats_count(Counter counter, uint64_t n);
+
+// Times the enclosing scope as phase `name` (a string literal). Phases nest;
+// each thread has its own stack of them.
+class PhaseTimer
+{
+public:
+    explicit PhaseTimer(const char *name);
+    ~PhaseTimer();
+    PhaseTimer(const PhaseTimer &) = delete;
+    PhaseTimer &operator=(const PhaseTimer &) = delete;
+
+private:
+    const char *Name; // null when collection is off
+    uint64_t Start;
+    unsigned Depth;
+};
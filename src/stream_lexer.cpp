@@ -0,0 +1,45 @@
+#include "stream_lexer.h"
+
+namespace
+{
+
+// Bytes past the end of a token the lexer may have looked at to decide where
+// it ends (`<!--`, `...`, escapes); a token is final once this much input
+// follows it.
+constexpr size_t Lookahead = 64;
+
+} // namespace
+
+void StreamLexer::refill()
+{
+  // Keep the last character of the previous token: whether a '/' starts a
+  // regex depends on it.
+  size_t keep = Next.pos ? Next.pos - 1 : 0;
+  Window.erase(0, keep);
+  WindowStart += keep;
+  Next.pos -= keep;
+  size_t have = Window.size();
+  Window.resize(have + ChunkSize);
+  size_t n = Read(&Window[have], ChunkSize);
+  Window.resize(have + n);
+  if (n == 0)
+    AtEnd = true;
+}
+
+Token StreamLexer::nextToken()
+{
+  for (;;)
+  {
+    Lexer L(Window, Next, Strict);
+    Token t = L.nextToken();
+    // Tok_EOF before the end of the input ends at the window's end, so it
+    // always waits for more.
+    if (AtEnd || t.pos + t.text.size() + Lookahead <= Window.size())
+    {
+      Next = L.resumePoint();
+      t.pos += WindowStart;
+      return t;
+    }
+    refill();
+  }
+}
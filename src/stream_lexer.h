@@ -0,0 +1,40 @@
+#pragma once
+#include <cstddef>
+#include <functional>
+#include <string>
+#include "lexer.h"
+
+// Lexer over input that arrives in chunks (a pipe, a generated file): it
+// pulls chunks from a reader as tokens are asked for and holds only a window
+// of the input, so memory is bounded by the chunk size plus the longest token
+// rather than by the size of the input. Tokens may span chunk boundaries: one
+// that ends too close to the end of the window to be known complete is lexed
+// again once more input has come in. Token positions are offsets in the whole
+// input, but a token's text is only valid until the next call to nextToken().
+// The Parser needs all of its source at once (AST text points into it); this
+// is for consumers that look at each token once.
+class StreamLexer {
+public:
+  // Fills `buf` with up to `size` bytes of input and returns how many; 0 at
+  // the end of the input.
+  using Reader = std::function<size_t(char *buf, size_t size)>;
+  explicit StreamLexer(Reader read, size_t chunkSize = 64 * 1024, bool strict = false)
+    : Read(std::move(read)), ChunkSize(chunkSize ? chunkSize : 1), Strict(strict) {}
+  // Tok_EOF, again and again, once the input is used up.
+  Token nextToken();
+  // Input read so far, in bytes.
+  size_t bytesRead() const { return WindowStart + Window.size(); }
+
+private:
+  // Drop the input before the next token (but one character, see below) and
+  // append a chunk; sets AtEnd when there is none left.
+  void refill();
+
+  Reader Read;
+  size_t ChunkSize;
+  bool Strict;
+  std::string Window;     // the input from WindowStart on
+  size_t WindowStart = 0; // offset of Window[0] in the input
+  Lexer::Resume Next;     // relative to Window
+  bool AtEnd = false;
+};
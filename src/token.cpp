@@ -376,7 +376,7 @@ std::string tokenToString(const Token &t)
     os << "BigBinaryIntegerLiteral";
     break;
   case TokenKind::Tok_Integer:
-    os << "Integer(" << (t.intValue ? std::to_string(*t.intValue) : t.text) << ")";
+    os << "Integer(" << (t.intValue ? std::to_string(*t.intValue) : t.str()) << ")";
     break;
   case TokenKind::Tok_Invalid:
     os << "Invalid(" << t.text << ")";
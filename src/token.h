@@ -1,5 +1,6 @@
 #pragma once
 #include <string>
+#include <string_view>
 #include <cstdint>
 #include <optional>
 #include <sstream>
@@ -150,9 +151,11 @@ enum class TokenKind {
 
 struct Token {
   TokenKind kind;
-  std::string text; // raw text for the token
+  std::string_view text; // raw text for the token: a view into the lexer's source
   size_t pos{0};    // start position in source
   std::optional<int64_t> intValue; // parsed integer value for integer tokens
+  // Owned copy of the text, for callers that must outlive the source buffer.
+  std::string str() const { return std::string(text); }
 };
 
 // Debug helper
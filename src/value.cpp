@@ -0,0 +1,141 @@
+#include "value.h"
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <cstring>
+#include <mutex>
+
+struct Value::Cell
+{
+    std::atomic<uint32_t> refs{1};
+    virtual ~Cell() = default;
+};
+
+struct Value::StringCell : Cell
+{
+    explicit StringCell(std::string s) : text(std::move(s)) {}
+    std::string text;
+};
+
+struct Value::ObjectCell : Cell
+{
+    const Shape *shape;
+    std::vector<Value> slots;
+};
+
+namespace
+{
+
+// Guards every shape's transitions; shapes are built while folding constants,
+// which the AST tier and a background compile may do at the same time.
+std::mutex TransitionLock;
+
+} // namespace
+
+const Value::Shape *Value::Shape::empty()
+{
+    static const Shape *root = new Shape; // shapes live as long as the process
+    return root;
+}
+
+const Value::Shape *Value::Shape::add(const std::string &key) const
+{
+    std::lock_guard<std::mutex> guard(TransitionLock);
+    for (const auto &t : Transitions)
+        if (t.first == key)
+            return t.second;
+    auto *next = new Shape;
+    next->Keys = Keys;
+    next->Keys.push_back(key);
+    Transitions.emplace_back(key, next);
+    return next;
+}
+
+int Value::Shape::slot(std::string_view key) const
+{
+    auto it = std::lower_bound(Keys.begin(), Keys.end(), key);
+    return it != Keys.end() && *it == key ? int(it - Keys.begin()) : -1;
+}
+
+Value::Value(double n)
+{
+    if (n != n)
+        Bits = CanonicalNaN;
+    else
+        std::memcpy(&Bits, &n, sizeof n);
+}
+
+Value::Value(std::string s) : Value(StringTag, new StringCell(std::move(s))) {}
+
+Value Value::object(std::vector<Member> members)
+{
+    std::stable_sort(members.begin(), members.end(),
+                     [](const Member &a, const Member &b) { return a.first < b.first; });
+    auto *c = new ObjectCell;
+    c->shape = Shape::empty();
+    c->slots.reserve(members.size());
+    for (size_t i = 0; i < members.size(); ++i)
+        if (i + 1 == members.size() || members[i + 1].first != members[i].first)
+        {
+            c->shape = c->shape->add(members[i].first);
+            c->slots.push_back(std::move(members[i].second));
+        }
+    return Value(ObjectTag, c);
+}
+
+Value::Value(uint64_t tag, Cell *cell) : Bits(tag | reinterpret_cast<uintptr_t>(cell))
+{
+    // user-space pointers fit in the 48-bit payload
+    assert((reinterpret_cast<uintptr_t>(cell) & ~PayloadMask) == 0);
+}
+
+double Value::number() const
+{
+    double n;
+    std::memcpy(&n, &Bits, sizeof n);
+    return n;
+}
+
+const std::string &Value::string() const
+{
+    assert(type() == Type::String);
+    return static_cast<const StringCell *>(cell())->text;
+}
+
+const Value::Shape &Value::shape() const
+{
+    assert(type() == Type::Object);
+    return *static_cast<const ObjectCell *>(cell())->shape;
+}
+
+const std::vector<std::string> &Value::keys() const
+{
+    return shape().keys();
+}
+
+const std::vector<Value> &Value::slots() const
+{
+    assert(type() == Type::Object);
+    return static_cast<const ObjectCell *>(cell())->slots;
+}
+
+const Value *Value::find(std::string_view key) const
+{
+    if (type() != Type::Object)
+        return nullptr;
+    int i = shape().slot(key);
+    return i < 0 ? nullptr : &slots()[i];
+}
+
+void Value::retain() const
+{
+    if (Cell *c = cell())
+        c->refs.fetch_add(1, std::memory_order_relaxed);
+}
+
+void Value::release()
+{
+    if (Cell *c = cell(); c && c->refs.fetch_sub(1, std::memory_order_acq_rel) == 1)
+        delete c;
+    Bits = UndefinedTag;
+}
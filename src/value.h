@@ -0,0 +1,127 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+// A language value in one 64-bit word (NaN boxing). A number is its own
+// IEEE-754 bits, so a number Value is exactly the double that generated code
+// and the AST tier pass around. Every NaN is stored as the canonical quiet
+// NaN, leaving the rest of the NaN space free to tag the other types in the
+// top 16 bits:
+//
+//   0xFFF9  boolean, payload 0 or 1
+//   0xFFFA  string, payload a pointer to its heap cell
+//   0xFFFB  object, payload a pointer to its heap cell
+//   0xFFFC  undefined
+//   0xFFFD  null
+//
+// Generated code and the AST tier keep undefined and null in their doubles
+// with these same bits; arithmetic never produces them, since they are turned
+// into NaN and 0 (ToNumber) before any operation that could pass them on.
+//
+// Strings and objects are immutable, reference-counted heap cells, so copying
+// a Value copies a word and bumps a count, however large the object behind it.
+// A cell only refers to values that existed before it, so cells never form
+// cycles, and the counts free every one of them as soon as it is unreachable.
+//
+// An object keeps its member values in a flat array of slots; which key is in
+// which slot is its shape (hidden class). Objects with the same keys share one
+// shape, reached from the empty shape by one transition per key added, so the
+// keys are stored once however many objects use them, and a member access
+// site that has seen an object's shape can go straight to the slot.
+class Value
+{
+public:
+    enum class Type
+    {
+        Number,
+        Bool,
+        String,
+        Object,
+        Undefined,
+        Null
+    };
+    static constexpr uint64_t UndefinedTag = 0xFFFC000000000000;
+    static constexpr uint64_t NullTag = 0xFFFD000000000000;
+    using Member = std::pair<std::string, Value>;
+
+    Value() : Bits(UndefinedTag) {}
+    static Value null()
+    {
+        Value v;
+        v.Bits = NullTag;
+        return v;
+    }
+    Value(double n);
+    Value(bool b) : Bits(BoolTag | uint64_t(b)) {}
+    Value(std::string s);
+    Value(const char *) = delete; // would silently pick the bool overload
+    // An object with `members` in key order; of repeated keys the last wins.
+    static Value object(std::vector<Member> members);
+    class Shape;
+
+    Value(const Value &other) : Bits(other.Bits) { retain(); }
+    Value(Value &&other) noexcept : Bits(other.Bits) { other.Bits = UndefinedTag; }
+    Value &operator=(Value other) noexcept
+    {
+        std::swap(Bits, other.Bits);
+        return *this;
+    }
+    ~Value() { release(); }
+
+    Type type() const
+    {
+        if (Bits < BoolTag)
+            return Type::Number;
+        return Type((Bits >> 48) - (BoolTag >> 48) + 1);
+    }
+    double number() const;
+    bool boolean() const { return Bits & 1; }
+    const std::string &string() const;
+    // Objects: keys()[i] is the key of slots()[i], in key order.
+    const Shape &shape() const;
+    const std::vector<std::string> &keys() const;
+    const std::vector<Value> &slots() const;
+    // The member named `key`, or null (also for non-objects).
+    const Value *find(std::string_view key) const;
+
+private:
+    struct Cell;
+    struct StringCell;
+    struct ObjectCell;
+    static constexpr uint64_t CanonicalNaN = 0x7FF8000000000000;
+    static constexpr uint64_t BoolTag = 0xFFF9000000000000;
+    static constexpr uint64_t StringTag = 0xFFFA000000000000;
+    static constexpr uint64_t ObjectTag = 0xFFFB000000000000;
+    static constexpr uint64_t PayloadMask = 0x0000FFFFFFFFFFFF;
+
+    Value(uint64_t tag, Cell *cell);
+    Cell *cell() const
+    {
+        return Bits >= StringTag && Bits < UndefinedTag ? reinterpret_cast<Cell *>(Bits & PayloadMask) : nullptr;
+    }
+    void retain() const;
+    void release();
+
+    uint64_t Bits;
+};
+
+class Value::Shape
+{
+public:
+    const std::vector<std::string> &keys() const { return Keys; }
+    // Slot holding `key`, or -1.
+    int slot(std::string_view key) const;
+
+private:
+    friend class Value;
+    static const Shape *empty();
+    // The shape of an object with this shape's keys plus `key`, which must
+    // sort after all of them.
+    const Shape *add(const std::string &key) const;
+
+    std::vector<std::string> Keys;
+    mutable std::vector<std::pair<std::string, const Shape *>> Transitions;
+};
@@ -0,0 +1,33 @@
+# Runs one script and compares what it prints with checked-in output; used by
+# the golden-output entries in CMakeLists.txt:
+#   cmake -DOONG=path/to/oong "-DFLAGS=--no-cache --no-tier" -DSCRIPT=tests/x.oo
+#         -DEXPECTED=tests/x.expected -P tests/check_output.cmake
+# The script must exit with 0 and its stdout must equal EXPECTED. If a
+# <EXPECTED minus .expected>.stderr.expected file exists, stderr must equal it
+# too, otherwise stderr must be empty. Carriage returns in the expected files
+# are ignored, so a CRLF checkout still passes.
+separate_arguments(flags UNIX_COMMAND "${FLAGS}")
+execute_process(
+  COMMAND ${OONG} ${flags} ${SCRIPT}
+  RESULT_VARIABLE rc
+  OUTPUT_VARIABLE out
+  ERROR_VARIABLE err
+)
+if(NOT rc EQUAL 0)
+  message(FATAL_ERROR "${SCRIPT} exited with ${rc}\n${err}")
+endif()
+
+function(expect stream actual file)
+  set(expected "")
+  if(EXISTS ${file})
+    file(READ ${file} expected)
+    string(REPLACE "\r" "" expected "${expected}")
+  endif()
+  if(NOT actual STREQUAL expected)
+    message(FATAL_ERROR "${SCRIPT} ${stream} differs from ${file}\n--- expected\n${expected}--- got\n${actual}")
+  endif()
+endfunction()
+
+string(REGEX REPLACE "\\.expected$" ".stderr.expected" expected_err ${EXPECTED})
+expect(stdout "${out}" ${EXPECTED})
+expect(stderr "${err}" ${expected_err})
@@ -0,0 +1,135 @@
+// Microbenchmark for keyword recognition in the lexer's identifier path.
+// Compares Lexer::keywordKind (compile-time perfect hash) against the linear
+// chain of string compares it replaced, on the identifiers of a source file
+// (default: example/benchmark.oo) mixed with every keyword. With --check it
+// only checks that both agree on every word (the `keywords` ctest).
+//
+// Build: cmake --build build --target bench_keywords
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string_view>
+#include <vector>
+#include "lexer.h"
+
+// The if-chain keywordKind replaced, kept as the baseline.
+static TokenKind linearKeywordKind(std::string_view txt, bool strict) {
+  if (txt == "any") return TokenKind::Tok_Any;
+  if (txt == "number") return TokenKind::Tok_Number;
+  if (txt == "never") return TokenKind::Tok_Never;
+  if (txt == "boolean") return TokenKind::Tok_Boolean;
+  if (txt == "string") return TokenKind::Tok_String;
+  if (txt == "unique") return TokenKind::Tok_Unique;
+  if (txt == "symbol") return TokenKind::Tok_Symbol;
+  if (txt == "undefined") return TokenKind::Tok_Undefined;
+  if (txt == "object") return TokenKind::Tok_Object;
+  if (txt == "print") return TokenKind::Tok_Print;
+  if (txt == "console.log") return TokenKind::Tok_ConsoleLog;
+  if (txt == "break") return TokenKind::Tok_Break;
+  if (txt == "do") return TokenKind::Tok_Do;
+  if (txt == "instanceof") return TokenKind::Tok_Instanceof;
+  if (txt == "typeof") return TokenKind::Tok_Typeof;
+  if (txt == "case") return TokenKind::Tok_Case;
+  if (txt == "else") return TokenKind::Tok_Else;
+  if (txt == "new") return TokenKind::Tok_New;
+  if (txt == "var") return TokenKind::Tok_Var;
+  if (txt == "catch") return TokenKind::Tok_Catch;
+  if (txt == "finally") return TokenKind::Tok_Finally;
+  if (txt == "return") return TokenKind::Tok_Return;
+  if (txt == "void") return TokenKind::Tok_Void;
+  if (txt == "continue") return TokenKind::Tok_Continue;
+  if (txt == "for") return TokenKind::Tok_For;
+  if (txt == "switch") return TokenKind::Tok_Switch;
+  if (txt == "while") return TokenKind::Tok_While;
+  if (txt == "debugger") return TokenKind::Tok_Debugger;
+  if (txt == "function") return TokenKind::Tok_Function;
+  if (txt == "this") return TokenKind::Tok_This;
+  if (txt == "with") return TokenKind::Tok_With;
+  if (txt == "if") return TokenKind::Tok_If;
+  if (txt == "throw") return TokenKind::Tok_Throw;
+  if (txt == "delete") return TokenKind::Tok_Delete;
+  if (txt == "in") return TokenKind::Tok_In;
+  if (txt == "try") return TokenKind::Tok_Try;
+  if (txt == "default") return TokenKind::Tok_Default;
+  if (txt == "as") return TokenKind::Tok_As;
+  if (txt == "from") return TokenKind::Tok_From;
+  if (txt == "of") return TokenKind::Tok_Of;
+  if (txt == "yield") return TokenKind::Tok_Yield;
+  if (txt == "yield*") return TokenKind::Tok_YieldStar;
+  if (txt == "class") return TokenKind::Tok_Class;
+  if (txt == "enum") return TokenKind::Tok_Enum;
+  if (txt == "extends") return TokenKind::Tok_Extends;
+  if (txt == "super") return TokenKind::Tok_Super;
+  if (txt == "const") return TokenKind::Tok_Const;
+  if (txt == "export") return TokenKind::Tok_Export;
+  if (txt == "import") return TokenKind::Tok_Import;
+  if (txt == "async") return TokenKind::Tok_Async;
+  if (txt == "await") return TokenKind::Tok_Await;
+  if (txt == "implements" && strict) return TokenKind::Tok_Implements;
+  if (txt == "private" && strict) return TokenKind::Tok_Private;
+  if (txt == "public" && strict) return TokenKind::Tok_Public;
+  if (txt == "interface" && strict) return TokenKind::Tok_Interface;
+  if (txt == "package" && strict) return TokenKind::Tok_Package;
+  if (txt == "protected" && strict) return TokenKind::Tok_Protected;
+  if (txt == "static" && strict) return TokenKind::Tok_Static;
+  if (txt == "let") return strict ? TokenKind::Tok_StrictLet : TokenKind::Tok_NonStrictLet;
+  if (txt == "null") return TokenKind::Tok_NullLiteral;
+  if (txt == "true" || txt == "false") return TokenKind::Tok_BooleanLiteral;
+  return TokenKind::Tok_Identifier;
+}
+
+template <typename F>
+static double nsPerLookup(const std::vector<std::string_view> &words, int rounds, F &&fn, size_t &sink) {
+  auto start = std::chrono::steady_clock::now();
+  for (int r = 0; r < rounds; ++r)
+    for (std::string_view w : words)
+      sink += static_cast<size_t>(fn(w));
+  std::chrono::duration<double, std::nano> ns = std::chrono::steady_clock::now() - start;
+  return ns.count() / (double(words.size()) * rounds);
+}
+
+int main(int argc, char **argv) {
+  bool checkOnly = argc > 1 && std::string_view(argv[1]) == "--check";
+  std::string path = argc > 1 + checkOnly ? argv[1 + checkOnly] : "example/benchmark.oo";
+  std::ifstream in(path);
+  if (!in) { std::cerr << "failed to open " << path << "\n"; return 2; }
+  std::ostringstream ss; ss << in.rdbuf();
+  std::string src = ss.str();
+
+  // word stream: every identifier-like token of the file, plus the strict-mode
+  // and contextual keywords so both lookup modes are exercised
+  std::vector<std::string_view> words;
+  Lexer L(src);
+  for (Token t = L.nextToken(); t.kind != TokenKind::Tok_EOF; t = L.nextToken()) {
+    char c = t.text.empty() ? 0 : t.text[0];
+    if ((c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c == '_' || c == '$')
+      words.push_back(t.text);
+  }
+  static const char *extra[] = {"implements", "private", "public", "interface", "package", "protected",
+                                "static", "let", "yield", "await", "async", "instanceof", "undefined"};
+  for (const char *e : extra)
+    words.push_back(e);
+  if (words.empty()) { std::cerr << "no identifiers in " << path << "\n"; return 2; }
+
+  for (bool strict : {false, true})
+    for (std::string_view w : words)
+      if (w.find('.') == std::string_view::npos && Lexer::keywordKind(w, strict) != linearKeywordKind(w, strict)) {
+        std::cerr << "mismatch for '" << w << "' (strict=" << strict << ")\n";
+        return 1;
+      }
+  if (checkOnly) {
+    std::cout << words.size() << " words agree\n";
+    return 0;
+  }
+
+  int rounds = int(20000000 / words.size()) + 1;
+  size_t sink = 0;
+  double linear = nsPerLookup(words, rounds, [](std::string_view w) { return linearKeywordKind(w, false); }, sink);
+  double hashed = nsPerLookup(words, rounds, [](std::string_view w) { return Lexer::keywordKind(w, false); }, sink);
+  std::cout << words.size() << " words x " << rounds << " rounds\n";
+  std::cout << "linear chain:  " << linear << " ns/lookup\n";
+  std::cout << "perfect hash:  " << hashed << " ns/lookup\n";
+  std::cout << "speedup:       " << linear / hashed << "x\n";
+  return sink == 42 ? 3 : 0; // keep `sink` observable
+}
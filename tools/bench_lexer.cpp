@@ -0,0 +1,151 @@
+// Lexer throughput benchmark for the scan.h fast paths. Lexes a file (default:
+// example/benchmark.oo) to EOF with the scalar kernel and with the one detected
+// for this CPU, checks both produce the same tokens, and reports MB/s. It does
+// the same for StreamLexer reading the file in 4 KiB chunks, and for
+// lex_tokens splitting it across every hardware thread (files of 512 KiB or
+// more, see lex_parallel.cpp). The checks run on the file repeated to at
+// least 1 MiB and split four ways, so lex_tokens stitches chunks even for a
+// small file on a single core; with --check only they run (the `lexer`
+// ctest).
+//
+// Build: cmake --build build --target bench_lexer
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+#include "lexer.h"
+#include "scan.h"
+#include "stream_lexer.h"
+
+static std::vector<Token> lexAll(const std::string &src) {
+  std::vector<Token> out;
+  Lexer L(src);
+  for (Token t = L.nextToken();; t = L.nextToken()) {
+    out.push_back(t);
+    if (t.kind == TokenKind::Tok_EOF) break;
+  }
+  return out;
+}
+
+static double mbPerSecond(const std::string &src, int rounds, size_t &sink) {
+  auto start = std::chrono::steady_clock::now();
+  for (int r = 0; r < rounds; ++r) {
+    Lexer L(src);
+    for (Token t = L.nextToken(); t.kind != TokenKind::Tok_EOF; t = L.nextToken())
+      sink += t.text.size();
+  }
+  std::chrono::duration<double> s = std::chrono::steady_clock::now() - start;
+  return double(src.size()) * rounds / (1024.0 * 1024.0) / s.count();
+}
+
+// StreamLexer over `src`, handed out `chunk` bytes at a time.
+static StreamLexer streamOver(const std::string &src, size_t chunk, size_t &offset) {
+  offset = 0;
+  return StreamLexer([&src, &offset](char *buf, size_t size) {
+    size_t n = std::min(size, src.size() - offset);
+    std::copy(src.data() + offset, src.data() + offset + n, buf);
+    offset += n;
+    return n;
+  }, chunk);
+}
+
+static double streamMbPerSecond(const std::string &src, int rounds, size_t &sink) {
+  auto start = std::chrono::steady_clock::now();
+  for (int r = 0; r < rounds; ++r) {
+    size_t offset;
+    StreamLexer L = streamOver(src, 4096, offset);
+    for (Token t = L.nextToken(); t.kind != TokenKind::Tok_EOF; t = L.nextToken())
+      sink += t.text.size();
+  }
+  std::chrono::duration<double> s = std::chrono::steady_clock::now() - start;
+  return double(src.size()) * rounds / (1024.0 * 1024.0) / s.count();
+}
+
+// Tokens of `what` against the kernel's; false, after saying where, if they differ.
+static bool sameTokens(const char *what, const std::vector<Token> &got, const std::vector<Token> &want) {
+  if (got.size() != want.size()) {
+    std::cerr << what << ": " << got.size() << " tokens instead of " << want.size() << "\n";
+    return false;
+  }
+  for (size_t i = 0; i < want.size(); ++i)
+    if (got[i].kind != want[i].kind || got[i].pos != want[i].pos || got[i].text != want[i].text) {
+      std::cerr << what << ": token " << i << " differs at offset " << want[i].pos << "\n";
+      return false;
+    }
+  return true;
+}
+
+static bool check(const std::string &src) {
+  scan_force_scalar(true);
+  std::vector<Token> scalar = lexAll(src);
+  scan_force_scalar(false);
+  std::vector<Token> fast = lexAll(src);
+  if (!sameTokens("scalar", scalar, fast))
+    return false;
+
+  // a streamed token's text lives in the window only until the next refill
+  size_t offset;
+  StreamLexer L = streamOver(src, 4096, offset);
+  for (size_t i = 0; i < fast.size(); ++i) {
+    Token t = L.nextToken();
+    if (t.kind != fast[i].kind || t.pos != fast[i].pos || t.text != fast[i].text) {
+      std::cerr << "streamed: token " << i << " differs at offset " << fast[i].pos << "\n";
+      return false;
+    }
+  }
+  return sameTokens("parallel", lex_tokens(src, 4), fast);
+}
+
+static double parallelMbPerSecond(const std::string &src, int rounds, size_t &sink) {
+  auto start = std::chrono::steady_clock::now();
+  for (int r = 0; r < rounds; ++r)
+    sink += lex_tokens(src).size();
+  std::chrono::duration<double> s = std::chrono::steady_clock::now() - start;
+  return double(src.size()) * rounds / (1024.0 * 1024.0) / s.count();
+}
+
+int main(int argc, char **argv) {
+  bool checkOnly = argc > 1 && std::string_view(argv[1]) == "--check";
+  std::string path = argc > 1 + checkOnly ? argv[1 + checkOnly] : "example/benchmark.oo";
+  std::ifstream in(path);
+  if (!in) { std::cerr << "failed to open " << path << "\n"; return 2; }
+  std::ostringstream ss; ss << in.rdbuf();
+  std::string src = ss.str();
+  if (src.empty()) { std::cerr << path << " is empty\n"; return 2; }
+
+  std::string repeated = src;
+  while (repeated.size() < 1024 * 1024)
+    repeated += "\n" + src;
+  if (!check(repeated))
+    return 1;
+  const char *kernel = scan_kernel_name();
+  if (checkOnly) {
+    std::cout << "scalar, " << kernel << ", streamed and parallel tokens agree on " << repeated.size() << " bytes\n";
+    return 0;
+  }
+
+  // best of three alternating runs, so neither kernel profits from going last
+  int rounds = int(100 * 1024 * 1024 / src.size()) + 1;
+  size_t sink = 0;
+  double slow = 0, quick = 0, streamed = 0, split = 0;
+  for (int i = 0; i < 3; ++i) {
+    scan_force_scalar(true);
+    slow = std::max(slow, mbPerSecond(src, rounds, sink));
+    scan_force_scalar(false);
+    quick = std::max(quick, mbPerSecond(src, rounds, sink));
+    streamed = std::max(streamed, streamMbPerSecond(src, rounds, sink));
+    split = std::max(split, parallelMbPerSecond(src, rounds, sink));
+  }
+  std::cout << lexAll(src).size() << " tokens, " << src.size() << " bytes x " << rounds << " rounds\n";
+  std::cout << "scalar: " << slow << " MB/s\n";
+  std::cout << kernel << ": " << quick << " MB/s\n";
+  std::cout << "speedup: " << quick / slow << "x\n";
+  std::cout << "streamed (4 KiB chunks): " << streamed << " MB/s\n";
+  std::cout << "lex_tokens (" << std::thread::hardware_concurrency() << " threads): " << split << " MB/s\n";
+  return sink == 42 ? 3 : 0; // keep `sink` observable
+}
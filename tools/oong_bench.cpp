@@ -0,0 +1,326 @@
+// Benchmark suite for the whole pipeline. For each script (default: every .oo
+// file in example/bench) it measures lexer and parser throughput, the AST the
+// parse builds, and one end-to-end JIT run split into its phases: parse,
+// codegen (IR construction and verification), optimize, JIT (creating LLJIT
+// and compiling to machine code) and execute (program output is discarded).
+// Times are the best of --rounds runs. With --node, the script's .js twin is
+// run under node as a reference (wall time, node startup included).
+//
+// --json prints the results as JSON, one benchmark per line; save that as a
+// baseline and pass it to --baseline=FILE to compare a later run against it:
+// times that grew (or throughputs that fell) by more than --threshold percent
+// are reported, and the exit code is 1 if there are any. Timings depend on the
+// machine, so no baseline is checked in; if FILE does not exist the comparison
+// is skipped with a message instead.
+//
+// Build: cmake --build build --target oong_bench (or --target bench to run the
+// suite from the repository root)
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+#ifdef _WIN32
+#include <fcntl.h>
+#include <io.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+#include "codegen.h"
+#include "interpreter.h"
+#include "parser.h"
+#include "runtime.h"
+
+#include <llvm/ExecutionEngine/Orc/LLJIT.h>
+#include <llvm/ExecutionEngine/Orc/ThreadSafeModule.h>
+#include <llvm/IR/LLVMContext.h>
+#include <llvm/IR/Module.h>
+#include <llvm/IR/Verifier.h>
+#include <llvm/Support/Error.h>
+#include <llvm/Support/TargetSelect.h>
+#include <llvm/Support/raw_ostream.h>
+
+using Clock = std::chrono::steady_clock;
+
+static double msSince(Clock::time_point start) {
+  return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+// Metrics of one script, in output order. Names ending in _ms are times and
+// names ending in _mb_s throughputs; the rest are counts.
+using Metrics = std::vector<std::pair<std::string, double>>;
+
+static void keepBest(Metrics &best, const Metrics &run) {
+  if (best.empty()) { best = run; return; }
+  for (size_t i = 0; i < best.size(); ++i) {
+    const std::string &key = best[i].first;
+    if (key.size() > 3 && key.compare(key.size() - 3, 3, "_ms") == 0)
+      best[i].second = std::min(best[i].second, run[i].second);
+    else if (key.size() > 5 && key.compare(key.size() - 5, 5, "_mb_s") == 0)
+      best[i].second = std::max(best[i].second, run[i].second);
+  }
+}
+
+// Lex or parse the source repeatedly for about this many bytes, so that short
+// scripts still give a stable throughput.
+static const size_t ThroughputBytes = 8 * 1024 * 1024;
+static volatile size_t Sink; // keeps the measured loops from being optimized away
+
+static Metrics frontEnd(const std::string &src) {
+  size_t repeat = ThroughputBytes / std::max<size_t>(src.size(), 1) + 1;
+  double mb = double(src.size()) * repeat / (1024.0 * 1024.0);
+  size_t tokens = 0, sink = 0;
+  auto start = Clock::now();
+  for (size_t r = 0; r < repeat; ++r) {
+    Lexer L(src);
+    for (Token t = L.nextToken(); t.kind != TokenKind::Tok_EOF; t = L.nextToken()) {
+      sink += t.text.size();
+      tokens += r == 0;
+    }
+  }
+  double lexMs = msSince(start);
+
+  size_t nodes = 0, bytes = 0;
+  start = Clock::now();
+  for (size_t r = 0; r < repeat; ++r) {
+    Parser P(src);
+    auto R = P.parse();
+    sink += R.ok;
+    nodes = P.context().nodeCount();
+    bytes = P.context().bytesAllocated();
+  }
+  double parseMs = msSince(start);
+  Sink = sink;
+  return {{"bytes", double(src.size())},
+          {"tokens", double(tokens)},
+          {"lex_mb_s", mb / (lexMs / 1000.0)},
+          {"parse_mb_s", mb / (parseMs / 1000.0)},
+          {"ast_nodes", double(nodes)},
+          {"ast_bytes", double(bytes)}};
+}
+
+// Send the program's output to the null device while it runs.
+class DiscardStdout {
+public:
+  DiscardStdout() {
+    oong_rt_flush();
+#ifdef _WIN32
+    Saved = _dup(1);
+    int null = _open("NUL", _O_WRONLY);
+    _dup2(null, 1);
+    _close(null);
+#else
+    Saved = dup(1);
+    int null = open("/dev/null", O_WRONLY);
+    dup2(null, 1);
+    close(null);
+#endif
+  }
+  ~DiscardStdout() {
+    oong_rt_flush();
+#ifdef _WIN32
+    _dup2(Saved, 1);
+    _close(Saved);
+#else
+    dup2(Saved, 1);
+    close(Saved);
+#endif
+  }
+
+private:
+  int Saved;
+};
+
+// One end-to-end run, or an empty result after printing why it failed.
+static Metrics endToEnd(const std::string &src, unsigned optLevel) {
+  auto start = Clock::now();
+  Parser P(src);
+  auto R = P.parse();
+  const Program *prog = R.ok ? ast_cast<Program>(R.stmt) : nullptr;
+  if (!prog) { std::cerr << "parse error: " << R.error << "\n"; return {}; }
+  double parseMs = msSince(start);
+
+  start = Clock::now();
+  auto JOrErr = llvm::orc::LLJITBuilder().create();
+  if (!JOrErr) { llvm::logAllUnhandledErrors(JOrErr.takeError(), llvm::errs(), "LLJIT create failed: "); return {}; }
+  auto &J = **JOrErr;
+  if (add_runtime_symbols(J)) return {};
+  double setupMs = msSince(start);
+
+  start = Clock::now();
+  llvm::orc::ThreadSafeContext TSCtx(std::make_unique<llvm::LLVMContext>());
+  auto M = std::make_unique<llvm::Module>("oong_bench", *TSCtx.getContext());
+  M->setDataLayout(J.getDataLayout());
+  M->setTargetTriple(J.getTargetTriple().str());
+  std::string error;
+  if (!codegen_program(*prog, *M, "oong_main", src, error)) { std::cerr << "codegen error: " << error << "\n"; return {}; }
+  if (llvm::verifyModule(*M, &llvm::errs())) { std::cerr << "generated module is broken\n"; return {}; }
+  double codegenMs = msSince(start);
+  size_t instructions = M->getInstructionCount();
+
+  start = Clock::now();
+  optimize_module(*M, optLevel);
+  double optimizeMs = msSince(start);
+
+  start = Clock::now();
+  if (auto Err = J.addIRModule(llvm::orc::ThreadSafeModule(std::move(M), std::move(TSCtx))))
+  { llvm::logAllUnhandledErrors(std::move(Err), llvm::errs(), "add module: "); return {}; }
+  auto Addr = J.lookup("oong_main");
+  if (!Addr) { llvm::logAllUnhandledErrors(Addr.takeError(), llvm::errs(), "compile: "); return {}; }
+  double jitMs = setupMs + msSince(start);
+
+  int rc;
+  start = Clock::now();
+  {
+    DiscardStdout quiet;
+    using MainFnType = int();
+    rc = Addr->toPtr<MainFnType>()();
+  }
+  double executeMs = msSince(start);
+  if (rc != 0) { std::cerr << "program exited with " << rc << "\n"; return {}; }
+  return {{"ir_instructions", double(instructions)},
+          {"parse_ms", parseMs},
+          {"codegen_ms", codegenMs},
+          {"optimize_ms", optimizeMs},
+          {"jit_ms", jitMs},
+          {"execute_ms", executeMs}};
+}
+
+// Wall time of `node script.js` with output discarded, or a negative value if
+// it could not be run.
+static double nodeMs(const std::filesystem::path &script) {
+#ifdef _WIN32
+  std::string command = "node \"" + script.string() + "\" > NUL";
+#else
+  std::string command = "node \"" + script.string() + "\" > /dev/null";
+#endif
+  auto start = Clock::now();
+  return std::system(command.c_str()) == 0 ? msSince(start) : -1.0;
+}
+
+// Reads back what --json printed: the "name" of each benchmark line and the
+// numbers after it. Lenient on purpose; anything else on a line is skipped.
+static std::map<std::string, std::map<std::string, double>> readBaseline(std::istream &in) {
+  std::map<std::string, std::map<std::string, double>> out;
+  std::string line;
+  while (std::getline(in, line)) {
+    size_t at = line.find("\"name\": \"");
+    if (at == std::string::npos) continue;
+    at += 9;
+    size_t end = line.find('"', at);
+    auto &metrics = out[line.substr(at, end - at)];
+    for (size_t q = line.find('"', end + 1); q != std::string::npos; q = line.find('"', end + 1)) {
+      end = line.find('"', q + 1);
+      if (end == std::string::npos) break;
+      std::string key = line.substr(q + 1, end - q - 1);
+      char *stop;
+      double v = std::strtod(line.c_str() + end + 2, &stop);
+      if (stop != line.c_str() + end + 2) metrics[key] = v;
+    }
+  }
+  return out;
+}
+
+int main(int argc, char **argv) {
+  std::vector<std::filesystem::path> scripts;
+  unsigned optLevel = 2;
+  int rounds = 5;
+  bool json = false, node = false;
+  double threshold = 10;
+  std::string baselinePath;
+  for (int i = 1; i < argc; ++i) {
+    std::string a = argv[i];
+    if (a == "--json") json = true;
+    else if (a == "--node") node = true;
+    else if (a.rfind("--rounds=", 0) == 0) rounds = std::max(1, std::atoi(a.c_str() + 9));
+    else if (a.rfind("--baseline=", 0) == 0) baselinePath = a.substr(11);
+    else if (a.rfind("--threshold=", 0) == 0) threshold = std::atof(a.c_str() + 12);
+    else if (a.size() == 3 && a[0] == '-' && a[1] == 'O' && a[2] >= '0' && a[2] <= '3') optLevel = unsigned(a[2] - '0');
+    else if (a == "-h" || a == "--help") {
+      std::cout << "Usage: oong_bench [-O0|-O1|-O2|-O3] [--rounds=N] [--node] [--json] [--baseline=file.json] [--threshold=percent] [script.oo...]\n";
+      return 0;
+    }
+    else scripts.push_back(a);
+  }
+  if (scripts.empty()) {
+    std::error_code ec;
+    for (const auto &entry : std::filesystem::directory_iterator("example/bench", ec))
+      if (entry.path().extension() == ".oo") scripts.push_back(entry.path());
+    std::sort(scripts.begin(), scripts.end());
+    if (scripts.empty()) { std::cerr << "no scripts given and none in example/bench\n"; return 2; }
+  }
+
+  llvm::InitializeNativeTarget();
+  llvm::InitializeNativeTargetAsmPrinter();
+  llvm::InitializeNativeTargetAsmParser();
+
+  std::vector<std::pair<std::string, Metrics>> results;
+  for (const auto &path : scripts) {
+    std::ifstream in(path, std::ios::binary);
+    if (!in) { std::cerr << "failed to open " << path.string() << "\n"; return 2; }
+    std::ostringstream ss; ss << in.rdbuf();
+    std::string src = ss.str();
+
+    Metrics best;
+    for (int r = 0; r < rounds; ++r) {
+      Metrics run = frontEnd(src);
+      Metrics e2e = endToEnd(src, optLevel);
+      if (e2e.empty()) { std::cerr << "in " << path.string() << "\n"; return 1; }
+      run.insert(run.end(), e2e.begin(), e2e.end());
+      std::filesystem::path twin = std::filesystem::path(path).replace_extension(".js");
+      if (node && std::filesystem::exists(twin)) run.emplace_back("node_ms", nodeMs(twin));
+      keepBest(best, run);
+    }
+    results.emplace_back(path.stem().string(), std::move(best));
+  }
+
+  if (json) {
+    std::cout << "{\n  \"opt_level\": " << optLevel << ",\n  \"rounds\": " << rounds << ",\n  \"benchmarks\": [\n";
+    for (size_t i = 0; i < results.size(); ++i) {
+      std::cout << "    {\"name\": \"" << results[i].first << "\"";
+      for (const auto &m : results[i].second) std::cout << ", \"" << m.first << "\": " << m.second;
+      std::cout << "}" << (i + 1 < results.size() ? "," : "") << "\n";
+    }
+    std::cout << "  ]\n}\n";
+  } else {
+    for (const auto &r : results) {
+      std::cout << r.first << "\n";
+      for (const auto &m : r.second) std::cout << "  " << m.first << ": " << m.second << "\n";
+    }
+  }
+
+  if (baselinePath.empty()) return 0;
+  if (!std::filesystem::exists(baselinePath)) {
+    std::cerr << "no baseline at " << baselinePath << "; skipping the comparison (save one with --json > "
+              << baselinePath << ")\n";
+    return 0;
+  }
+  std::ifstream in(baselinePath);
+  if (!in) { std::cerr << "failed to open " << baselinePath << "\n"; return 2; }
+  auto baseline = readBaseline(in);
+  int regressions = 0;
+  for (const auto &r : results) {
+    auto old = baseline.find(r.first);
+    if (old == baseline.end()) continue;
+    for (const auto &m : r.second) {
+      auto was = old->second.find(m.first);
+      bool time = m.first.size() > 3 && m.first.compare(m.first.size() - 3, 3, "_ms") == 0;
+      bool rate = m.first.size() > 5 && m.first.compare(m.first.size() - 5, 5, "_mb_s") == 0;
+      if (was == old->second.end() || was->second <= 0 || m.second < 0 || !(time || rate)) continue;
+      double change = (m.second / was->second - 1) * 100;
+      if (time ? change > threshold : -change > threshold) {
+        std::cerr << "regression: " << r.first << " " << m.first << " " << was->second << " -> " << m.second
+                  << " (" << (change > 0 ? "+" : "") << change << "%)\n";
+        ++regressions;
+      }
+    }
+  }
+  return regressions ? 1 : 0;
+}
@@ -1,11 +1,16 @@
 #include <iostream>
 #include <fstream>
 #include <sstream>
-#include "../src/parser.h"
+#include "parser.h"
 
 int main(int argc, char **argv) {
   std::string path = "tests/test_smoke.oo";
-  if (argc > 1) path = argv[1];
+  bool memo = false; // --memo: enable parser memoization and print its counters
+  for (int i = 1; i < argc; ++i) {
+    std::string a = argv[i];
+    if (a == "--memo") memo = true;
+    else path = a;
+  }
   std::ifstream in(path);
   if (!in) { std::cerr << "failed to open " << path << "\n"; return 2; }
   std::ostringstream ss; ss << in.rdbuf();
@@ -31,7 +36,15 @@ int main(int argc, char **argv) {
   }
 
   Parser p(src);
+  p.setMemoize(memo);
   auto res = p.parse();
+  if (memo) {
+    const auto &stats = p.memoStats();
+    std::cout << "memo hits/misses:\n";
+    for (size_t r = 0; r < size_t(Parser::MemoRule::Count); ++r)
+      std::cout << "  " << Parser::memoRuleName(Parser::MemoRule(r)) << ": " << stats.Hits[r] << "/"
+                << stats.Misses[r] << "\n";
+  }
   if (res.ok) {
     std::cout << "Parse OK\n";
     return 0;